@@ -8,6 +8,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <time.h>
 
 void bgm_startstop(const unsigned char play)
 {
@@ -20,12 +22,171 @@ void bgm_startstop(const unsigned char play)
 }
 
 void play_sfx(const unsigned char audio_num)
+{
+  play_sfx_rate(audio_num, 0);
+}
+
+void play_sfx_rate(const unsigned char audio_num, unsigned short rate)
 {
   fpga_audio_arg_t vla;
   vla.play = audio_num;
+  vla.rate = rate;
   if (ioctl(audio_fd, FPGA_AUDIO_SET_AUDIO_ADDR, &vla)) {
       perror("ioctl(FPGA_AUDIO_SET_AUDIO_ADDR) failed");
       return;
   }
 }
 
+void seq_play(const unsigned char play)
+{
+  fpga_audio_arg_t vla;
+  vla.play = play;
+  if (ioctl(audio_fd, FPGA_AUDIO_SEQ_PLAY, &vla)) {
+      perror("ioctl(FPGA_AUDIO_SEQ_PLAY) failed");
+      return;
+  }
+}
+
+void seq_tempo(unsigned int samples_per_row)
+{
+  if (ioctl(audio_fd, FPGA_AUDIO_SEQ_TEMPO, &samples_per_row)) {
+      perror("ioctl(FPGA_AUDIO_SEQ_TEMPO) failed");
+      return;
+  }
+}
+
+int bgm_on_sequencer(void)
+{
+  char c = 'N';
+  FILE *f = fopen("/sys/module/fpga_audio/parameters/bgm_seq", "r");
+  if (f == NULL)
+    return 0;
+  if (fread(&c, 1, 1, f) != 1)
+    c = 'N';
+  fclose(f);
+  return c == 'Y' || c == '1';
+}
+
+static void set_voice(unsigned char voice, unsigned char sound, unsigned char volume,
+                      unsigned char loop, unsigned char play, unsigned short rate)
+{
+  fpga_audio_voice_t vlv;
+  vlv.rate = rate;
+  vlv.voice = voice;
+  vlv.sound = sound;
+  vlv.volume = volume;
+  vlv.loop = loop;
+  vlv.play = play;
+  if (ioctl(audio_fd, FPGA_AUDIO_PLAY_VOICE, &vlv)) {
+      perror("ioctl(FPGA_AUDIO_PLAY_VOICE) failed");
+      return;
+  }
+}
+
+void play_voice(unsigned char voice, unsigned char sound, unsigned char volume, unsigned char loop,
+                unsigned short rate)
+{
+  set_voice(voice, sound, volume, loop, 1, rate);
+}
+
+void stop_voice(unsigned char voice)
+{
+  set_voice(voice, 0, 0, 0, 0, 0);
+}
+
+unsigned int voices_playing(void)
+{
+  unsigned int mask;
+  if (ioctl(audio_fd, FPGA_AUDIO_VOICES_PLAYING, &mask)) {
+      perror("ioctl(FPGA_AUDIO_VOICES_PLAYING) failed");
+      return 0;
+  }
+  return mask;
+}
+
+int get_audio_status(fpga_audio_status_t *st)
+{
+  if (ioctl(audio_fd, FPGA_AUDIO_GET_STATUS, st)) {
+      perror("ioctl(FPGA_AUDIO_GET_STATUS) failed");
+      return -1;
+  }
+  return 0;
+}
+
+int wait_sfx_done(int timeout_ms)
+{
+  struct pollfd pfd = { .fd = audio_fd, .events = POLLIN };
+  struct timespec start, now;
+  fpga_audio_status_t st;
+  int elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (;;) {
+    if (get_audio_status(&st))
+      return -1;
+    if ((st.playing & ~1u) == 0) // voice 0 is the bgm
+      return 0;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+    if (elapsed >= timeout_ms)
+      return 1;
+    poll(&pfd, 1, timeout_ms - elapsed); // woken when a voice ends
+  }
+}
+
+// sound effects of the frame being built, sent by submit_sfx()
+static fpga_audio_sfx_t sfx_batch[FPGA_AUDIO_SFX_BATCH];
+static unsigned int sfx_count;
+
+void queue_sfx(unsigned char audio_num, unsigned short rate, unsigned int delay_us)
+{
+  if (sfx_count == FPGA_AUDIO_SFX_BATCH) {
+    play_sfx_rate(audio_num, rate); // more than a frame can use, play it now
+    return;
+  }
+  sfx_batch[sfx_count].sound = audio_num;
+  sfx_batch[sfx_count].rate = rate;
+  sfx_batch[sfx_count].delay_us = delay_us;
+  sfx_count++;
+}
+
+void submit_sfx(unsigned int delay_us)
+{
+  fpga_audio_sfx_batch_t vlb;
+  unsigned int i;
+  if (sfx_count == 0)
+    return;
+  for (i = 0; i < sfx_count; i++)
+    sfx_batch[i].delay_us += delay_us;
+  vlb.count = sfx_count;
+  vlb.sfx = sfx_batch;
+  sfx_count = 0;
+  if (ioctl(audio_fd, FPGA_AUDIO_QUEUE_SFX, &vlb)) {
+      perror("ioctl(FPGA_AUDIO_QUEUE_SFX) failed");
+      return;
+  }
+}
+
+int stream_pcm(const short *samples, unsigned int count)
+{
+  size_t left = count * sizeof(short);
+  const char *p = (const char *) samples;
+  while (left > 0) {
+    ssize_t n = write(audio_fd, p, left);
+    if (n < 0) {
+      perror("write(fpga_audio) failed");
+      return -1;
+    }
+    p += n;
+    left -= n;
+  }
+  return 0;
+}
+
+void stream_stop(void)
+{
+  if (ioctl(audio_fd, FPGA_AUDIO_STREAM_STOP)) {
+      perror("ioctl(FPGA_AUDIO_STREAM_STOP) failed");
+      return;
+  }
+}
@@ -1,6 +1,46 @@
+#include "fpga_audio.h"
+
 extern int audio_fd; // vga file descriptor, define in main file
 
 
 void bgm_startstop(const unsigned char play);
 
 void play_sfx(const unsigned char audio_num);
+
+/* Play a sound effect at rate/FPGA_AUDIO_RATE_1X of its recorded pitch */
+void play_sfx_rate(const unsigned char audio_num, unsigned short rate);
+
+/* Start the music sequencer from the top of its song, or stop it */
+void seq_play(const unsigned char play);
+
+/* Samples per row of the song; smaller is faster */
+void seq_tempo(unsigned int samples_per_row);
+
+/* 1 if the driver plays the background music on the sequencer (its bgm_seq parameter) */
+int bgm_on_sequencer(void);
+
+/* Play a sound on one voice of the mixer, over whatever it was playing */
+void play_voice(unsigned char voice, unsigned char sound, unsigned char volume, unsigned char loop,
+                unsigned short rate);
+
+void stop_voice(unsigned char voice);
+
+/* Bit n set while voice n is playing */
+unsigned int voices_playing(void);
+
+/* Voice state and the voices that ended since the last call */
+int get_audio_status(fpga_audio_status_t *st);
+
+/* Wait until no sound effect is playing, at most timeout_ms; 1 on timeout */
+int wait_sfx_done(int timeout_ms);
+
+/* Collect a sound effect to start delay_us after the next submit_sfx(); rate 0 is the recorded pitch */
+void queue_sfx(unsigned char audio_num, unsigned short rate, unsigned int delay_us);
+
+/* Hand the collected sound effects to the driver in one ioctl, all delay_us later */
+void submit_sfx(unsigned int delay_us);
+
+/* Queue signed 16-bit mono samples at FPGA_AUDIO_RATE; blocks while the driver is full */
+int stream_pcm(const short *samples, unsigned int count);
+
+void stream_stop(void);
@@ -5,6 +5,7 @@
 #include <pthread.h>
 #include <time.h>
 #include <fcntl.h>
+#include <string.h>
 #include "usbcontroller.h"
 #include "vga_interface.h"
 #include "audio_interface.h"
@@ -17,11 +18,19 @@
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #define WALL 16
 #define HVEC 8
+#define SONG_TEMPO 800 // samples per row of the sequencer song at level 0
+#define SONG_TEMPO_STEP 50 // each level plays the music a little faster
+#define SONG_TEMPO_MIN 400 // up to twice the level 0 speed, from level 8 on
 int level = 0;
 int numEnemy = MAX_ENEMIES;
 int numOfReward = 0;
 int grade = 0;
 int life = 3;
+int combo = 0; // rewards picked up since the level started or the player was hit
+
+// the reward sound goes up a semitone per combo, an octave at most
+static const unsigned short combo_rate[13] = {
+    256, 271, 287, 304, 323, 342, 362, 384, 406, 431, 456, 483, 512};
 bool restart = true;
 int vga_fd;
 int audio_fd;
@@ -118,10 +127,10 @@ void initEnemy(Enemy *enemy, int reg, Wall wall[])
     enemy->facingRight = true;
     enemy->type = rand() % 2;
     enemy->reg = reg;
-    enemy->enemyARight = 14;
-    enemy->enemyALeft = 16;
-    enemy->enemyBRight = 21;
-    enemy->enemyBLeft = 23;
+    enemy->enemyARight = 10;
+    enemy->enemyALeft = 10; // the right frames, flipped
+    enemy->enemyBRight = 15;
+    enemy->enemyBLeft = 15;
 }
 void initReward(Reward *reward, int x, int y, int reg)
 {
@@ -133,7 +142,7 @@ void initReward(Reward *reward, int x, int y, int reg)
     reward->active = true;
     reward->onTheFloor = false;
     reward->reg = reg;
-    reward->seq = rand() % 4 + 26;
+    reward->seq = rand() % 4 + 18;
 }
 
 void initBubble(Bubble *bubble, int x, int y, int bubbleSequence)
@@ -420,7 +429,8 @@ void handleCollisionCharcterReward(Character *character, Reward *reward)
         {
             if (reward[i].active)
             {
-                play_sfx(2);
+                queue_sfx(2, combo_rate[MIN(combo, 12)], 0);
+                combo++;
                 reward[i].active = false;
                 write_sprite_to_kernel(0, 0, 0, 0, reward[i].reg);
                 numOfReward--;
@@ -455,18 +465,20 @@ void handleCollisionCharcterEnemy(Character *character, Enemy *enemies, int numE
             {
                 if (character->active)
                 {
-                    play_sfx(0);
+                    queue_sfx(0, 0, 0);
+                    combo = 0;
                     character->active = false;
                     life--;
                     if (life == 0)
                     {
+                        submit_sfx(0); // the game stops here, play it now
                         bgm_startstop(0);
                         write_tile_to_kernel(1, 6, 1);
                         clearSprites();
                         write_sprite_to_kernel(1, character->y, character->x, 1, 11);
                         sleep(1);
                         write_sprite_to_kernel(1, character->y, character->x, 2, 11);
-                        sleep(1);
+                        wait_sfx_done(1000);
                         return;
                     }
                     initCharacter(character);
@@ -480,13 +492,17 @@ void handleCollisionCharcterEnemy(Character *character, Enemy *enemies, int numE
 void loadNextLevel(Character *character, Enemy *enemies, Wall *walls)
 {
     level++;
+    combo = 0;
     play_sfx(1);
+    if (bgm_on_sequencer()) // the clip from the sample rom has a fixed tempo
+        seq_tempo(level < (SONG_TEMPO - SONG_TEMPO_MIN) / SONG_TEMPO_STEP ?
+                  SONG_TEMPO - level * SONG_TEMPO_STEP : SONG_TEMPO_MIN);
     clearSprites();
     write_text("next", 4, 14, 15);
     write_text("level", 5, 14, 20);
     character->x = 64;
     character->y = WIDTH - character->height - 16;
-    sleep(2);
+    wait_sfx_done(2000); // until the jingle ends
     fill_sky_and_grass();
     switch (level)
     {
@@ -693,6 +709,31 @@ bool press()
     return false;
 }
 
+// draw every wall tile of a level with a single batched tile write
+void drawWalls(Wall walls[], int numWalls, int wallSequence)
+{
+    vga_top_arg_t tiles[ROWS * COLS];
+    unsigned int count = 0;
+    for (int i = 0; i < numWalls; ++i)
+    {
+        if (walls[i].width > walls[i].height)
+        {
+            for (int k = walls[i].x; k < walls[i].width + walls[i].x; k += 16)
+            {
+                tiles[count++] = (vga_top_arg_t){walls[i].y / 16, k / 16, wallSequence};
+            }
+        }
+        else
+        {
+            for (int k = walls[i].y; k < walls[i].height + walls[i].y; k += 16)
+            {
+                tiles[count++] = (vga_top_arg_t){k / 16, walls[i].x / 16, wallSequence};
+            }
+        }
+    }
+    write_tiles_to_kernel(tiles, count);
+}
+
 int main(int argc, char *argv[])
 {
     static const char filename[] = "/dev/vga_top";
@@ -701,6 +742,14 @@ int main(int argc, char *argv[])
         fprintf(stderr, "could not open %s\n", filename);
         return -1;
     }
+    // VGA_BACKEND=mmio stores straight to the registers, otherwise tiles go
+    // through the shadow page; either falls back to ioctls on failure
+    const char *backend = getenv("VGA_BACKEND");
+    if (backend && strcmp(backend, "mmio") == 0)
+        vga_mmio_init();
+    else
+        vga_shadow_init();
+    vga_sprite_latch(1); // each frame's sprites go on screen together, no tearing
     static const char filename1[] = "/dev/fpga_audio";
     if ((audio_fd = open(filename1, O_RDWR)) == -1)
     {
@@ -727,8 +776,8 @@ int main(int argc, char *argv[])
         write_text("to", 2, 19, index + 14);
         write_text("start", 5, 19, index + 17);
         int characterLeftSequence = 3;
-        int characterRightSequence = 7;
-        int enemyS = 14;
+        int characterRightSequence = 3;
+        int enemyS = 10;
         bool initialMove = true;
         while (true)
         {
@@ -736,11 +785,11 @@ int main(int argc, char *argv[])
             {
                 write_sprite_to_kernel(1, 448, i, characterRightSequence, 11);
                 characterRightSequence++;
-                write_sprite_to_kernel(1, 448, i - 140, enemyS, 0); // 14-15
-                enemyS = (enemyS == 14) ? 15 : 14;
-                if (characterRightSequence == 11)
+                write_sprite_to_kernel(1, 448, i - 140, enemyS, 0); // 10-11
+                enemyS = (enemyS == 10) ? 11 : 10;
+                if (characterRightSequence == 7)
                 {
-                    characterRightSequence = 7;
+                    characterRightSequence = 3;
                 }
 
                 if (press())
@@ -793,37 +842,16 @@ int main(int argc, char *argv[])
         Reward reward[MAX_ENEMIES];
         // draw wall;   37-44
         int wallSequence = 37;
-        for (int i = 0; i < sizeof(walls) / sizeof(walls[0]); ++i)
-        {
-            if (walls[i].width > walls[i].height)
-            {
-                for (int k = walls[i].x; k < walls[i].width + walls[i].x; k += 16)
-                {
-                    write_tile_to_kernel(walls[i].y / 16, k / 16, wallSequence);
-                }
-            }
-            else
-            {
-                for (int k = walls[i].y; k < walls[i].height + walls[i].y; k += 16)
-                {
-                    write_tile_to_kernel(k / 16, walls[i].x / 16, wallSequence);
-                }
-            }
-        }
+        drawWalls(walls, sizeof(walls) / sizeof(walls[0]), wallSequence);
         write_tile_to_kernel(1, 20, 1);
         while (true)
         {
             write_text("level", 5, 1, 30);
-            write_tile_to_kernel(1, 36, level + 1);
-            write_tile_to_kernel(1, 4, 45);
-            write_tile_to_kernel(1, 5, 34);
-            write_tile_to_kernel(1, 6, life + 1);
-            write_tile_to_kernel(1, 11, 29);
-            write_tile_to_kernel(1, 12, 13);
-            write_tile_to_kernel(1, 13, 25);
-            write_tile_to_kernel(1, 14, 28);
-            write_tile_to_kernel(1, 15, 15);
-            write_tile_to_kernel(1, 16, 29);
+            // level number, lives and score label in one ioctl
+            vga_top_arg_t hud[] = {
+                {1, 36, level + 1}, {1, 4, 45}, {1, 5, 34}, {1, 6, life + 1},
+                {1, 11, 29}, {1, 12, 13}, {1, 13, 25}, {1, 14, 28}, {1, 15, 15}, {1, 16, 29}};
+            write_tiles_to_kernel(hud, sizeof(hud) / sizeof(hud[0]));
             if (numEnemy == 0 && numOfReward == 0)
             {
                 // draw wall; 37-44
@@ -834,23 +862,7 @@ int main(int argc, char *argv[])
                     break;
                 }
                 loadNextLevel(&character, enemies, walls);
-                for (int i = 0; i < sizeof(walls) / sizeof(walls[0]); ++i)
-                {
-                    if (walls[i].width > walls[i].height)
-                    {
-                        for (int k = walls[i].x; k < walls[i].width + walls[i].x; k += 16)
-                        {
-                            write_tile_to_kernel(walls[i].y / 16, k / 16, wallSequence);
-                        }
-                    }
-                    else
-                    {
-                        for (int k = walls[i].y; k < walls[i].height + walls[i].y; k += 16)
-                        {
-                            write_tile_to_kernel(k / 16, walls[i].x / 16, wallSequence);
-                        }
-                    }
-                }
+                drawWalls(walls, sizeof(walls) / sizeof(walls[0]), wallSequence);
             }
 
             if (controller_state.leftright == 1)
@@ -939,19 +951,21 @@ int main(int argc, char *argv[])
             }
             handleCollisionCharcterReward(&character, reward);
 
+            // everything drawn from here on goes out as one display list
+            frame_begin();
             if (character.facingRight)
             {
                 if (character.vx == 0)
                 {
-                    write_sprite_to_kernel(1, character.y, character.x, 7, 11);
+                    write_sprite_to_kernel(1, character.y, character.x, 3, 11);
                 }
                 else
                 {
                     write_sprite_to_kernel(1, character.y, character.x, characterRightSequence, 11);
                     characterRightSequence++;
-                    if (characterRightSequence == 11)
+                    if (characterRightSequence == 7)
                     {
-                        characterRightSequence = 7;
+                        characterRightSequence = 3;
                     }
                 }
             }
@@ -959,11 +973,12 @@ int main(int argc, char *argv[])
             {
                 if (character.vx == 0)
                 {
-                    write_sprite_to_kernel(1, character.y, character.x, 3, 11);
+                    write_sprite_flip_to_kernel(1, character.y, character.x, 3, 11, VGA_SPRITE_FLIP_H);
                 }
                 else
                 {
-                    write_sprite_to_kernel(1, character.y, character.x, characterLeftSequence, 11);
+                    // facing left is the right facing walk mirrored by the hardware
+                    write_sprite_flip_to_kernel(1, character.y, character.x, characterLeftSequence, 11, VGA_SPRITE_FLIP_H);
                     characterLeftSequence++;
                     if (characterLeftSequence == 7)
                     {
@@ -977,7 +992,7 @@ int main(int argc, char *argv[])
                 if (enemies[i].surrounded)
                 {
                     // draw surrounded bubble
-                    write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, 13, enemies[i].reg);
+                    write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, 9, enemies[i].reg);
                 }
                 // draw enemy
                 else
@@ -987,12 +1002,12 @@ int main(int argc, char *argv[])
                         if (enemies[i].facingRight)
                         {
                             write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyARight, enemies[i].reg);
-                            enemies[i].enemyARight = (enemies[i].enemyARight == 14) ? 15 : 14;
+                            enemies[i].enemyARight = (enemies[i].enemyARight == 10) ? 11 : 10;
                         }
                         else
                         {
-                            write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyALeft, enemies[i].reg);
-                            enemies[i].enemyALeft = (enemies[i].enemyALeft == 16) ? 17 : 16;
+                            write_sprite_flip_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyALeft, enemies[i].reg, VGA_SPRITE_FLIP_H);
+                            enemies[i].enemyALeft = (enemies[i].enemyALeft == 10) ? 11 : 10;
                         }
                     }
                     else
@@ -1000,12 +1015,12 @@ int main(int argc, char *argv[])
                         if (enemies[i].facingRight)
                         {
                             write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyBRight, enemies[i].reg);
-                            enemies[i].enemyBRight = (enemies[i].enemyBRight == 21) ? 22 : 21;
+                            enemies[i].enemyBRight = (enemies[i].enemyBRight == 15) ? 16 : 15;
                         }
                         else
                         {
-                            write_sprite_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyBLeft, enemies[i].reg);
-                            enemies[i].enemyBLeft = (enemies[i].enemyBLeft == 23) ? 24 : 23;
+                            write_sprite_flip_to_kernel(1, enemies[i].y, enemies[i].x, enemies[i].enemyBLeft, enemies[i].reg, VGA_SPRITE_FLIP_H);
+                            enemies[i].enemyBLeft = (enemies[i].enemyBLeft == 15) ? 16 : 15;
                         }
                     }
                 }
@@ -1028,7 +1043,9 @@ int main(int argc, char *argv[])
                     write_sprite_to_kernel(1, reward[i].y, reward[i].x, reward[i].seq, reward[i].reg);
                 }
             }
-            usleep(50000);
+            frame_submit();
+            submit_sfx(us_to_vblank()); // heard when the frame shows up
+            wait_vblank(3); // ~20 fps, in step with the 59.5 Hz display
         }
         fill_sky_and_grass();
         clearSprites();
@@ -1074,6 +1091,9 @@ int main(int argc, char *argv[])
             break;
         }
         level = 0;
+        combo = 0;
+        if (bgm_on_sequencer())
+            seq_tempo(SONG_TEMPO);
         numEnemy = MAX_ENEMIES;
         numOfReward = 0;
         grade = 0;
@@ -8,12 +8,184 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// shadow tilemap shared with the driver, NULL until vga_shadow_init() succeeds
+static vga_top_shadow_t *shadow;
+
+// map the driver's shadow tilemap; from then on tile writes are plain stores
+// and the driver pushes the changed cells to the screen once per frame
+int vga_shadow_init(void)
+{
+  void *p = mmap(NULL, sizeof(vga_top_shadow_t), PROT_READ | PROT_WRITE, MAP_SHARED, vga_fd, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap(/dev/vga_top) failed, using ioctls for tiles");
+    return -1;
+  }
+  shadow = p;
+  return 0;
+}
+
+// registers mapped from the driver, NULL until vga_mmio_init() succeeds
+static volatile unsigned int *regs;
+
+// map the registers themselves; from then on every tile and sprite write is
+// a single store with no syscall, and the shadow and frame builder are unused
+int vga_mmio_init(void)
+{
+  unsigned int offset;
+  long page = sysconf(_SC_PAGESIZE);
+  void *p;
+  if (ioctl(vga_fd, VGA_TOP_REGS_OFFSET, &offset)) {
+    perror("ioctl(VGA_TOP_REGS_OFFSET) failed, keeping the current backend");
+    return -1;
+  }
+  p = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_SHARED, vga_fd, VGA_TOP_MMAP_REGS * page);
+  if (p == MAP_FAILED) {
+    perror("mmap(/dev/vga_top) registers failed, keeping the current backend");
+    return -1;
+  }
+  regs = (volatile unsigned int *) ((char *) p + offset);
+  return 0;
+}
+
+// sprite latch mode: sprite writes only reach the screen on a commit
+static int sprite_latch;
+
+// turn sprite latching on or off; while on, every sprite change made in a
+// frame shows up together at the vblank after frame_submit()
+void vga_sprite_latch(int on)
+{
+  if (regs) {
+    regs[VGA_REG_SPRITE_CTRL] = on ? 1 : 0;
+    sprite_latch = on;
+    return;
+  }
+  if (ioctl(vga_fd, VGA_TOP_SPRITE_LATCH, on)) {
+    perror("ioctl(VGA_TOP_SPRITE_LATCH) failed");
+    return;
+  }
+  sprite_latch = on;
+}
+
+void vga_commit(void)
+{
+  if (regs) {
+    regs[VGA_REG_SPRITE_COMMIT] = 1;
+    return;
+  }
+  if (ioctl(vga_fd, VGA_TOP_COMMIT)) {
+    perror("ioctl(VGA_TOP_COMMIT) failed");
+  }
+}
+
+// display list being built for this frame, see frame_begin()
+static unsigned char frame_buf[VGA_DL_MAX];
+static unsigned int frame_len;
+static int frame_open;
+
+// start recording: until frame_submit(), tile and sprite writes are appended
+// to one display list instead of going to the driver one by one
+void frame_begin(void)
+{
+  frame_len = 0;
+  frame_open = 1;
+}
+
+static void frame_flush(void)
+{
+  unsigned int pos = 0;
+  while (pos < frame_len) {
+    ssize_t n = write(vga_fd, frame_buf + pos, frame_len - pos);
+    if (n <= 0) {
+      perror("write(/dev/vga_top) display list failed");
+      break;
+    }
+    pos += n;
+  }
+  frame_len = 0;
+}
+
+static void frame_append(const void *cmd, unsigned int size)
+{
+  if (frame_len + size > sizeof(frame_buf))
+    frame_flush();
+  memcpy(frame_buf + frame_len, cmd, size);
+  frame_len += size;
+}
+
+// send everything recorded since frame_begin() with a single write()
+void frame_submit(void)
+{
+  if (regs) {
+    // everything has been stored already
+    if (sprite_latch)
+      vga_commit();
+    frame_open = 0;
+    return;
+  }
+  if (sprite_latch) {
+    vga_dl_commit cmd = {VGA_DL_COMMIT};
+    frame_append(&cmd, sizeof(cmd));
+  }
+  frame_flush();
+  frame_open = 0;
+}
+
+void frame_tile(unsigned char r, unsigned char c, unsigned char n)
+{
+  vga_dl_tile cmd = {VGA_DL_TILE, r, c, n};
+  frame_append(&cmd, sizeof(cmd));
+}
+
+void frame_tile_fill(unsigned char r, unsigned char c, unsigned char rows, unsigned char cols, unsigned char n)
+{
+  vga_dl_tile_fill cmd = {VGA_DL_TILE_FILL, r, c, rows, cols, n};
+  frame_append(&cmd, sizeof(cmd));
+}
+
+void frame_sprite(unsigned short r, unsigned short c, unsigned char n, unsigned short register_n, unsigned char flip)
+{
+  vga_dl_sprite cmd = {VGA_DL_SPRITE, register_n, r, c, n, flip};
+  frame_append(&cmd, sizeof(cmd));
+}
+
+void frame_sprite_hide(unsigned short register_n)
+{
+  vga_dl_sprite_hide cmd = {VGA_DL_SPRITE_HIDE, register_n};
+  frame_append(&cmd, sizeof(cmd));
+}
+
+void frame_palette(unsigned char entry, unsigned short colour)
+{
+  vga_dl_palette cmd = {VGA_DL_PALETTE, entry, colour};
+  frame_append(&cmd, sizeof(cmd));
+}
+
+static void shadow_mark_rows(unsigned char r, unsigned char rows)
+{
+  __atomic_fetch_or(&shadow->dirty_rows, ((1u << rows) - 1) << r, __ATOMIC_RELEASE);
+}
 
 
 // r*c: 40*30       r:0-29      c:0-39
 // n means image number, number of the image stored in memory
 void write_tile_to_kernel(unsigned char r, unsigned char c, unsigned char n) 
 {
+  if (regs) {
+    regs[VGA_REG_TILE] = VGA_TILE_WORD(r, c, n);
+    return;
+  }
+  if (shadow) {
+    shadow->tiles[r][c] = n;
+    shadow_mark_rows(r, 1);
+    return;
+  }
+  if (frame_open) {
+    frame_tile(r, c, n);
+    return;
+  }
   vga_top_arg_t vla;
   vla.r = r;
   vla.c = c;
@@ -24,6 +196,137 @@ void write_tile_to_kernel(unsigned char r, unsigned char c, unsigned char n)
   }
 }
 
+// write count tiles with a single ioctl, tiles can be anywhere on the grid
+void write_tiles_to_kernel(vga_top_arg_t *tiles, unsigned int count)
+{
+  if (regs) {
+    for (unsigned int i = 0; i < count; i++)
+      regs[VGA_REG_TILE] = VGA_TILE_WORD(tiles[i].r, tiles[i].c, tiles[i].n);
+    return;
+  }
+  if (shadow) {
+    unsigned int dirty = 0;
+    for (unsigned int i = 0; i < count; i++) {
+      shadow->tiles[tiles[i].r][tiles[i].c] = tiles[i].n;
+      dirty |= 1u << tiles[i].r;
+    }
+    __atomic_fetch_or(&shadow->dirty_rows, dirty, __ATOMIC_RELEASE);
+    return;
+  }
+  if (frame_open) {
+    for (unsigned int i = 0; i < count; i++)
+      frame_tile(tiles[i].r, tiles[i].c, tiles[i].n);
+    return;
+  }
+  vga_top_arg_tiles vla;
+  vla.tiles = tiles;
+  vla.count = count;
+  if (ioctl(vga_fd, VGA_TOP_WRITE_TILES, &vla)) {
+    perror("ioctl(VGA_TOP_WRITE_TILES) failed");
+    return;
+  }
+}
+
+// set count palette entries from first on, e.g. a different sky with the
+// same tiles; the driver applies them at the next vblank
+void write_palette_to_kernel(unsigned char first, unsigned int count, unsigned short *colours)
+{
+  if (regs) {
+    for (unsigned int i = 0; i < count; i++)
+      regs[VGA_REG_PALETTE] = VGA_PALETTE_WORD(first + i, colours[i]);
+    return;
+  }
+  if (frame_open) {
+    for (unsigned int i = 0; i < count; i++)
+      frame_palette(first + i, colours[i]);
+    return;
+  }
+  vga_top_arg_palette vla;
+  vla.colours = colours;
+  vla.first = first;
+  vla.count = count;
+  if (ioctl(vga_fd, VGA_TOP_WRITE_PALETTE, &vla)) {
+    perror("ioctl(VGA_TOP_WRITE_PALETTE) failed");
+    return;
+  }
+}
+
+// write a rows*cols block of tiles starting at (r, c) with a single ioctl
+// n holds the image numbers row by row
+void write_tile_rect_to_kernel(unsigned char r, unsigned char c, unsigned char rows, unsigned char cols, unsigned char *n)
+{
+  if (regs) {
+    for (unsigned char i = 0; i < rows; i++)
+      for (unsigned char j = 0; j < cols; j++)
+        regs[VGA_REG_TILE] = VGA_TILE_WORD(r + i, c + j, n[i * cols + j]);
+    return;
+  }
+  if (shadow) {
+    for (unsigned char i = 0; i < rows; i++)
+      memcpy(&shadow->tiles[r + i][c], n + i * cols, cols);
+    shadow_mark_rows(r, rows);
+    return;
+  }
+  if (frame_open) {
+    for (unsigned char i = 0; i < rows; i++)
+      for (unsigned char j = 0; j < cols; j++)
+        frame_tile(r + i, c + j, n[i * cols + j]);
+    return;
+  }
+  if (rows == VGA_TILE_ROWS && cols == VGA_TILE_COLS) {
+    // the whole screen: one DMA transfer instead of 1200 register writes
+    vga_top_frame_t frame;
+    memcpy(frame.tiles, n, sizeof(frame.tiles));
+    write_frame_to_kernel(&frame, VGA_FRAME_TILES);
+    return;
+  }
+  vga_top_arg_rect vla;
+  vla.r = r;
+  vla.c = c;
+  vla.rows = rows;
+  vla.cols = cols;
+  vla.n = n;
+  if (ioctl(vga_fd, VGA_TOP_WRITE_TILE_RECT, &vla)) {
+    perror("ioctl(VGA_TOP_WRITE_TILE_RECT) failed");
+    return;
+  }
+}
+
+// replace the whole screen (tiles, sprites or both) at the next vblank; the
+// hardware fetches it from memory, so this costs one ioctl
+void write_frame_to_kernel(vga_top_frame_t *frame, unsigned int parts)
+{
+  vga_top_arg_frame vla;
+  if (regs) {
+    // the driver can't DMA while the registers are mapped, store it all
+    if (parts & VGA_FRAME_TILES)
+      write_tile_rect_to_kernel(0, 0, VGA_TILE_ROWS, VGA_TILE_COLS, &frame->tiles[0][0]);
+    if (parts & VGA_FRAME_SPRITES) {
+      for (unsigned int i = 0; i < VGA_NUM_SPRITES; i++)
+        regs[VGA_REG_SPRITE(i)] = frame->sprites[i];
+      if (sprite_latch)
+        vga_commit();
+    }
+    return;
+  }
+  if (shadow && (parts & VGA_FRAME_TILES)) {
+    // keep the shadow in step, its flush goes through the same DMA
+    memcpy(shadow->tiles, frame->tiles, sizeof(frame->tiles));
+    shadow_mark_rows(0, VGA_TILE_ROWS);
+    parts &= ~VGA_FRAME_TILES;
+    if (!parts)
+      return;
+  }
+  vla.frame = frame;
+  vla.parts = parts;
+  if (ioctl(vga_fd, VGA_TOP_WRITE_FRAME, &vla)) {
+    perror("ioctl(VGA_TOP_WRITE_FRAME) failed");
+    return;
+  }
+  if ((parts & VGA_FRAME_SPRITES) && sprite_latch)
+    vga_commit();
+}
+
 // sprite r and c is pixel, r range is 0 - 639, c range is 0-479
 void write_sprite_to_kernel(unsigned char active,   //active == 1, display, active == 0 not display
                             unsigned short r,
@@ -31,17 +334,74 @@ void write_sprite_to_kernel(unsigned char active,   //active == 1, display, acti
                             unsigned char n,
                             unsigned short register_n) 
 {
+  write_sprite_flip_to_kernel(active, r, c, n, register_n, 0);
+}
+
+// same, with the image mirrored by VGA_SPRITE_FLIP_H and/or VGA_SPRITE_FLIP_V
+void write_sprite_flip_to_kernel(unsigned char active,
+                                 unsigned short r,
+                                 unsigned short c,
+                                 unsigned char n,
+                                 unsigned short register_n,
+                                 unsigned char flip)
+{
+  if (regs) {
+    regs[VGA_REG_SPRITE(register_n)] = VGA_SPRITE_WORD(active, r, c, n, flip);
+    if (sprite_latch && !frame_open)
+      vga_commit();
+    return;
+  }
+  if (frame_open) {
+    if (active)
+      frame_sprite(r, c, n, register_n, flip);
+    else
+      frame_sprite_hide(register_n);
+    return;
+  }
   vga_top_arg_s vla;
   vla.active = active;
   vla.r = r;
   vla.c = c;
   vla.n = n;
   vla.register_n = register_n;
+  vla.flip = flip;
   // printf("act:%i   r:%i  c:%i  n:%i  register_n:%i\n", active, r, c, n, register_n);
   if (ioctl(vga_fd, VGA_TOP_WRITE_SPRITE, &vla)) {
     perror("ioctl(VGA_TOP_WRITE_SPRITE) failed");
     return;
   }
+  // outside a frame nobody else will commit this write
+  if (sprite_latch)
+    vga_commit();
+}
+
+
+// block until frames vblanks have passed, so the writes that follow land
+// at the start of blanking; falls back to sleeping ~16.8ms per frame
+#define FRAME_US 16800 // 800x525 pixels at 25 MHz
+
+// when the last wait_vblank() returned, the start of a vertical blank
+static struct timespec last_vblank;
+
+void wait_vblank(unsigned int frames)
+{
+  unsigned long long frame;
+  while (frames--) {
+    if (ioctl(vga_fd, VGA_TOP_WAIT_VBLANK, &frame)) {
+      usleep(FRAME_US);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &last_vblank);
+}
+
+unsigned int us_to_vblank(void)
+{
+  struct timespec now;
+  long long us;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  us = (now.tv_sec - last_vblank.tv_sec) * 1000000LL + (now.tv_nsec - last_vblank.tv_nsec) / 1000;
+  return FRAME_US - us % FRAME_US;
 }
 
 
@@ -50,28 +410,23 @@ void write_sprite_to_kernel(unsigned char active,   //active == 1, display, acti
 // for when needing to reset the background to empty
 void cleartiles()
 {
-  int i, j;
-  for(i=0;i<30;i++)
-  {
-     for(j=0;j<40;j++)
-     {
-        write_tile_to_kernel(i, j, BLANKTILE);
-     }
-  }
+  unsigned char screen[ROWS][COLS];
+  memset(screen, BLANKTILE, sizeof(screen));
+  write_tile_rect_to_kernel(0, 0, ROWS, COLS, &screen[0][0]);
 }
 
 void fill_sky_and_grass(void) {
-    unsigned char r, c, tile;
+    unsigned char screen[ROWS][COLS];
+    unsigned char r, tile;
     for (r = 0; r < ROWS; r++) {
         tile = (r < (ROWS * 2 / 3)) ? SKY_TILE : GRASS_TILE;
-        for (c = 0; c < COLS; c++) {
-            write_tile_to_kernel(r, c, tile);
-        }
+        memset(screen[r], tile, COLS);
     }
+    write_tile_rect_to_kernel(0, 0, ROWS, COLS, &screen[0][0]);
 }
 
 void clearSprites(){
-  for(int i = 0; i <12; i++){
+  for(int i = 0; i < VGA_NUM_SPRITES; i++){
     write_sprite_to_kernel(0, 0, 0, 0, i);
   }
 }
@@ -96,11 +451,13 @@ void write_numbers(unsigned int nums, unsigned int digits, unsigned int row, uns
     printf("number too long!\n");
   }
   else {
-    for (unsigned int i = col + digits - 1; i >= col; i--)
+    unsigned char line[COLS];
+    for (int i = digits - 1; i >= 0; i--)
     {
-      write_number(nums % 10, row, i);
+      line[i] = NUMBERTILE(nums % 10);
       nums = nums / 10;
     }
+    write_tile_rect_to_kernel(row, col, 1, digits, line);
   }
 }
 
@@ -120,9 +477,11 @@ void write_text(unsigned char *text, unsigned int length, unsigned int row, unsi
     printf("string too long!\n");
   }
   else {
-    for (unsigned int i = col; i < (col + length); i++) {
-      write_letter(*(text + i - col), row, i);
+    unsigned char line[COLS];
+    for (unsigned int i = 0; i < length; i++) {
+      line[i] = LETTERTILE(text[i] - 97); // ascii conversion
     }
+    write_tile_rect_to_kernel(row, col, 1, length, line);
   }
 }
 
@@ -1,3 +1,5 @@
+#include "vga_top.h"
+
 
 #define BLANKTILE 0 // img number of blank tile
 // TODO: Change the offset according to the actual mapping
@@ -24,10 +26,40 @@
 extern int vga_fd; // vga file descriptor, define in main file
 
 
+int vga_shadow_init(void); // map the driver's shadow tilemap, tile writes then need no syscall
+int vga_mmio_init(void); // map the registers, every tile and sprite write becomes one store
+
+void vga_sprite_latch(int on); // 1: sprite changes wait for a commit and show up together at vblank
+void vga_commit(void); // commit latched sprites, frame_submit() does this itself
+
+// frame builder: between frame_begin() and frame_submit() every tile and
+// sprite or palette write below is appended to one display list, sent with one write()
+void frame_begin(void);
+void frame_submit(void);
+void frame_tile(unsigned char r, unsigned char c, unsigned char n);
+void frame_tile_fill(unsigned char r, unsigned char c, unsigned char rows, unsigned char cols, unsigned char n);
+void frame_sprite(unsigned short r, unsigned short c, unsigned char n, unsigned short register_n, unsigned char flip);
+void frame_sprite_hide(unsigned short register_n);
+void frame_palette(unsigned char entry, unsigned short colour);
+
 void write_tile_to_kernel(unsigned char r, unsigned char c, unsigned char n);
 
+void write_tiles_to_kernel(vga_top_arg_t *tiles, unsigned int count); // batch of tiles, one syscall
+
+void write_tile_rect_to_kernel(unsigned char r, unsigned char c, unsigned char rows, unsigned char cols, unsigned char *n); // dense block, one syscall
+
+void write_palette_to_kernel(unsigned char first, unsigned int count, unsigned short *colours); // VGA_RGB colours, one syscall
+
+void write_frame_to_kernel(vga_top_frame_t *frame, unsigned int parts); // whole screen, fetched by the DMA at vblank
+
 void write_sprite_to_kernel(unsigned char active, unsigned short r, unsigned short c, unsigned char n, unsigned short register_n);
 
+void write_sprite_flip_to_kernel(unsigned char active, unsigned short r, unsigned short c, unsigned char n, unsigned short register_n, unsigned char flip); // VGA_SPRITE_FLIP_H/V
+
+void wait_vblank(unsigned int frames); // pace the game loop on the display instead of usleep
+
+unsigned int us_to_vblank(void); // estimated time until the next vblank, from the last wait_vblank()
+
 void write_number(unsigned int num, unsigned int row, unsigned int col); // for writing numbers, input corresponding tile row and column
 
 void write_letter(unsigned char letter, unsigned int row, unsigned int col); // for writing letters at specific coordinates
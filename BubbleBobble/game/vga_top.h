@@ -17,8 +17,150 @@ typedef struct {
   unsigned short c;
   unsigned char n;
   unsigned short register_n; // the corresponding sprite register, start from 0
+  unsigned char flip; // VGA_SPRITE_FLIP_H and/or VGA_SPRITE_FLIP_V
 } vga_top_arg_s;
 
+#define VGA_TILE_ROWS 30
+#define VGA_TILE_COLS 40
+#define VGA_NUM_SPRITES 32 // sprite registers, register_n is 0 to 31
+#define VGA_SPRITE_IMAGES 22 // images in the sprite rom, n is 0 to 21
+#define VGA_SPRITE_FLIP_H 1 // mirror the image left to right
+#define VGA_SPRITE_FLIP_V 2 // and top to bottom
+
+// def of argument for a batch of tiles, any position in any order
+typedef struct {
+  vga_top_arg_t *tiles; // user pointer to count packed (r, c, n) records
+  unsigned int count;   // at most VGA_TILE_ROWS * VGA_TILE_COLS
+} vga_top_arg_tiles;
+
+// def of argument for a dense rectangle of tiles
+typedef struct {
+  unsigned char r;       // top left tile of the rectangle
+  unsigned char c;
+  unsigned char rows;
+  unsigned char cols;
+  unsigned char *n;      // user pointer to rows*cols image numbers, row major
+} vga_top_arg_rect;
+
+// tiles and sprites are drawn with 8-bit indices into a palette of
+// VGA_RGB colours; the hardware loads it from palette.mif at reset
+#define VGA_PALETTE_SIZE 256 // entry 0 is a transparent sprite pixel
+#define VGA_RGB(r, g, b) \
+  ((((unsigned short) (r) & 0x1f) << 11) | (((unsigned short) (g) & 0x1f) << 6) | \
+   (((unsigned short) (b) & 0x1f) << 1)) // 5 bits each
+
+// def of argument for a run of palette entries
+typedef struct {
+  unsigned short *colours; // user pointer to count VGA_RGB values
+  unsigned int first;      // entry colours[0] goes to
+  unsigned int count;      // first + count at most VGA_PALETTE_SIZE
+} vga_top_arg_palette;
+
+// mmap() offsets on /dev/vga_top, in pages
+#define VGA_TOP_MMAP_SHADOW 0 // the shadow tilemap below
+#define VGA_TOP_MMAP_REGS   1 // the page holding the registers, VGA_TOP_REGS_OFFSET says where in it
+
+// registers as 32-bit words from the VGA_TOP_REGS_OFFSET, for direct stores
+#define VGA_REG_TILE          0 // VGA_TILE_WORD
+#define VGA_REG_SPRITE(i)     (1 + (i)) // VGA_SPRITE_WORD, i is register_n
+#define VGA_REG_SPRITE_CTRL   51 // bit 0 latches sprite writes
+#define VGA_REG_SPRITE_COMMIT 52 // any write commits them at the next vblank
+#define VGA_REG_PALETTE       57 // VGA_PALETTE_WORD, shows from the next pixel
+
+// value of the tile register: 5bit r, 6bit c, 8bit n
+#define VGA_TILE_WORD(r, c, n) \
+  (((unsigned int) (r) << 14) | ((unsigned int) (c) << 8) | (unsigned int) (n))
+
+// value of the palette register: 8bit entry, 16bit VGA_RGB colour
+#define VGA_PALETTE_WORD(entry, colour) \
+  ((((unsigned int) (entry) & 0xff) << 16) | ((unsigned int) (colour) & 0xffff))
+
+// layout of the page mmap()ed from /dev/vga_top at VGA_TOP_MMAP_SHADOW
+// write tiles[r][c], then set bit r of dirty_rows; the driver pushes the
+// cells that changed to the hardware once per frame and clears the bits
+typedef struct {
+  unsigned char tiles[VGA_TILE_ROWS][VGA_TILE_COLS];
+  unsigned int dirty_rows;
+} vga_top_shadow_t;
+
+// one whole screen, as the display list DMA fetches it from memory
+typedef struct {
+  unsigned char tiles[VGA_TILE_ROWS][VGA_TILE_COLS];
+  unsigned int sprites[VGA_NUM_SPRITES]; // sprite register values, see VGA_SPRITE_WORD
+} vga_top_frame_t;
+
+// value of a sprite register: 2bit flip, 1bit active, 9bit r, 10bit c, 5bit n
+#define VGA_SPRITE_WORD(active, r, c, n, flip) \
+  (((unsigned int) (flip) & 3) << 25 | \
+   ((unsigned int) (active) << 24) | (((unsigned int) (r) & 0x1ff) << 15) | \
+   (((unsigned int) (c) & 0x3ff) << 5) | ((unsigned int) (n) & 0x1f))
+
+// which parts of a vga_top_frame_t to show
+#define VGA_FRAME_TILES   1
+#define VGA_FRAME_SPRITES 2
+
+// def of argument for a whole screen
+typedef struct {
+  vga_top_frame_t *frame; // user pointer
+  unsigned int parts;     // VGA_FRAME_TILES and/or VGA_FRAME_SPRITES
+} vga_top_arg_frame;
+
+/*
+ * Display list for write() on /dev/vga_top: a packed sequence of commands,
+ * each a one byte opcode followed by its payload. Multi-byte fields are
+ * little endian. write() runs the commands in order and returns the number
+ * of bytes consumed; a short count means the command at that offset was
+ * invalid.
+ */
+#define VGA_DL_TILE        1 // r, c, n
+#define VGA_DL_TILE_FILL   2 // r, c, rows, cols, n: fill a rectangle with one tile
+#define VGA_DL_SPRITE      3 // register_n, r (2 bytes), c (2 bytes), n, flip: show a sprite
+#define VGA_DL_SPRITE_HIDE 4 // register_n
+#define VGA_DL_COMMIT      5 // no payload: show latched sprites from the next vblank
+#define VGA_DL_PALETTE     6 // entry, colour (2 bytes): set one palette entry
+
+#define VGA_DL_MAX 8192 // largest display list accepted by one write()
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+  unsigned char r;
+  unsigned char c;
+  unsigned char n;
+} vga_dl_tile;
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+  unsigned char r;
+  unsigned char c;
+  unsigned char rows;
+  unsigned char cols;
+  unsigned char n;
+} vga_dl_tile_fill;
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+  unsigned char register_n;
+  unsigned short r;
+  unsigned short c;
+  unsigned char n;
+  unsigned char flip; // VGA_SPRITE_FLIP_H and/or VGA_SPRITE_FLIP_V
+} vga_dl_sprite;
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+  unsigned char register_n;
+} vga_dl_sprite_hide;
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+} vga_dl_commit;
+
+typedef struct __attribute__((packed)) {
+  unsigned char op;
+  unsigned char entry;
+  unsigned short colour; // VGA_RGB
+} vga_dl_palette;
+
 // function top dec
 void write_tile_to_kernel(unsigned char r, unsigned char c, unsigned char n);
 
@@ -34,5 +176,13 @@ void write_sprite_to_kernel(unsigned char active,
 /* ioctls and their arguments */
 #define VGA_TOP_WRITE_TILE _IOW(VGA_TOP_MAGIC, 1, vga_top_arg_t *)
 #define VGA_TOP_WRITE_SPRITE _IOW(VGA_TOP_MAGIC, 2, vga_top_arg_s *)
+#define VGA_TOP_WRITE_TILES _IOW(VGA_TOP_MAGIC, 3, vga_top_arg_tiles *)
+#define VGA_TOP_WRITE_TILE_RECT _IOW(VGA_TOP_MAGIC, 4, vga_top_arg_rect *)
+#define VGA_TOP_WAIT_VBLANK _IOR(VGA_TOP_MAGIC, 5, unsigned long long *) // blocks until the next vblank, returns the frame count
+#define VGA_TOP_SPRITE_LATCH _IO(VGA_TOP_MAGIC, 6) // arg 1: sprite writes wait for VGA_TOP_COMMIT, 0: show at once
+#define VGA_TOP_COMMIT _IO(VGA_TOP_MAGIC, 7) // latched sprites go on screen together at the next vblank
+#define VGA_TOP_WRITE_FRAME _IOW(VGA_TOP_MAGIC, 8, vga_top_arg_frame *) // DMA'd to the hardware at the next vblank
+#define VGA_TOP_REGS_OFFSET _IOR(VGA_TOP_MAGIC, 9, unsigned int *) // byte offset of the registers in the VGA_TOP_MMAP_REGS page
+#define VGA_TOP_WRITE_PALETTE _IOW(VGA_TOP_MAGIC, 10, vga_top_arg_palette *) // palette entries, from the next vblank
 
 #endif
@@ -13,13 +13,80 @@
 #include <linux/of_address.h>
 #include <linux/fs.h>
 #include <linux/uaccess.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/kfifo.h>
+#include <linux/interrupt.h>
+#include <linux/of_irq.h>
+#include <linux/hrtimer.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/string.h>
 #include "fpga_audio.h"
+#include "fpga_audio_sounds.h"
+#include "fpga_audio_song.h"
 
 #define DRIVER_NAME "fpga_audio"
 
-/* Device registers */
+/* Device registers, 32-bit words */
 #define BGM_PLAY(x) (x)
-#define AUDIO_DATA_ADDR_REG(x) (x+1)
+#define AUDIO_DATA_ADDR_REG(x) (x+1*4)
+#define FIFO_DATA(x) (x+2*4)
+#define FIFO_LEVEL(x) (x+3*4)
+#define FIFO_CTRL(x) (x+4*4)
+#define FIFO_LOW(x) (x+5*4)
+#define FIFO_GAPS(x) (x+6*4)
+#define SOUND_SEL(x) (x+8*4)
+#define SOUND_START(x) (x+9*4)
+#define SOUND_LEN(x) (x+10*4)
+#define VOICE_STATUS(x) (x+12*4)
+#define VOICE_IRQ(x) (x+13*4)
+#define POS_SEL(x) (x+14*4)
+#define POSITION(x) (x+15*4)
+#define VOICE(x, n) (x+(16+(n))*4)
+#define VOICE_RATE(x, n) (x+(24+(n))*4)
+#define SEQ_CTRL(x) (x+32*4)
+#define SEQ_TEMPO(x) (x+33*4)
+#define SEQ_ADDR(x) (x+34*4)
+#define SEQ_DATA(x) (x+35*4)
+#define SEQ_LENGTH(x) (x+36*4)
+#define SEQ_VOLUME(x) (x+38*4)
+
+#define FIFO_PLAY 1
+#define FIFO_IRQ 2
+#define FIFO_FLUSH 4
+
+#define SOUND_LEN_MAX 0x7ffff // sound_len is 19 bits in fpga_audio.sv
+#define SOUND_ADPCM (1 << 30)
+#define SOUND_LOOP (1u << 31)
+
+#define VOICE_LOOP (1 << 3)
+#define VOICE_PLAY (1 << 4)
+
+#define VOICES_ALL ((1 << FPGA_AUDIO_VOICES) - 1)
+
+#define HW_FIFO_DEPTH 1024
+#define HW_FIFO_LOW 256 // refill with 32 ms left
+
+/*
+ * PCM from write() waits in a ring for room in the hardware fifo. write()
+ * blocks while the ring is full, so at most STREAM_RING + HW_FIFO_DEPTH
+ * samples (640 ms) sit between a write and the speaker.
+ */
+#define STREAM_RING 4096
+
+/* Without an irq in the device tree the ring is moved by a timer */
+#define REFILL_MS 10
+
+/* Sound effects waiting for their time, soonest first */
+#define SFX_QUEUE 32
+#define SFX_MAX_DELAY_US 10000000
+
+struct sfx_event {
+	ktime_t when;
+	u8 sound;
+	u16 rate;
+};
 
 /*
  * Information about our device
@@ -27,18 +94,300 @@
 struct fpga_audio_dev {
 	struct resource res; /* Resource: our registers */
 	void __iomem *virtbase; /* Where registers can be accessed in memory */
+	spinlock_t lock; /* Serializes refills between write() and the irq */
+	struct mutex write_lock; /* One writer fills the ring at a time */
+	DECLARE_KFIFO(ring, s16, STREAM_RING); /* Samples not in the hardware yet */
+	wait_queue_head_t ring_wait; /* Woken when the ring has room */
+	bool streaming; /* write() started the stream and it was not stopped */
+	unsigned int ended; /* Voices that reached their end since the last status read */
+	wait_queue_head_t event_wait; /* Woken when a voice ends */
+	int irq; /* fifo low-watermark and voice end interrupt, 0 when the timer is used */
+	struct hrtimer refill_timer;
+	struct sfx_event sfx_queue[SFX_QUEUE]; /* Under lock */
+	unsigned int sfx_count;
+	struct hrtimer sfx_timer; /* Fires at sfx_queue[0].when */
 } dev;
 
+static bool bgm_seq;
+module_param(bgm_seq, bool, 0644);
+MODULE_PARM_DESC(bgm_seq, "play the background music on the sequencer instead of from the sample rom");
+
 
 static void bgm_startstop(unsigned char s)
 {
   //pr_info("writing %d\n", s);
-	iowrite8(s, BGM_PLAY(dev.virtbase) );
+	if (bgm_seq)
+		iowrite32(s ? 1 : 0, SEQ_CTRL(dev.virtbase));
+	else
+		iowrite32(s, BGM_PLAY(dev.virtbase) );
+}
+
+/* Put the song from fpga_audio_song.h in the sequencer's RAM */
+static void load_song(void)
+{
+	int i;
+
+	iowrite32(0, SEQ_CTRL(dev.virtbase));
+	iowrite32(0, SEQ_ADDR(dev.virtbase));
+	for (i = 0; i < ARRAY_SIZE(fpga_audio_song); i++)
+		iowrite32(fpga_audio_song[i], SEQ_DATA(dev.virtbase));
+	iowrite32(FPGA_AUDIO_SONG_ROWS | FPGA_AUDIO_SONG_LOOP << 16, SEQ_LENGTH(dev.virtbase));
+	iowrite32(FPGA_AUDIO_SONG_TEMPO, SEQ_TEMPO(dev.virtbase));
+	iowrite32(FPGA_AUDIO_SONG_VOLUME, SEQ_VOLUME(dev.virtbase));
+}
+
+/* The hardware takes the rate in bits 27:16, 0 plays at the recorded pitch */
+static void set_audio_data_address(unsigned char addr, unsigned short rate)
+{
+  iowrite32(addr | rate << 16, AUDIO_DATA_ADDR_REG(dev.virtbase));
+}
+
+/* Point a sound table slot at a run of the rom; voices already on it keep going */
+static int set_sound(const fpga_audio_sound_t *s)
+{
+	unsigned int bytes = s->adpcm ? (s->length + 1) / 2 : s->length; // adpcm packs two samples in a byte
+	unsigned long flags;
+
+	// the rom pack_audio built, not the 18-bit address space: past it reads garbage
+	if (s->slot >= FPGA_AUDIO_SOUNDS || s->length > SOUND_LEN_MAX ||
+	    s->start >= FPGA_AUDIO_ROM_SIZE || bytes > FPGA_AUDIO_ROM_SIZE - s->start)
+		return -EINVAL;
+
+	// SOUND_SEL is shared state, keep the three writes together
+	spin_lock_irqsave(&dev.lock, flags);
+	iowrite32(s->slot, SOUND_SEL(dev.virtbase));
+	iowrite32(s->start, SOUND_START(dev.virtbase));
+	iowrite32(s->length | (s->adpcm ? SOUND_ADPCM : 0) | (s->loop ? SOUND_LOOP : 0),
+		  SOUND_LEN(dev.virtbase));
+	spin_unlock_irqrestore(&dev.lock, flags);
+	return 0;
+}
+
+static void play_voice(const fpga_audio_voice_t *v)
+{
+	u32 val = (v->sound & 7) | (v->volume << 8);
+
+	if (v->loop)
+		val |= VOICE_LOOP;
+	if (v->play)
+		val |= VOICE_PLAY;
+	iowrite32(v->rate ? v->rate : FPGA_AUDIO_RATE_1X, VOICE_RATE(dev.virtbase, v->voice));
+	iowrite32(val, VOICE(dev.virtbase, v->voice));
+}
+
+static unsigned int voices_playing(void)
+{
+	unsigned int mask = 0;
+	int i;
+
+	for (i = 0; i < FPGA_AUDIO_VOICES; i++)
+		if (ioread32(VOICE(dev.virtbase, i)) & VOICE_PLAY)
+			mask |= 1 << i;
+	return mask;
+}
+
+/*
+ * Move samples from the ring into the hardware fifo. The low-watermark
+ * irq stays on only while the ring has more to give.
+ */
+static void refill_locked(void)
+{
+	unsigned int room = HW_FIFO_DEPTH - ioread32(FIFO_LEVEL(dev.virtbase));
+	s16 sample;
+
+	while (room-- && kfifo_get(&dev.ring, &sample))
+		iowrite32((u16) sample, FIFO_DATA(dev.virtbase));
+	iowrite32(kfifo_is_empty(&dev.ring) ? FIFO_PLAY : FIFO_PLAY | FIFO_IRQ,
+		  FIFO_CTRL(dev.virtbase));
+	wake_up_interruptible(&dev.ring_wait);
+}
+
+/* Move voice end flags from the hardware to dev.ended, which also drops the irq */
+static void collect_ended_locked(void)
+{
+	unsigned int ended = (ioread32(VOICE_STATUS(dev.virtbase)) >> 8) & VOICES_ALL;
+
+	if (ended) {
+		iowrite32(ended << 8, VOICE_STATUS(dev.virtbase));
+		dev.ended |= ended;
+		wake_up_interruptible(&dev.event_wait);
+	}
+}
+
+/* Everything the irq asks for: stream refill and sounds that finished */
+static void service(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	if (dev.streaming)
+		refill_locked();
+	collect_ended_locked();
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static irqreturn_t fpga_audio_irq(int irq, void *dev_id)
+{
+	// the two conditions fpga_audio.sv raises irq on, in case the line is shared
+	bool fifo_low = (ioread32(FIFO_CTRL(dev.virtbase)) & FIFO_IRQ) &&
+			ioread32(FIFO_LEVEL(dev.virtbase)) < HW_FIFO_LOW;
+	unsigned int ended = (ioread32(VOICE_STATUS(dev.virtbase)) >> 8) &
+			     ioread32(VOICE_IRQ(dev.virtbase));
+
+	if (!fifo_low && !ended)
+		return IRQ_NONE;
+	service();
+	return IRQ_HANDLED;
+}
+
+static enum hrtimer_restart refill_timer_fn(struct hrtimer *t)
+{
+	service();
+	hrtimer_forward_now(t, ms_to_ktime(REFILL_MS));
+	return HRTIMER_RESTART;
+}
+
+/* Start the queued sound effects that are due; the hardware picks their voices */
+static enum hrtimer_restart sfx_timer_fn(struct hrtimer *t)
+{
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	unsigned int due = 0;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	for (; due < dev.sfx_count && !ktime_after(dev.sfx_queue[due].when, now); due++)
+		set_audio_data_address(dev.sfx_queue[due].sound, dev.sfx_queue[due].rate);
+	dev.sfx_count -= due;
+	memmove(dev.sfx_queue, dev.sfx_queue + due, dev.sfx_count * sizeof(struct sfx_event));
+	if (dev.sfx_count)
+		hrtimer_start(t, dev.sfx_queue[0].when, HRTIMER_MODE_ABS);
+	spin_unlock_irqrestore(&dev.lock, flags);
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Queue a batch of sound effects, each delay_us after now. All or none are
+ * queued, so a frame's sounds stay together.
+ */
+static int queue_sfx(const fpga_audio_sfx_t *sfx, unsigned int count)
+{
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	unsigned int i, j;
+
+	for (i = 0; i < count; i++)
+		if (sfx[i].sound >= FPGA_AUDIO_SOUNDS || sfx[i].rate > FPGA_AUDIO_RATE_MAX ||
+		    sfx[i].delay_us > SFX_MAX_DELAY_US)
+			return -EINVAL;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	if (dev.sfx_count + count > SFX_QUEUE) {
+		spin_unlock_irqrestore(&dev.lock, flags);
+		return -ENOSPC;
+	}
+	for (i = 0; i < count; i++) {
+		ktime_t when = ktime_add_us(now, sfx[i].delay_us);
+
+		// insertion keeps the queue sorted, and equal times in submit order
+		for (j = dev.sfx_count; j > 0 && ktime_after(dev.sfx_queue[j - 1].when, when); j--)
+			dev.sfx_queue[j] = dev.sfx_queue[j - 1];
+		dev.sfx_queue[j].when = when;
+		dev.sfx_queue[j].sound = sfx[i].sound;
+		dev.sfx_queue[j].rate = sfx[i].rate;
+		dev.sfx_count++;
+	}
+	if (count)
+		hrtimer_start(&dev.sfx_timer, dev.sfx_queue[0].when, HRTIMER_MODE_ABS);
+	spin_unlock_irqrestore(&dev.lock, flags);
+	return 0;
 }
 
-static void set_audio_data_address(unsigned char addr)
+/* Stop the stream and drop everything not played yet */
+static void stream_stop(void)
 {
-  iowrite8(addr, AUDIO_DATA_ADDR_REG(dev.virtbase));
+	unsigned long flags;
+
+	mutex_lock(&dev.write_lock);
+	spin_lock_irqsave(&dev.lock, flags);
+	dev.streaming = false;
+	kfifo_reset(&dev.ring);
+	iowrite32(FIFO_FLUSH, FIFO_CTRL(dev.virtbase));
+	spin_unlock_irqrestore(&dev.lock, flags);
+	mutex_unlock(&dev.write_lock);
+	wake_up_interruptible(&dev.ring_wait);
+}
+
+/*
+ * write(): signed 16-bit mono PCM at FPGA_AUDIO_RATE; starts the stream.
+ * Returns once the samples are queued, blocking only while the ring is full.
+ */
+static ssize_t fpga_audio_write(struct file *f, const char __user *buf, size_t count, loff_t *off)
+{
+	unsigned long flags;
+	unsigned int copied;
+	int ret;
+
+	count &= ~(size_t) 1; // whole samples only
+	if (count == 0)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&dev.write_lock))
+		return -ERESTARTSYS;
+	while (kfifo_is_full(&dev.ring)) {
+		if (f->f_flags & O_NONBLOCK) {
+			ret = -EAGAIN;
+			goto out;
+		}
+		ret = wait_event_interruptible(dev.ring_wait, !kfifo_is_full(&dev.ring));
+		if (ret)
+			goto out;
+	}
+	ret = kfifo_from_user(&dev.ring, buf, count, &copied);
+out:
+	mutex_unlock(&dev.write_lock);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	dev.streaming = true;
+	refill_locked();
+	spin_unlock_irqrestore(&dev.lock, flags);
+	return copied;
+}
+
+/*
+ * poll(): writable while the ring has room, readable once a voice has
+ * ended since the last FPGA_AUDIO_GET_STATUS
+ */
+static __poll_t fpga_audio_poll(struct file *f, poll_table *wait)
+{
+	__poll_t mask = 0;
+
+	poll_wait(f, &dev.ring_wait, wait);
+	poll_wait(f, &dev.event_wait, wait);
+	if (!kfifo_is_full(&dev.ring))
+		mask |= POLLOUT | POLLWRNORM;
+	if (READ_ONCE(dev.ended))
+		mask |= POLLIN | POLLRDNORM;
+	return mask;
+}
+
+/* Voice state for FPGA_AUDIO_GET_STATUS; hands over the end events */
+static void get_status(fpga_audio_status_t *st)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	collect_ended_locked();
+	st->playing = ioread32(VOICE_STATUS(dev.virtbase)) & VOICES_ALL;
+	st->ended = dev.ended;
+	dev.ended = 0;
+	for (i = 0; i < FPGA_AUDIO_VOICES; i++) {
+		iowrite32(i, POS_SEL(dev.virtbase));
+		st->position[i] = ioread32(POSITION(dev.virtbase));
+	}
+	spin_unlock_irqrestore(&dev.lock, flags);
 }
 
 /*
@@ -49,6 +398,15 @@ static void set_audio_data_address(unsigned char addr)
 static long fpga_audio_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
   fpga_audio_arg_t vla;
+  fpga_audio_stream_t vlst;
+  fpga_audio_voice_t vlv;
+  unsigned int mask;
+  fpga_audio_sound_t vls;
+  fpga_audio_status_t vlstat;
+  fpga_audio_sfx_batch_t vlb;
+  fpga_audio_sfx_t sfx[FPGA_AUDIO_SFX_BATCH];
+  unsigned int tempo;
+  int ret;
 	switch (cmd) {
 	  case FPGA_AUDIO_BGM_STARTSTOP:
 		  if (copy_from_user(&vla, (fpga_audio_arg_t *) arg, sizeof(fpga_audio_arg_t)))
@@ -58,8 +416,66 @@ static long fpga_audio_ioctl(struct file *f, unsigned int cmd, unsigned long arg
     case FPGA_AUDIO_SET_AUDIO_ADDR:
 		  if (copy_from_user(&vla, (fpga_audio_arg_t *) arg, sizeof(fpga_audio_arg_t)))
 			  return -EACCES;
-      set_audio_data_address(vla.play);
+		  if (vla.rate > FPGA_AUDIO_RATE_MAX)
+			  return -EINVAL;
+      set_audio_data_address(vla.play, vla.rate);
       break;
+	  case FPGA_AUDIO_STREAM_STOP:
+		  stream_stop();
+		  break;
+	  case FPGA_AUDIO_STREAM_STATUS:
+		  vlst.queued = kfifo_len(&dev.ring) + ioread32(FIFO_LEVEL(dev.virtbase));
+		  vlst.gaps = ioread32(FIFO_GAPS(dev.virtbase));
+		  if (copy_to_user((fpga_audio_stream_t *) arg, &vlst, sizeof(fpga_audio_stream_t)))
+			  return -EACCES;
+		  break;
+	  case FPGA_AUDIO_PLAY_VOICE:
+		  if (copy_from_user(&vlv, (fpga_audio_voice_t *) arg, sizeof(fpga_audio_voice_t)))
+			  return -EACCES;
+		  if (vlv.voice >= FPGA_AUDIO_VOICES || vlv.rate > FPGA_AUDIO_RATE_MAX)
+			  return -EINVAL;
+		  play_voice(&vlv);
+		  break;
+	  case FPGA_AUDIO_SET_SOUND:
+		  if (copy_from_user(&vls, (fpga_audio_sound_t *) arg, sizeof(fpga_audio_sound_t)))
+			  return -EACCES;
+		  ret = set_sound(&vls);
+		  if (ret)
+			  return ret;
+		  break;
+	  case FPGA_AUDIO_QUEUE_SFX:
+		  if (copy_from_user(&vlb, (fpga_audio_sfx_batch_t *) arg, sizeof(fpga_audio_sfx_batch_t)))
+			  return -EACCES;
+		  if (vlb.count > FPGA_AUDIO_SFX_BATCH)
+			  return -EINVAL;
+		  if (copy_from_user(sfx, vlb.sfx, vlb.count * sizeof(fpga_audio_sfx_t)))
+			  return -EACCES;
+		  ret = queue_sfx(sfx, vlb.count);
+		  if (ret)
+			  return ret;
+		  break;
+	  case FPGA_AUDIO_SEQ_PLAY:
+		  if (copy_from_user(&vla, (fpga_audio_arg_t *) arg, sizeof(fpga_audio_arg_t)))
+			  return -EACCES;
+		  iowrite32(vla.play ? 1 : 0, SEQ_CTRL(dev.virtbase));
+		  break;
+	  case FPGA_AUDIO_SEQ_TEMPO:
+		  if (copy_from_user(&tempo, (unsigned int *) arg, sizeof(tempo)))
+			  return -EACCES;
+		  if (tempo == 0 || tempo > 0xffff)
+			  return -EINVAL;
+		  iowrite32(tempo, SEQ_TEMPO(dev.virtbase));
+		  break;
+	  case FPGA_AUDIO_GET_STATUS:
+		  get_status(&vlstat);
+		  if (copy_to_user((fpga_audio_status_t *) arg, &vlstat, sizeof(fpga_audio_status_t)))
+			  return -EACCES;
+		  break;
+	  case FPGA_AUDIO_VOICES_PLAYING:
+		  mask = voices_playing();
+		  if (copy_to_user((unsigned int *) arg, &mask, sizeof(mask)))
+			  return -EACCES;
+		  break;
 
 	  default:
 		  return -EINVAL;
@@ -72,6 +488,8 @@ static long fpga_audio_ioctl(struct file *f, unsigned int cmd, unsigned long arg
 static const struct file_operations fops = {
 	.owner		= THIS_MODULE,
 	.unlocked_ioctl = fpga_audio_ioctl,
+	.write		= fpga_audio_write,
+	.poll		= fpga_audio_poll,
 };
 
 /* Information about our device for the "misc" framework -- like a char dev */
@@ -87,24 +505,27 @@ static struct miscdevice misc_device = {
  */
 static int __init probe(struct platform_device *pdev)
 {
-	int ret;
+	int ret, i;
 
-	/* Register ourselves as a misc device: creates /dev/fpga_audio */
-	ret = misc_register(&misc_device);
+	spin_lock_init(&dev.lock);
+	mutex_init(&dev.write_lock);
+	INIT_KFIFO(dev.ring);
+	init_waitqueue_head(&dev.ring_wait);
+	init_waitqueue_head(&dev.event_wait);
+	hrtimer_init(&dev.refill_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev.refill_timer.function = refill_timer_fn;
+	hrtimer_init(&dev.sfx_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	dev.sfx_timer.function = sfx_timer_fn;
 
 	/* Get the address of our registers from the device tree */
 	ret = of_address_to_resource(pdev->dev.of_node, 0, &dev.res);
-	if (ret) {
-		ret = -ENOENT;
-		goto out_deregister;
-	}
+	if (ret)
+		return -ENOENT;
 
 	/* Make sure we can use these registers */
 	if (request_mem_region(dev.res.start, resource_size(&dev.res),
-			       DRIVER_NAME) == NULL) {
-		ret = -EBUSY;
-		goto out_deregister;
-	}
+			       DRIVER_NAME) == NULL)
+		return -EBUSY;
 
 	/* Arrange access to our registers */
 	dev.virtbase = of_iomap(pdev->dev.of_node, 0);
@@ -113,21 +534,60 @@ static int __init probe(struct platform_device *pdev)
 		goto out_release_mem_region;
 	} 
 
+	/* The table the rom was packed with, and the music */
+	for (i = 0; i < FPGA_AUDIO_SOUNDS; i++)
+		set_sound(&fpga_audio_sounds[i]);
+	load_song();
+
+	/* Refill the stream fifo and report sound ends from the irq, or from a timer */
+	iowrite32(HW_FIFO_LOW, FIFO_LOW(dev.virtbase));
+	iowrite32(VOICES_ALL << 8, VOICE_STATUS(dev.virtbase));
+	dev.irq = irq_of_parse_and_map(pdev->dev.of_node, 0);
+	if (dev.irq > 0) {
+		ret = request_irq(dev.irq, fpga_audio_irq, 0, DRIVER_NAME, &dev);
+		if (ret)
+			goto out_unmap;
+		iowrite32(VOICES_ALL, VOICE_IRQ(dev.virtbase));
+	} else {
+		dev.irq = 0;
+		pr_info(DRIVER_NAME ": no irq, refilling every %d ms\n", REFILL_MS);
+		hrtimer_start(&dev.refill_timer, ms_to_ktime(REFILL_MS), HRTIMER_MODE_REL);
+	}
+
+	/* Last, once write() and the ioctls have registers to work with: creates /dev/fpga_audio */
+	ret = misc_register(&misc_device);
+	if (ret)
+		goto out_stop;
+
 	return 0;
 
+out_stop:
+	iowrite32(0, VOICE_IRQ(dev.virtbase));
+	if (dev.irq)
+		free_irq(dev.irq, &dev);
+	else
+		hrtimer_cancel(&dev.refill_timer);
+out_unmap:
+	iounmap(dev.virtbase);
 out_release_mem_region:
 	release_mem_region(dev.res.start, resource_size(&dev.res));
-out_deregister:
-	misc_deregister(&misc_device);
 	return ret;
 }
 
 /* Clean-up code: release resources */
 static int fpga_audio_remove(struct platform_device *pdev)
 {
+	misc_deregister(&misc_device); /* no new callers before the rest goes */
+	iowrite32(FIFO_FLUSH, FIFO_CTRL(dev.virtbase));
+	iowrite32(0, SEQ_CTRL(dev.virtbase));
+	iowrite32(0, VOICE_IRQ(dev.virtbase));
+	hrtimer_cancel(&dev.sfx_timer);
+	if (dev.irq)
+		free_irq(dev.irq, &dev);
+	else
+		hrtimer_cancel(&dev.refill_timer);
 	iounmap(dev.virtbase);
 	release_mem_region(dev.res.start, resource_size(&dev.res));
-	misc_deregister(&misc_device);
 	return 0;
 }
 
@@ -5,12 +5,100 @@
 
 typedef struct {
   unsigned char play;
+  unsigned short rate; // FPGA_AUDIO_SET_AUDIO_ADDR only, see FPGA_AUDIO_RATE_1X
 } fpga_audio_arg_t;
 
+/*
+ * write() on /dev/fpga_audio streams PCM: signed 16-bit mono samples at
+ * FPGA_AUDIO_RATE, little endian, mixed over the bgm and sound effects
+ */
+#define FPGA_AUDIO_RATE 8000
+
+// def of argument for reading the stream's state
+typedef struct {
+  unsigned int queued; // samples written but not played yet
+  unsigned int gaps;   // times playback ran out of samples
+} fpga_audio_stream_t;
+
+/*
+ * The hardware mixes FPGA_AUDIO_VOICES sounds at once. Voice 0 is the
+ * one the bgm ioctl uses; FPGA_AUDIO_SET_AUDIO_ADDR picks a free one of
+ * the others.
+ */
+#define FPGA_AUDIO_VOICES 8
+#define FPGA_AUDIO_SOUND_BGM 6 // slot the bgm ioctl plays
+
+/*
+ * Playback rate of a sound effect or voice, in 1/256ths of the rate it
+ * was recorded at: 512 is an octave up, 128 an octave down. The hardware
+ * interpolates between samples. 0 means FPGA_AUDIO_RATE_1X.
+ */
+#define FPGA_AUDIO_RATE_1X 256
+#define FPGA_AUDIO_RATE_MAX 4095
+
+/*
+ * Sound table: FPGA_AUDIO_SOUNDS slots, each a run of samples in the audio
+ * rom. The driver loads the table from fpga_audio_sounds.h at probe, and
+ * FPGA_AUDIO_SET_SOUND changes a slot without rebuilding the hardware.
+ */
+#define FPGA_AUDIO_SOUNDS 8
+
+typedef struct {
+  unsigned char slot;
+  unsigned char loop;  // voices playing it always loop
+  unsigned char adpcm; // 4-bit IMA ADPCM, else signed 8-bit PCM
+  unsigned int start;  // rom byte address of the first sample
+  unsigned int length; // samples, at most 0x7ffff; 0 empties the slot
+} fpga_audio_sound_t;
+
+// def of argument for playing a sound on one voice
+typedef struct {
+  unsigned char voice;  // 0 to FPGA_AUDIO_VOICES - 1
+  unsigned char sound;  // sound table slot
+  unsigned char volume; // 255 is full scale
+  unsigned char loop;   // restart at the end instead of stopping
+  unsigned char play;   // 0 stops the voice
+  unsigned short rate;  // see FPGA_AUDIO_RATE_1X
+} fpga_audio_voice_t;
+
+// def of argument for reading the voices; poll() reports POLLIN once one has ended
+typedef struct {
+  unsigned int playing; // bit n: voice n busy
+  unsigned int ended;   // bit n: voice n reached the end of its sound since the last read
+  unsigned int position[FPGA_AUDIO_VOICES]; // samples into the sound
+} fpga_audio_status_t;
+
+/*
+ * Scheduled sound effects: the driver starts each one from a timer
+ * delay_us after the batch is queued, so the sounds of a frame can be
+ * timed to when it is shown rather than to where the game noticed them.
+ */
+typedef struct {
+  unsigned char sound;   // sound table slot, played like FPGA_AUDIO_SET_AUDIO_ADDR
+  unsigned short rate;   // see FPGA_AUDIO_RATE_1X
+  unsigned int delay_us; // up to 10 s
+} fpga_audio_sfx_t;
+
+#define FPGA_AUDIO_SFX_BATCH 16
+
+typedef struct {
+  unsigned int count; // up to FPGA_AUDIO_SFX_BATCH
+  fpga_audio_sfx_t *sfx;
+} fpga_audio_sfx_batch_t;
+
 #define FPGA_AUDIO_MAGIC 'a'
 
 /* ioctls and their arguments */
 #define FPGA_AUDIO_BGM_STARTSTOP _IOW(FPGA_AUDIO_MAGIC, 1, fpga_audio_arg_t *)
 #define FPGA_AUDIO_SET_AUDIO_ADDR _IOW(FPGA_AUDIO_MAGIC, 2, fpga_audio_arg_t *)
+#define FPGA_AUDIO_STREAM_STOP _IO(FPGA_AUDIO_MAGIC, 3) // drop the samples not played yet
+#define FPGA_AUDIO_STREAM_STATUS _IOR(FPGA_AUDIO_MAGIC, 4, fpga_audio_stream_t *)
+#define FPGA_AUDIO_PLAY_VOICE _IOW(FPGA_AUDIO_MAGIC, 5, fpga_audio_voice_t *)
+#define FPGA_AUDIO_VOICES_PLAYING _IOR(FPGA_AUDIO_MAGIC, 6, unsigned int *) // bit n: voice n busy
+#define FPGA_AUDIO_SET_SOUND _IOW(FPGA_AUDIO_MAGIC, 7, fpga_audio_sound_t *)
+#define FPGA_AUDIO_GET_STATUS _IOR(FPGA_AUDIO_MAGIC, 8, fpga_audio_status_t *)
+#define FPGA_AUDIO_QUEUE_SFX _IOW(FPGA_AUDIO_MAGIC, 9, fpga_audio_sfx_batch_t *) // ENOSPC when the queue is full
+#define FPGA_AUDIO_SEQ_PLAY _IOW(FPGA_AUDIO_MAGIC, 10, fpga_audio_arg_t *) // music sequencer from the top, 0 stops
+#define FPGA_AUDIO_SEQ_TEMPO _IOW(FPGA_AUDIO_MAGIC, 11, unsigned int *) // samples per row, FPGA_AUDIO_RATE is a second
 
 #endif
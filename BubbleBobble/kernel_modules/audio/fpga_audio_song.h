@@ -0,0 +1,77 @@
+/* Background music for the audio sequencer, generated by seq_tool */
+#ifndef _FPGA_AUDIO_SONG_H
+#define _FPGA_AUDIO_SONG_H
+
+#define FPGA_AUDIO_SONG_ROWS 64
+#define FPGA_AUDIO_SONG_LOOP 0
+#define FPGA_AUDIO_SONG_TEMPO 800
+#define FPGA_AUDIO_SONG_VOLUME 255
+
+static const unsigned short fpga_audio_song[FPGA_AUDIO_SONG_ROWS * 4] = {
+  0x2a48, 0x1548, 0x2924, 0x2278,
+  0x0000, 0x154c, 0x0000, 0x007f,
+  0x0000, 0x154f, 0x0000, 0x2278,
+  0x2a4c, 0x1548, 0x007f, 0x007f,
+  0x0000, 0x154c, 0x2930, 0x2656,
+  0x0000, 0x154f, 0x0000, 0x007f,
+  0x2a4f, 0x1548, 0x0000, 0x2278,
+  0x0000, 0x154c, 0x007f, 0x007f,
+  0x2a4d, 0x154f, 0x2924, 0x2278,
+  0x0000, 0x1548, 0x0000, 0x007f,
+  0x2a4c, 0x154c, 0x0000, 0x2278,
+  0x0000, 0x154f, 0x007f, 0x007f,
+  0x2a4a, 0x1548, 0x2930, 0x2656,
+  0x0000, 0x154c, 0x0000, 0x007f,
+  0x2a48, 0x154f, 0x0000, 0x2278,
+  0x0000, 0x1548, 0x007f, 0x007f,
+  0x2a45, 0x1545, 0x2921, 0x2278,
+  0x0000, 0x1548, 0x0000, 0x007f,
+  0x0000, 0x154c, 0x0000, 0x2278,
+  0x2a48, 0x1545, 0x007f, 0x007f,
+  0x0000, 0x1548, 0x292d, 0x2656,
+  0x0000, 0x154c, 0x0000, 0x007f,
+  0x2a4c, 0x1545, 0x0000, 0x2278,
+  0x0000, 0x1548, 0x007f, 0x007f,
+  0x2a4a, 0x154c, 0x2921, 0x2278,
+  0x0000, 0x1545, 0x0000, 0x007f,
+  0x2a48, 0x1548, 0x0000, 0x2278,
+  0x0000, 0x154c, 0x007f, 0x007f,
+  0x2a47, 0x1545, 0x292d, 0x2656,
+  0x0000, 0x1548, 0x0000, 0x007f,
+  0x2a45, 0x154c, 0x0000, 0x2278,
+  0x0000, 0x1545, 0x007f, 0x007f,
+  0x2a41, 0x1541, 0x291d, 0x2278,
+  0x0000, 0x1545, 0x0000, 0x007f,
+  0x2a45, 0x1548, 0x0000, 0x2278,
+  0x0000, 0x1541, 0x007f, 0x007f,
+  0x2a48, 0x1545, 0x2929, 0x2656,
+  0x0000, 0x1548, 0x0000, 0x007f,
+  0x0000, 0x1541, 0x0000, 0x2278,
+  0x0000, 0x1545, 0x007f, 0x007f,
+  0x2a4a, 0x1548, 0x291d, 0x2278,
+  0x0000, 0x1541, 0x0000, 0x007f,
+  0x2a48, 0x1545, 0x0000, 0x2278,
+  0x0000, 0x1548, 0x007f, 0x007f,
+  0x2a45, 0x1541, 0x2929, 0x2656,
+  0x0000, 0x1545, 0x0000, 0x007f,
+  0x2a41, 0x1548, 0x0000, 0x2278,
+  0x0000, 0x1541, 0x007f, 0x007f,
+  0x2a43, 0x1543, 0x291f, 0x2278,
+  0x0000, 0x1547, 0x0000, 0x007f,
+  0x2a47, 0x154a, 0x0000, 0x2278,
+  0x0000, 0x1543, 0x007f, 0x007f,
+  0x2a4a, 0x1547, 0x292b, 0x2656,
+  0x0000, 0x154a, 0x0000, 0x007f,
+  0x0000, 0x1543, 0x0000, 0x2278,
+  0x0000, 0x1547, 0x007f, 0x007f,
+  0x2a4d, 0x154a, 0x291f, 0x2278,
+  0x0000, 0x1543, 0x0000, 0x007f,
+  0x2a4c, 0x1547, 0x0000, 0x2278,
+  0x0000, 0x154a, 0x007f, 0x007f,
+  0x2a4a, 0x1543, 0x292b, 0x2656,
+  0x0000, 0x1547, 0x0000, 0x007f,
+  0x2a47, 0x154a, 0x0000, 0x2278,
+  0x0000, 0x1543, 0x007f, 0x007f,
+};
+
+#endif
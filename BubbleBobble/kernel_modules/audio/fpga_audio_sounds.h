@@ -0,0 +1,28 @@
+/* Sound table matching combined_audio.mif, generated by pack_audio */
+#ifndef _FPGA_AUDIO_SOUNDS_H
+#define _FPGA_AUDIO_SOUNDS_H
+
+#include "fpga_audio.h"
+
+#define FPGA_AUDIO_ROM_SIZE 73706 /* bytes in the rom, numwords in audio_rom.v */
+
+#define FPGA_SOUND_SFX0 0
+#define FPGA_SOUND_SFX1 1
+#define FPGA_SOUND_SFX2 2
+#define FPGA_SOUND_SFX3 3
+#define FPGA_SOUND_SFX4 4
+#define FPGA_SOUND_SFX5 5
+#define FPGA_SOUND_BGM 6
+
+static const fpga_audio_sound_t fpga_audio_sounds[FPGA_AUDIO_SOUNDS] = {
+  { .slot = 0, .loop = 0, .adpcm = 1, .start = 0x10d69, .length = 0x02502 },
+  { .slot = 1, .loop = 0, .adpcm = 1, .start = 0x0fdc9, .length = 0x01f40 },
+  { .slot = 2, .loop = 0, .adpcm = 1, .start = 0x0ee29, .length = 0x01f40 },
+  { .slot = 3, .loop = 0, .adpcm = 1, .start = 0x0dac0, .length = 0x026d2 },
+  { .slot = 4, .loop = 0, .adpcm = 1, .start = 0x0bb80, .length = 0x03e80 },
+  { .slot = 5, .loop = 0, .adpcm = 1, .start = 0x09c40, .length = 0x03e80 },
+  { .slot = 6, .loop = 1, .adpcm = 1, .start = 0x00000, .length = 0x13880 },
+  { .slot = 7, .loop = 0, .adpcm = 0, .start = 0x00000, .length = 0x00000 },
+};
+
+#endif
@@ -21,21 +21,55 @@ void bgm_startstop(const unsigned char play)
   }
 }
 
-void play_sfx(const unsigned char audio_num)
+void play_sfx(const unsigned char audio_num, const unsigned short rate)
 {
   fpga_audio_arg_t vla;
   vla.play = audio_num;
+  vla.rate = rate;
   if (ioctl(fpga_audio_fd, FPGA_AUDIO_SET_AUDIO_ADDR, &vla)) {
       perror("ioctl(FPGA_AUDIO_SET_AUDIO_ADDR) failed");
       return;
   }
 }
 
+/* Play a raw signed 16-bit mono file at FPGA_AUDIO_RATE through the stream fifo */
+int stream_file(const char *path)
+{
+  static short buf[1024];
+  fpga_audio_stream_t st;
+  ssize_t n;
+  int fd;
+
+  if ( (fd = open(path, O_RDONLY)) == -1) {
+    fprintf(stderr, "could not open %s\n", path);
+    return -1;
+  }
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    if (write(fpga_audio_fd, buf, n) < 0) {
+      perror("write(fpga_audio) failed");
+      break;
+    }
+  }
+  close(fd);
+
+  // let the queue drain so the tail is not cut off by exit
+  do {
+    if (ioctl(fpga_audio_fd, FPGA_AUDIO_STREAM_STATUS, &st)) {
+      perror("ioctl(FPGA_AUDIO_STREAM_STATUS) failed");
+      return -1;
+    }
+    usleep(10000);
+  } while (st.queued > 0);
+  printf("underruns: %u\n", st.gaps);
+  return 0;
+}
+
 int main(int argc, char *argv[])
 {
-  if (argc != 3)
+  if (argc != 3 && argc != 4)
   {
-    printf("usage: hello 0/1, 0-5\n");
+    printf("usage: hello 0/1, 0-5 [rate, %d is the recorded pitch]\n", FPGA_AUDIO_RATE_1X);
+    printf("       hello stream file.raw\n");
     return 0;  
   }
   static const char filename[] = "/dev/fpga_audio";
@@ -47,10 +81,12 @@ int main(int argc, char *argv[])
     return -1;
   }
   
-  if(atoi(argv[1]) == 0)
+  if(strcmp(argv[1], "stream") == 0)
+    stream_file(argv[2]);
+  else if(atoi(argv[1]) == 0)
     bgm_startstop(atoi(argv[2]));
   else
-    play_sfx(atoi(argv[2]));
+    play_sfx(atoi(argv[2]), argc == 4 ? atoi(argv[3]) : 0);
 
   printf("fpga audio Userspace program terminating\n");
   return 0;
@@ -7,6 +7,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
 
 int vga_top_fd;
 
@@ -23,10 +25,128 @@ void write_tile(unsigned char r, unsigned char c, unsigned char n)
   }
 }
 
+void write_tile_rect(unsigned char r, unsigned char c, unsigned char rows, unsigned char cols, unsigned char *n)
+{
+  vga_top_arg_rect vla;
+  vla.r = r;
+  vla.c = c;
+  vla.rows = rows;
+  vla.cols = cols;
+  vla.n = n;
+  if (ioctl(vga_top_fd, VGA_TOP_WRITE_TILE_RECT, &vla)) {
+      perror("ioctl(VGA_TOP_WRITE_TILE_RECT) failed");
+      return;
+  }
+}
+
+// with defer_writes on, returns once the vblank has applied the queued writes
+void wait_vblank(void)
+{
+  unsigned long long frame;
+  if (ioctl(vga_top_fd, VGA_TOP_WAIT_VBLANK, &frame))
+    perror("ioctl(VGA_TOP_WAIT_VBLANK) failed");
+}
+
+double elapsed_us(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+// time a full screen fill the old way (one ioctl per tile) and with one rect ioctl.
+// Each starts just after a vblank, so the drain of queued writes (defer_writes)
+// doesn't land in the middle, and is timed both until the last ioctl returns
+// and until the next vblank has put the tiles on screen.
+void bench_fill(unsigned char n)
+{
+  unsigned char screen[VGA_TILE_ROWS * VGA_TILE_COLS];
+  struct timespec t0, t1, t2, t3, t4, t5;
+  int r, c;
+
+  memset(screen, n, sizeof(screen));
+  wait_vblank();
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (r = 0; r < VGA_TILE_ROWS; r++)
+    for (c = 0; c < VGA_TILE_COLS; c++)
+      write_tile(r, c, n);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  wait_vblank();
+  clock_gettime(CLOCK_MONOTONIC, &t2);
+
+  wait_vblank();
+  clock_gettime(CLOCK_MONOTONIC, &t3);
+  write_tile_rect(0, 0, VGA_TILE_ROWS, VGA_TILE_COLS, screen);
+  clock_gettime(CLOCK_MONOTONIC, &t4);
+  wait_vblank();
+  clock_gettime(CLOCK_MONOTONIC, &t5);
+
+  printf("per tile: %d ioctls, %.1f us, %.1f us until the vblank after\n",
+         VGA_TILE_ROWS * VGA_TILE_COLS, elapsed_us(&t0, &t1), elapsed_us(&t0, &t2));
+  printf("rect:     1 ioctl, %.1f us, %.1f us until the vblank after\n",
+         elapsed_us(&t3, &t4), elapsed_us(&t3, &t5));
+}
+
+// time sprite writes through the ioctl and as direct stores to the mapped
+// registers; moves sprite 0 along a row so each write changes something.
+// With defer_writes on the ioctls only queue, so that side is also timed
+// until the vblank that applies them, which is what the stores compare with.
+void bench_sprite(int count)
+{
+  vga_top_arg_s vla;
+  volatile unsigned int *regs;
+  unsigned int offset;
+  long page = sysconf(_SC_PAGESIZE);
+  struct timespec t0, t1, t2, t3, t4;
+  void *p;
+  int i;
+
+  if (ioctl(vga_top_fd, VGA_TOP_REGS_OFFSET, &offset)) {
+    perror("ioctl(VGA_TOP_REGS_OFFSET) failed");
+    return;
+  }
+  p = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_SHARED, vga_top_fd, VGA_TOP_MMAP_REGS * page);
+  if (p == MAP_FAILED) {
+    perror("mmap(/dev/vga_top) registers failed");
+    return;
+  }
+  regs = (volatile unsigned int *) ((char *) p + offset);
+
+  vla.active = 1;
+  vla.r = 200;
+  vla.n = 0;
+  vla.register_n = 0;
+  vla.flip = 0;
+  wait_vblank();
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < count; i++) {
+    vla.c = i % 600;
+    if (ioctl(vga_top_fd, VGA_TOP_WRITE_SPRITE, &vla)) {
+      perror("ioctl(VGA_TOP_WRITE_SPRITE) failed");
+      break;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  wait_vblank(); // nothing of sprite 0 is left queued to land after the clear below
+  clock_gettime(CLOCK_MONOTONIC, &t2);
+
+  clock_gettime(CLOCK_MONOTONIC, &t3);
+  for (i = 0; i < count; i++)
+    regs[VGA_REG_SPRITE(0)] = VGA_SPRITE_WORD(1, 200, i % 600, 0, 0);
+  (void) regs[VGA_REG_SPRITE(0)]; // wait for the posted stores to drain
+  clock_gettime(CLOCK_MONOTONIC, &t4);
+  regs[VGA_REG_SPRITE(0)] = 0;
+
+  printf("ioctl: %d writes, %.1f us, %.3f us each, %.1f us until the vblank after\n",
+         count, elapsed_us(&t0, &t1), elapsed_us(&t0, &t1) / count, elapsed_us(&t0, &t2));
+  printf("mmio:  %d writes, %.1f us, %.3f us each\n", count, elapsed_us(&t3, &t4), elapsed_us(&t3, &t4) / count);
+  munmap(p, page);
+}
+
 int main(int argc, char *argv[])
 {
-  if (argc != 4)
-    printf("usage: hello r c n\n");
+  if (argc != 4 && !(argc == 3 && (strcmp(argv[1], "fill") == 0 || strcmp(argv[1], "sprite") == 0))) {
+    printf("usage: hello r c n\n       hello fill n\n       hello sprite count\n");
+    return 0;
+  }
   static const char filename[] = "/dev/vga_top";
 
   printf("vga userspace program started\n");
@@ -36,7 +156,12 @@ int main(int argc, char *argv[])
     return -1;
   }
 
-  write_tile(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
+  if (argc == 3 && strcmp(argv[1], "sprite") == 0)
+    bench_sprite(atoi(argv[2]) > 0 ? atoi(argv[2]) : 1);
+  else if (argc == 3)
+    bench_fill(atoi(argv[2]));
+  else
+    write_tile(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
   
   printf("vga userspace program terminating\n");
   return 0;
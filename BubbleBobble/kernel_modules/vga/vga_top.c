@@ -13,13 +13,75 @@
 #include <linux/of_address.h>
 #include <linux/fs.h>
 #include <linux/uaccess.h>
+#include <linux/mm.h>
+#include <linux/hrtimer.h>
+#include <linux/spinlock.h>
+#include <linux/interrupt.h>
+#include <linux/of_irq.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/dma-mapping.h>
+#include <linux/delay.h>
 #include "vga_top.h"
 
+#define CREATE_TRACE_POINTS
+#include "vga_top_trace.h"
+
 #define DRIVER_NAME "vga_top"
 
 /* Device registers */
 #define WRITE_TILE(x) (x)
 #define WRITE_SPRITE(x) (x+4) // it's byte addressed
+#define VBLANK_CTRL(x) (x+48*4)
+#define VBLANK_STATUS(x) (x+49*4)
+#define SPRITE_CTRL(x) (x+51*4)
+#define SPRITE_COMMIT(x) (x+52*4)
+#define DMA_ADDR(x) (x+53*4)
+#define DMA_CTRL(x) (x+54*4)
+#define DMA_STATUS(x) (x+55*4)
+#define DMA_CYCLES(x) (x+56*4)
+#define WRITE_PALETTE(x) (x+57*4)
+
+/*
+ * Without a vblank interrupt in the device tree (or with force_stand_in,
+ * for testing on a host) an hrtimer at stand_in_hz drives the same frame
+ * logic
+ */
+static unsigned int stand_in_hz = 60;
+module_param(stand_in_hz, uint, 0444);
+MODULE_PARM_DESC(stand_in_hz, "frame rate of the timer standing in for vblank (default 60)");
+static bool force_stand_in;
+module_param(force_stand_in, bool, 0444);
+MODULE_PARM_DESC(force_stand_in, "use the timer even if the vblank irq is available");
+static bool skip_redundant = true;
+module_param(skip_redundant, bool, 0644);
+MODULE_PARM_DESC(skip_redundant, "don't write registers that already hold the value (default on)");
+static bool use_dma = true;
+module_param(use_dma, bool, 0644);
+MODULE_PARM_DESC(use_dma, "send whole screens with the display list DMA (default on)");
+static bool defer_writes = true;
+module_param(defer_writes, bool, 0644);
+MODULE_PARM_DESC(defer_writes, "queue tile, sprite and palette writes and apply them at the next vblank (default on)");
+
+/*
+ * Tile, sprite and palette writes from ioctl() and write() are queued in a
+ * ring and applied once per frame from the vblank handler, so the game
+ * never waits on the bridge. One producer at a time (ring_mutex) and one
+ * consumer (under dev.lock) share it without a lock. Entries are a type in
+ * the top two bits and:
+ *   tile:    r << 16 | c << 8 | n
+ *   sprite:  register_n << 32 | register value
+ *   palette: entry << 16 | colour
+ */
+#define VGA_TOP_RING_SIZE 4096 // a power of 2, more than a whole screen of tiles
+#define RING_TILE	(0ull << 62)
+#define RING_SPRITE	(1ull << 62)
+#define RING_COMMIT	(2ull << 62)
+#define RING_PALETTE	(3ull << 62)
+#define RING_TYPE(e)	((e) & (3ull << 62))
 
 /*
  * Information about our device
@@ -27,30 +89,631 @@
 struct vga_top_dev {
 	struct resource res; /* Resource: our registers */
 	void __iomem *virtbase; /* Where registers can be accessed in memory */
+	spinlock_t lock; /* Serializes register writes between ioctls and the flush */
+	unsigned char hw_tiles[VGA_TILE_ROWS][VGA_TILE_COLS]; /* What the tile array holds */
+	unsigned int hw_sprites[VGA_NUM_SPRITES]; /* What the sprite registers hold */
+	/* Cells and registers written since probe; the rest hold unknown values */
+	DECLARE_BITMAP(tile_known, VGA_TILE_ROWS * VGA_TILE_COLS);
+	DECLARE_BITMAP(sprite_known, VGA_NUM_SPRITES);
+	vga_top_shadow_t *shadow; /* Page userspace mmap()s and writes tiles into */
+	int shadow_maps; /* Live mappings of the shadow page */
+	int regs_maps; /* Live mappings of the registers; hw_tiles and hw_sprites can't be trusted */
+	vga_top_frame_t *dma_frame; /* Coherent copy of the screen the DMA fetches, NULL without DMA */
+	dma_addr_t dma_handle;
+	unsigned int dma_parts; /* VGA_FRAME_* asked for since the DMA took over */
+	u64 dma_until; /* Frame by which the last transfer asked for is over */
+	u64 ring[VGA_TOP_RING_SIZE]; /* Writes waiting for the next vblank */
+	unsigned int ring_head, ring_tail; /* Free running, the producer owns head */
+	unsigned int ring_max_depth;
+	struct mutex ring_mutex; /* Keeps producers one at a time */
+	/* Last value per cell, sprite register and palette entry while draining the ring */
+	unsigned char ring_tiles[VGA_TILE_ROWS][VGA_TILE_COLS];
+	DECLARE_BITMAP(ring_tiles_set, VGA_TILE_ROWS * VGA_TILE_COLS);
+	unsigned int ring_sprites[VGA_NUM_SPRITES];
+	DECLARE_BITMAP(ring_sprites_set, VGA_NUM_SPRITES);
+	unsigned short ring_palette[VGA_PALETTE_SIZE];
+	DECLARE_BITMAP(ring_palette_set, VGA_PALETTE_SIZE);
+	int irq; /* vblank interrupt, 0 when the stand-in timer is used */
+	struct hrtimer stand_in_timer; /* Fake vblank when there is no irq */
+	atomic64_t frame; /* vblanks since probe */
+	wait_queue_head_t vblank_wait; /* Woken on every vblank */
+	struct dentry *debugfs; /* /sys/kernel/debug/vga_top */
 } dev;
 
+/*
+ * Statistics in debugfs: calls per ioctl command, bytes copied in from
+ * userspace and a histogram of ioctl latency. Bucket i counts calls that
+ * took [2^(i-1), 2^i) ns, i.e. bucket 10 is 512-1023 ns.
+ */
+#define VGA_TOP_NR_CMDS 16
+#define VGA_TOP_LAT_BUCKETS 32
+
+static struct {
+	atomic64_t calls[VGA_TOP_NR_CMDS];
+	atomic64_t bytes_in;
+	atomic64_t latency[VGA_TOP_LAT_BUCKETS];
+	atomic64_t dl_writes; /* display lists submitted with write() */
+	atomic64_t dl_cmds; /* commands run from them */
+	/* register writes skipped because the value was already there (hit) or issued (miss) */
+	atomic64_t tile_hits, tile_misses;
+	atomic64_t sprite_hits, sprite_misses;
+	atomic64_t dma_starts; /* transfers asked of the display list DMA */
+	atomic64_t ring_merged; /* queued writes overtaken by a later one in the same frame */
+	atomic64_t ring_overflows; /* times a full ring was applied early */
+} stats;
 
-static void write_tile(unsigned char r, unsigned char c, unsigned char n)
+static const char *const cmd_names[VGA_TOP_NR_CMDS] = {
+	[_IOC_NR(VGA_TOP_WRITE_TILE)] = "write_tile",
+	[_IOC_NR(VGA_TOP_WRITE_SPRITE)] = "write_sprite",
+	[_IOC_NR(VGA_TOP_WRITE_TILES)] = "write_tiles",
+	[_IOC_NR(VGA_TOP_WRITE_TILE_RECT)] = "write_tile_rect",
+	[_IOC_NR(VGA_TOP_WAIT_VBLANK)] = "wait_vblank",
+	[_IOC_NR(VGA_TOP_SPRITE_LATCH)] = "sprite_latch",
+	[_IOC_NR(VGA_TOP_COMMIT)] = "commit",
+	[_IOC_NR(VGA_TOP_WRITE_FRAME)] = "write_frame",
+	[_IOC_NR(VGA_TOP_REGS_OFFSET)] = "regs_offset",
+	[_IOC_NR(VGA_TOP_WRITE_PALETTE)] = "write_palette",
+};
+
+
+/*
+ * From asking for a transfer until it is certainly over (it runs early in
+ * the next vertical blank) the tile array and sprite registers belong to
+ * the DMA. Writes in that window go to the buffer and ask for another
+ * transfer instead of racing the one in flight over the bridge.
+ */
+static bool dma_owns_locked(void)
+{
+	return dev.dma_frame && atomic64_read(&dev.frame) < dev.dma_until;
+}
+
+static void dma_start_locked(unsigned int parts)
+{
+	u64 frame = atomic64_read(&dev.frame);
+
+	if (frame >= dev.dma_until)
+		dev.dma_parts = 0;
+	dev.dma_parts |= parts;
+	dev.dma_until = frame + 2;
+	iowrite32(dev.dma_parts, DMA_CTRL(dev.virtbase));
+	atomic64_inc(&stats.dma_starts);
+}
+
+static void write_tile_locked(unsigned char r, unsigned char c, unsigned char n)
 {
+	unsigned int cell = r * VGA_TILE_COLS + c;
+	bool tracked = r < VGA_TILE_ROWS && c < VGA_TILE_COLS;
+
+	if (tracked && skip_redundant && !dev.regs_maps && test_bit(cell, dev.tile_known) &&
+	    dev.hw_tiles[r][c] == n) {
+		atomic64_inc(&stats.tile_hits);
+		return;
+	}
+	atomic64_inc(&stats.tile_misses);
+
+	if (tracked && dev.dma_frame)
+		dev.dma_frame->tiles[r][c] = n; // the DMA buffer always matches the screen
+	if (tracked && dma_owns_locked()) {
+		dma_start_locked(VGA_FRAME_TILES);
+	} else {
   // 5bit r, 6bit c, 8bit n 
 	iowrite32(((unsigned int) r << 14) + ((unsigned int) c << 8) + n, WRITE_TILE(dev.virtbase) );
+	}
+	trace_vga_top_write_tile(r, c, n);
+	if (tracked) {
+		dev.hw_tiles[r][c] = n;
+		set_bit(cell, dev.tile_known);
+	}
 }
 
-static void write_sprite(unsigned char active, unsigned short r, unsigned short c, unsigned char n, unsigned short register_n)
+static void write_sprite_locked(unsigned short register_n, unsigned int value)
+{
+	if (skip_redundant && !dev.regs_maps && test_bit(register_n, dev.sprite_known) &&
+	    dev.hw_sprites[register_n] == value) {
+		atomic64_inc(&stats.sprite_hits);
+		return;
+	}
+	atomic64_inc(&stats.sprite_misses);
+
+	if (dev.dma_frame)
+		dev.dma_frame->sprites[register_n] = value;
+	if (dma_owns_locked())
+		dma_start_locked(VGA_FRAME_SPRITES);
+	else
+		iowrite32(value, WRITE_SPRITE(dev.virtbase + register_n*4)); // byte addressed
+	trace_vga_top_write_sprite(register_n, value);
+	dev.hw_sprites[register_n] = value;
+	set_bit(register_n, dev.sprite_known);
+}
+
+/*
+ * The palette is only read by the display, so entries never go through
+ * the DMA and there is nothing to skip: palette.mif, not the driver,
+ * decides what they hold after reset
+ */
+static void write_palette_locked(unsigned char entry, unsigned short colour)
+{
+	iowrite32(VGA_PALETTE_WORD(entry, colour), WRITE_PALETTE(dev.virtbase));
+}
+
+/*
+ * Write the cells, sprite registers and palette entries merged so far,
+ * each once with its last value. Returns the number of register writes.
+ */
+static unsigned int flush_merged_locked(void)
+{
+	unsigned int writes = 0;
+	unsigned int cell, i;
+
+	for_each_set_bit(cell, dev.ring_tiles_set, VGA_TILE_ROWS * VGA_TILE_COLS) {
+		write_tile_locked(cell / VGA_TILE_COLS, cell % VGA_TILE_COLS,
+				  dev.ring_tiles[cell / VGA_TILE_COLS][cell % VGA_TILE_COLS]);
+		writes++;
+	}
+	bitmap_zero(dev.ring_tiles_set, VGA_TILE_ROWS * VGA_TILE_COLS);
+	for_each_set_bit(i, dev.ring_sprites_set, VGA_NUM_SPRITES) {
+		write_sprite_locked(i, dev.ring_sprites[i]);
+		writes++;
+	}
+	bitmap_zero(dev.ring_sprites_set, VGA_NUM_SPRITES);
+	for_each_set_bit(i, dev.ring_palette_set, VGA_PALETTE_SIZE) {
+		write_palette_locked(i, dev.ring_palette[i]);
+		writes++;
+	}
+	bitmap_zero(dev.ring_palette_set, VGA_PALETTE_SIZE);
+	return writes;
+}
+
+/*
+ * Apply everything queued so far, in order. Writes are merged up to each
+ * commit, so a commit covers the sprites queued before it and none after.
+ */
+static void drain_ring_locked(void)
+{
+	unsigned int head = smp_load_acquire(&dev.ring_head);
+	unsigned int tail = dev.ring_tail;
+	unsigned int entries = head - tail, writes = 0;
+	unsigned int i, r, c;
+	u64 e;
+
+	if (entries == 0)
+		return;
+
+	for (; tail != head; tail++) {
+		e = dev.ring[tail % VGA_TOP_RING_SIZE];
+		switch (RING_TYPE(e)) {
+		case RING_TILE:
+			r = (e >> 16) & 0xff;
+			c = (e >> 8) & 0xff;
+			if (r < VGA_TILE_ROWS && c < VGA_TILE_COLS) {
+				dev.ring_tiles[r][c] = e & 0xff;
+				set_bit(r * VGA_TILE_COLS + c, dev.ring_tiles_set);
+			} else {
+				write_tile_locked(r, c, e & 0xff); // not tracked, can't be merged
+				writes++;
+			}
+			break;
+		case RING_SPRITE:
+			i = (e >> 32) & 0x1f;
+			dev.ring_sprites[i] = (u32) e;
+			set_bit(i, dev.ring_sprites_set);
+			break;
+		case RING_COMMIT:
+			writes += flush_merged_locked();
+			iowrite32(1, SPRITE_COMMIT(dev.virtbase)); // after the sprites it covers
+			writes++;
+			break;
+		case RING_PALETTE:
+			i = (e >> 16) & 0xff;
+			dev.ring_palette[i] = e & 0xffff;
+			set_bit(i, dev.ring_palette_set);
+			break;
+		}
+	}
+	smp_store_release(&dev.ring_tail, tail);
+
+	writes += flush_merged_locked();
+	atomic64_add(entries - writes, &stats.ring_merged);
+}
+
+static void drain_ring(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked();
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+/*
+ * Queue one write for the next vblank. A full ring is applied right away
+ * instead: that frame may tear, but no write is lost or reordered.
+ */
+static void ring_push(u64 e)
+{
+	unsigned int head, depth;
+
+	mutex_lock(&dev.ring_mutex);
+	head = dev.ring_head;
+	if (head - smp_load_acquire(&dev.ring_tail) >= VGA_TOP_RING_SIZE) {
+		atomic64_inc(&stats.ring_overflows);
+		drain_ring();
+	}
+	dev.ring[head % VGA_TOP_RING_SIZE] = e;
+	smp_store_release(&dev.ring_head, head + 1);
+	depth = head + 1 - READ_ONCE(dev.ring_tail);
+	if (depth > dev.ring_max_depth)
+		dev.ring_max_depth = depth;
+	mutex_unlock(&dev.ring_mutex);
+}
+
+static void write_tile(unsigned char r, unsigned char c, unsigned char n)
+{
+	unsigned long flags;
+
+	if (defer_writes) {
+		ring_push(RING_TILE | ((u32) r << 16) | ((u32) c << 8) | n);
+		return;
+	}
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked(); // anything still queued goes first
+	write_tile_locked(r, c, n);
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static void write_sprite(unsigned char active, unsigned short r, unsigned short c, unsigned char n, unsigned short register_n, unsigned char flip)
 {
 	unsigned int r_mask = (1 << 9) - 1;
 	unsigned int c_mask = (1 << 10) - 1;
 	unsigned int n_mask = (1 << 5) - 1;
-        printk("act:%i   r:%i  c:%i  n:%i  register_n:%i   address:%i\n", active, r, c, n, register_n, WRITE_SPRITE(dev.virtbase + register_n) - dev.virtbase);
-        printk("Hex form: %x\n",   ((unsigned int) active << 24) + 
+	// 2bit flip, 1bit active, 9bit r, 10bit c, 5bit n
+	unsigned int value = ((unsigned int) (flip & (VGA_SPRITE_FLIP_H | VGA_SPRITE_FLIP_V)) << 25) +
+				((unsigned int) active << 24) + 
 				((unsigned int) ((r & r_mask) << 15)) +
 				((unsigned int) ((c & c_mask) << 5)) +
-				((unsigned int) (n & n_mask)));
-	// 1bit active, 9bit r, 10bit c, 5bit n
-	iowrite32( ((unsigned int) active << 24) + 
-				((unsigned int) ((r & r_mask) << 15)) +
-				((unsigned int) ((c & c_mask) << 5)) +
-				((unsigned int) (n & n_mask)), WRITE_SPRITE(dev.virtbase + register_n*4)); // byte addressed
+				((unsigned int) (n & n_mask));
+	unsigned long flags;
+
+	if (defer_writes) {
+		ring_push(RING_SPRITE | ((u64) register_n << 32) | value);
+		return;
+	}
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked();
+	write_sprite_locked(register_n, value);
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static void write_palette(unsigned char entry, unsigned short colour)
+{
+	unsigned long flags;
+
+	if (defer_writes) {
+		ring_push(RING_PALETTE | ((u32) entry << 16) | colour);
+		return;
+	}
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked();
+	write_palette_locked(entry, colour);
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+/* Latched sprites go on screen together, after the writes queued before this */
+static void commit_sprites(void)
+{
+	if (defer_writes) {
+		ring_push(RING_COMMIT);
+		return;
+	}
+	drain_ring();
+	iowrite32(1, SPRITE_COMMIT(dev.virtbase));
+}
+
+/* Latching applies to the writes after it, so the queued ones go out first */
+static void latch_sprites(bool latch)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked();
+	iowrite32(latch ? 1 : 0, SPRITE_CTRL(dev.virtbase));
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+/*
+ * Write a batch of tiles that has already been copied into the kernel,
+ * one iowrite32 per record and no per-tile syscall or copy_from_user
+ */
+static void write_tiles(const vga_top_arg_t *tiles, unsigned int count)
+{
+	unsigned int i;
+	for (i = 0; i < count; i++)
+		write_tile(tiles[i].r, tiles[i].c, tiles[i].n);
+}
+
+static void write_tile_rect(const vga_top_arg_rect *rect, const unsigned char *n)
+{
+	unsigned int i, j;
+	for (i = 0; i < rect->rows; i++)
+		for (j = 0; j < rect->cols; j++)
+			write_tile(rect->r + i, rect->c + j, n[i * rect->cols + j]);
+}
+
+/*
+ * Show a whole screen: copy it into the DMA buffer and let the hardware
+ * fetch it at the next vblank, or without DMA write what changed
+ */
+static void write_frame(const vga_top_frame_t *frame, unsigned int parts)
+{
+	unsigned long flags;
+	int r, c, i;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	drain_ring_locked(); // queued writes are older than this screen
+	if (dev.dma_frame && use_dma && !dev.regs_maps) {
+		if (parts & VGA_FRAME_TILES) {
+			memcpy(dev.dma_frame->tiles, frame->tiles, sizeof(frame->tiles));
+			memcpy(dev.hw_tiles, frame->tiles, sizeof(frame->tiles));
+			bitmap_fill(dev.tile_known, VGA_TILE_ROWS * VGA_TILE_COLS);
+		}
+		if (parts & VGA_FRAME_SPRITES) {
+			memcpy(dev.dma_frame->sprites, frame->sprites, sizeof(frame->sprites));
+			memcpy(dev.hw_sprites, frame->sprites, sizeof(frame->sprites));
+			bitmap_fill(dev.sprite_known, VGA_NUM_SPRITES);
+		}
+		dma_start_locked(parts);
+	} else {
+		if (parts & VGA_FRAME_TILES)
+			for (r = 0; r < VGA_TILE_ROWS; r++)
+				for (c = 0; c < VGA_TILE_COLS; c++)
+					write_tile_locked(r, c, frame->tiles[r][c]);
+		if (parts & VGA_FRAME_SPRITES)
+			for (i = 0; i < VGA_NUM_SPRITES; i++)
+				write_sprite_locked(i, frame->sprites[i]);
+	}
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+/*
+ * Push the rows userspace marked dirty in the shadow page, writing only
+ * the cells that differ from what the tile array already holds. With the
+ * DMA the rows go into its buffer and the hardware fetches them in this
+ * same vblank.
+ */
+static void flush_shadow(void)
+{
+	unsigned long flags;
+	unsigned int dirty;
+	int r, c;
+
+	dirty = xchg(&dev.shadow->dirty_rows, 0);
+	if (!dirty)
+		return;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	if (dev.dma_frame && use_dma && !dev.regs_maps) {
+		for (r = 0; r < VGA_TILE_ROWS; r++) {
+			if (!(dirty & (1u << r)))
+				continue;
+			memcpy(dev.dma_frame->tiles[r], dev.shadow->tiles[r], VGA_TILE_COLS);
+			memcpy(dev.hw_tiles[r], dev.shadow->tiles[r], VGA_TILE_COLS);
+		}
+		// the transfer rewrites every cell, so all of them are known now
+		bitmap_fill(dev.tile_known, VGA_TILE_ROWS * VGA_TILE_COLS);
+		dma_start_locked(VGA_FRAME_TILES);
+		spin_unlock_irqrestore(&dev.lock, flags);
+		return;
+	}
+	for (r = 0; r < VGA_TILE_ROWS; r++) {
+		if (!(dirty & (1u << r)))
+			continue;
+		for (c = 0; c < VGA_TILE_COLS; c++)
+			write_tile_locked(r, c, dev.shadow->tiles[r][c]);
+	}
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+/*
+ * Once per frame, at the start of vertical blank: apply the queued
+ * writes, push the shadow tilemap and wake everyone waiting for the frame
+ */
+static void vga_top_vblank(void)
+{
+	drain_ring();
+	if (READ_ONCE(dev.shadow_maps))
+		flush_shadow();
+	atomic64_inc(&dev.frame);
+	wake_up_interruptible(&dev.vblank_wait);
+}
+
+static irqreturn_t vga_top_irq(int irq, void *dev_id)
+{
+	if (!(ioread32(VBLANK_STATUS(dev.virtbase)) & 1))
+		return IRQ_NONE;
+	iowrite32(1, VBLANK_STATUS(dev.virtbase));
+	vga_top_vblank();
+	return IRQ_HANDLED;
+}
+
+static enum hrtimer_restart stand_in_timer_fn(struct hrtimer *t)
+{
+	vga_top_vblank();
+	hrtimer_forward_now(t, ns_to_ktime(NSEC_PER_SEC / stand_in_hz));
+	return HRTIMER_RESTART;
+}
+
+/*
+ * Each vblank flushes the shadow page while someone has it mapped.
+ * The first mapping starts from the tiles the ioctls have already written.
+ */
+static void shadow_vm_open(struct vm_area_struct *vma)
+{
+	unsigned long flags;
+	int first;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	first = dev.shadow_maps++ == 0;
+	if (first) {
+		memcpy(dev.shadow->tiles, dev.hw_tiles, sizeof(dev.hw_tiles));
+		dev.shadow->dirty_rows = 0;
+	}
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static void shadow_vm_close(struct vm_area_struct *vma)
+{
+	unsigned long flags;
+	int last;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	last = --dev.shadow_maps == 0;
+	spin_unlock_irqrestore(&dev.lock, flags);
+
+	if (last)
+		flush_shadow(); // don't lose the last frame
+}
+
+static const struct vm_operations_struct shadow_vm_ops = {
+	.open	= shadow_vm_open,
+	.close	= shadow_vm_close,
+};
+
+/*
+ * Stores through a register mapping bypass the driver, so while one
+ * lives it forgets what the hardware holds: no skipped writes and no
+ * DMA transfers that would put back stale cells.
+ */
+static void regs_vm_open(struct vm_area_struct *vma)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	dev.regs_maps++;
+	bitmap_zero(dev.tile_known, VGA_TILE_ROWS * VGA_TILE_COLS);
+	bitmap_zero(dev.sprite_known, VGA_NUM_SPRITES);
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static void regs_vm_close(struct vm_area_struct *vma)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev.lock, flags);
+	dev.regs_maps--;
+	bitmap_zero(dev.tile_known, VGA_TILE_ROWS * VGA_TILE_COLS);
+	bitmap_zero(dev.sprite_known, VGA_NUM_SPRITES);
+	spin_unlock_irqrestore(&dev.lock, flags);
+}
+
+static const struct vm_operations_struct regs_vm_ops = {
+	.open	= regs_vm_open,
+	.close	= regs_vm_close,
+};
+
+/*
+ * Map the page holding the registers, uncached, so the game can write
+ * tiles and sprites with plain stores and no syscall. The page is the
+ * bridge's, whatever else sits in it is reachable too.
+ */
+static int regs_mmap(struct vm_area_struct *vma)
+{
+	int ret;
+
+	if (vma->vm_end - vma->vm_start > PAGE_SIZE)
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	ret = io_remap_pfn_range(vma, vma->vm_start, dev.res.start >> PAGE_SHIFT,
+				 vma->vm_end - vma->vm_start, vma->vm_page_prot);
+	if (ret)
+		return ret;
+
+	vma->vm_ops = &regs_vm_ops;
+	regs_vm_open(vma);
+	return 0;
+}
+
+/*
+ * Map the shadow tilemap (vga_top_shadow_t) or the registers into userspace
+ */
+static int vga_top_mmap(struct file *f, struct vm_area_struct *vma)
+{
+	int ret;
+
+	if (vma->vm_pgoff == VGA_TOP_MMAP_REGS)
+		return regs_mmap(vma);
+	if (vma->vm_pgoff != VGA_TOP_MMAP_SHADOW || vma->vm_end - vma->vm_start > PAGE_SIZE)
+		return -EINVAL;
+
+	ret = remap_pfn_range(vma, vma->vm_start, virt_to_phys(dev.shadow) >> PAGE_SHIFT,
+			      vma->vm_end - vma->vm_start, vma->vm_page_prot);
+	if (ret)
+		return ret;
+
+	vma->vm_ops = &shadow_vm_ops;
+	shadow_vm_open(vma);
+	return 0;
+}
+
+/*
+ * Each open file remembers the last frame it has seen, so read() and
+ * poll() report every new frame exactly once
+ */
+static int vga_top_open(struct inode *inode, struct file *f)
+{
+	u64 *seen = kmalloc(sizeof(u64), GFP_KERNEL);
+
+	if (seen == NULL)
+		return -ENOMEM;
+	*seen = atomic64_read(&dev.frame);
+	f->private_data = seen;
+	return 0;
+}
+
+static int vga_top_release(struct inode *inode, struct file *f)
+{
+	kfree(f->private_data);
+	return 0;
+}
+
+/* Block until the frame counter moves past *seen, then return it */
+static int wait_frame(u64 *seen, bool nonblock, u64 *frame)
+{
+	int ret;
+
+	if (atomic64_read(&dev.frame) == *seen && nonblock)
+		return -EAGAIN;
+	ret = wait_event_interruptible(dev.vblank_wait, atomic64_read(&dev.frame) != *seen);
+	if (ret)
+		return ret;
+	*frame = *seen = atomic64_read(&dev.frame);
+	return 0;
+}
+
+/* read(): the 64-bit frame counter, once per new frame */
+static ssize_t vga_top_read(struct file *f, char __user *buf, size_t count, loff_t *off)
+{
+	u64 frame;
+	int ret;
+
+	if (count < sizeof(frame))
+		return -EINVAL;
+	ret = wait_frame(f->private_data, f->f_flags & O_NONBLOCK, &frame);
+	if (ret)
+		return ret;
+	if (copy_to_user(buf, &frame, sizeof(frame)))
+		return -EFAULT;
+	return sizeof(frame);
+}
+
+static __poll_t vga_top_poll(struct file *f, poll_table *wait)
+{
+	u64 *seen = f->private_data;
+
+	poll_wait(f, &dev.vblank_wait, wait);
+	if (atomic64_read(&dev.frame) != *seen)
+		return POLLIN | POLLRDNORM;
+	return 0;
 }
 
 /*
@@ -58,21 +721,106 @@ static void write_sprite(unsigned char active, unsigned short r, unsigned short
  * Read or write the segments on single digits.
  * Note extensive error checking of arguments
  */
-static long vga_top_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
+static long vga_top_do_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
   vga_top_arg_t vlat;
   vga_top_arg_s vlas;
+  vga_top_arg_tiles vlts;
+  vga_top_arg_rect vlar;
+  vga_top_arg_frame vlaf;
+  vga_top_arg_palette vlap;
+  unsigned int offset, i;
+  void *buf;
+  u64 frame, start;
+  int ret;
 	switch (cmd) {
 	  case VGA_TOP_WRITE_TILE:
 		  if (copy_from_user(&vlat, (vga_top_arg_t *) arg, sizeof(vga_top_arg_t)))
 			  return -EACCES;
+		  atomic64_add(sizeof(vga_top_arg_t), &stats.bytes_in);
 		  write_tile(vlat.r, vlat.c, vlat.n);
 		  break;
           case VGA_TOP_WRITE_SPRITE:
-                  printk("writing sprite:  ");
                   if (copy_from_user(&vlas, (vga_top_arg_s *) arg, sizeof(vga_top_arg_s)))
 			  return -EACCES;
-		  write_sprite(vlas.active, vlas.r, vlas.c, vlas.n, vlas.register_n);
+		  atomic64_add(sizeof(vga_top_arg_s), &stats.bytes_in);
+		  if (vlas.register_n >= VGA_NUM_SPRITES || vlas.n >= VGA_SPRITE_IMAGES ||
+		      vlas.flip & ~(VGA_SPRITE_FLIP_H | VGA_SPRITE_FLIP_V))
+			  return -EINVAL;
+		  write_sprite(vlas.active, vlas.r, vlas.c, vlas.n, vlas.register_n, vlas.flip);
+		  break;
+	  case VGA_TOP_WRITE_TILES:
+		  if (copy_from_user(&vlts, (vga_top_arg_tiles *) arg, sizeof(vga_top_arg_tiles)))
+			  return -EACCES;
+		  if (vlts.count == 0 || vlts.count > VGA_TILE_ROWS * VGA_TILE_COLS)
+			  return -EINVAL;
+		  // one copy for the whole batch
+		  buf = memdup_user(vlts.tiles, vlts.count * sizeof(vga_top_arg_t));
+		  if (IS_ERR(buf))
+			  return PTR_ERR(buf);
+		  atomic64_add(sizeof(vlts) + vlts.count * sizeof(vga_top_arg_t), &stats.bytes_in);
+		  write_tiles(buf, vlts.count);
+		  kfree(buf);
+		  break;
+	  case VGA_TOP_WRITE_TILE_RECT:
+		  if (copy_from_user(&vlar, (vga_top_arg_rect *) arg, sizeof(vga_top_arg_rect)))
+			  return -EACCES;
+		  if (vlar.rows == 0 || vlar.cols == 0 ||
+		      vlar.r + vlar.rows > VGA_TILE_ROWS || vlar.c + vlar.cols > VGA_TILE_COLS)
+			  return -EINVAL;
+		  buf = memdup_user(vlar.n, vlar.rows * vlar.cols);
+		  if (IS_ERR(buf))
+			  return PTR_ERR(buf);
+		  atomic64_add(sizeof(vlar) + vlar.rows * vlar.cols, &stats.bytes_in);
+		  write_tile_rect(&vlar, buf);
+		  kfree(buf);
+		  break;
+	  case VGA_TOP_WRITE_FRAME:
+		  if (copy_from_user(&vlaf, (vga_top_arg_frame *) arg, sizeof(vga_top_arg_frame)))
+			  return -EACCES;
+		  if (vlaf.parts == 0 || (vlaf.parts & ~(VGA_FRAME_TILES | VGA_FRAME_SPRITES)))
+			  return -EINVAL;
+		  buf = memdup_user(vlaf.frame, sizeof(vga_top_frame_t));
+		  if (IS_ERR(buf))
+			  return PTR_ERR(buf);
+		  atomic64_add(sizeof(vlaf) + sizeof(vga_top_frame_t), &stats.bytes_in);
+		  write_frame(buf, vlaf.parts);
+		  kfree(buf);
+		  break;
+	  case VGA_TOP_WRITE_PALETTE:
+		  if (copy_from_user(&vlap, (vga_top_arg_palette *) arg, sizeof(vga_top_arg_palette)))
+			  return -EACCES;
+		  if (vlap.count == 0 || vlap.first >= VGA_PALETTE_SIZE ||
+		      vlap.count > VGA_PALETTE_SIZE - vlap.first)
+			  return -EINVAL;
+		  buf = memdup_user(vlap.colours, vlap.count * sizeof(unsigned short));
+		  if (IS_ERR(buf))
+			  return PTR_ERR(buf);
+		  atomic64_add(sizeof(vlap) + vlap.count * sizeof(unsigned short), &stats.bytes_in);
+		  for (i = 0; i < vlap.count; i++)
+			  write_palette(vlap.first + i, ((unsigned short *) buf)[i]);
+		  kfree(buf);
+		  break;
+	  case VGA_TOP_REGS_OFFSET:
+		  offset = dev.res.start & ~PAGE_MASK;
+		  if (copy_to_user((unsigned int *) arg, &offset, sizeof(offset)))
+			  return -EACCES;
+		  break;
+	  case VGA_TOP_WAIT_VBLANK:
+		  // always waits for the next vblank, independent of read()
+		  start = atomic64_read(&dev.frame);
+		  ret = wait_frame(&start, false, &frame);
+		  if (ret)
+			  return ret;
+		  if (copy_to_user((unsigned long long *) arg, &frame, sizeof(frame)))
+			  return -EACCES;
+		  break;
+	  case VGA_TOP_SPRITE_LATCH:
+		  latch_sprites(arg != 0);
+		  break;
+	  case VGA_TOP_COMMIT:
+		  // the hardware copies all sprites at once in vblank
+		  commit_sprites();
 		  break;
 	  default:
 		  return -EINVAL;
@@ -81,10 +829,206 @@ static long vga_top_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 	return 0;
 }
 
+/*
+ * Size of the display list command starting with opcode op, 0 if unknown
+ */
+static size_t dl_cmd_size(unsigned char op)
+{
+	switch (op) {
+	case VGA_DL_TILE:		return sizeof(vga_dl_tile);
+	case VGA_DL_TILE_FILL:		return sizeof(vga_dl_tile_fill);
+	case VGA_DL_SPRITE:		return sizeof(vga_dl_sprite);
+	case VGA_DL_SPRITE_HIDE:	return sizeof(vga_dl_sprite_hide);
+	case VGA_DL_COMMIT:		return sizeof(vga_dl_commit);
+	case VGA_DL_PALETTE:		return sizeof(vga_dl_palette);
+	default:			return 0;
+	}
+}
+
+/*
+ * Validate and run one command; returns false if it is malformed
+ */
+static bool dl_run(const unsigned char *p)
+{
+	const vga_dl_tile *t = (const void *) p;
+	const vga_dl_tile_fill *tf = (const void *) p;
+	const vga_dl_sprite *sp = (const void *) p;
+	const vga_dl_sprite_hide *sh = (const void *) p;
+	const vga_dl_palette *pl = (const void *) p;
+	unsigned int i, j;
+
+	switch (p[0]) {
+	case VGA_DL_TILE:
+		if (t->r >= VGA_TILE_ROWS || t->c >= VGA_TILE_COLS)
+			return false;
+		write_tile(t->r, t->c, t->n);
+		break;
+	case VGA_DL_TILE_FILL:
+		if (tf->rows == 0 || tf->cols == 0 ||
+		    tf->r + tf->rows > VGA_TILE_ROWS || tf->c + tf->cols > VGA_TILE_COLS)
+			return false;
+		for (i = 0; i < tf->rows; i++)
+			for (j = 0; j < tf->cols; j++)
+				write_tile(tf->r + i, tf->c + j, tf->n);
+		break;
+	case VGA_DL_SPRITE:
+		if (sp->register_n >= VGA_NUM_SPRITES || sp->n >= VGA_SPRITE_IMAGES ||
+		    sp->flip & ~(VGA_SPRITE_FLIP_H | VGA_SPRITE_FLIP_V))
+			return false;
+		write_sprite(1, le16_to_cpu(sp->r), le16_to_cpu(sp->c), sp->n, sp->register_n, sp->flip);
+		break;
+	case VGA_DL_SPRITE_HIDE:
+		if (sh->register_n >= VGA_NUM_SPRITES)
+			return false;
+		write_sprite(0, 0, 0, 0, sh->register_n, 0);
+		break;
+	case VGA_DL_COMMIT:
+		commit_sprites();
+		break;
+	case VGA_DL_PALETTE:
+		write_palette(pl->entry, le16_to_cpu(pl->colour));
+		break;
+	}
+	return true;
+}
+
+/*
+ * write(): run a whole display list with a single copy from userspace.
+ * Stops at the first bad or truncated command and reports how far it got.
+ */
+static ssize_t vga_top_write(struct file *f, const char __user *ubuf, size_t count, loff_t *off)
+{
+	unsigned char *buf;
+	size_t pos = 0, size;
+
+	if (count == 0)
+		return 0;
+	if (count > VGA_DL_MAX)
+		count = VGA_DL_MAX;
+
+	buf = memdup_user(ubuf, count);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+	atomic64_add(count, &stats.bytes_in);
+	atomic64_inc(&stats.dl_writes);
+
+	while (pos < count) {
+		size = dl_cmd_size(buf[pos]);
+		if (size == 0 || pos + size > count || !dl_run(buf + pos))
+			break;
+		atomic64_inc(&stats.dl_cmds);
+		pos += size;
+	}
+
+	kfree(buf);
+	if (pos == 0)
+		return -EINVAL;
+	return pos;
+}
+
+/*
+ * Count every command and time everything except the vblank wait,
+ * which measures the display rather than the driver
+ */
+static long vga_top_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
+{
+	u64 start = ktime_get_ns();
+	long ret = vga_top_do_ioctl(f, cmd, arg);
+
+	if (_IOC_NR(cmd) < VGA_TOP_NR_CMDS)
+		atomic64_inc(&stats.calls[_IOC_NR(cmd)]);
+	if (cmd != VGA_TOP_WAIT_VBLANK)
+		atomic64_inc(&stats.latency[min(fls64(ktime_get_ns() - start), VGA_TOP_LAT_BUCKETS - 1)]);
+	return ret;
+}
+
+static int stats_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	seq_puts(m, "command          calls\n");
+	for (i = 0; i < VGA_TOP_NR_CMDS; i++)
+		if (cmd_names[i])
+			seq_printf(m, "%-16s %llu\n", cmd_names[i],
+				   (unsigned long long) atomic64_read(&stats.calls[i]));
+	seq_printf(m, "\nbytes_in         %llu\n",
+		   (unsigned long long) atomic64_read(&stats.bytes_in));
+	seq_printf(m, "dl_writes        %llu\n",
+		   (unsigned long long) atomic64_read(&stats.dl_writes));
+	seq_printf(m, "dl_cmds          %llu\n",
+		   (unsigned long long) atomic64_read(&stats.dl_cmds));
+	seq_printf(m, "frames           %llu\n",
+		   (unsigned long long) atomic64_read(&dev.frame));
+	seq_puts(m, "\nregister writes  skipped  issued\n");
+	seq_printf(m, "tile             %-8llu %llu\n",
+		   (unsigned long long) atomic64_read(&stats.tile_hits),
+		   (unsigned long long) atomic64_read(&stats.tile_misses));
+	seq_printf(m, "sprite           %-8llu %llu\n",
+		   (unsigned long long) atomic64_read(&stats.sprite_hits),
+		   (unsigned long long) atomic64_read(&stats.sprite_misses));
+	if (dev.dma_frame) {
+		seq_printf(m, "\ndma_starts       %llu\n",
+			   (unsigned long long) atomic64_read(&stats.dma_starts));
+		seq_printf(m, "dma_last_cycles  %u\n", ioread32(DMA_CYCLES(dev.virtbase)));
+		seq_printf(m, "dma_overrun      %u\n", (ioread32(DMA_STATUS(dev.virtbase)) >> 1) & 1);
+	}
+
+	seq_puts(m, "\nlatency_ns       calls\n");
+	for (i = 0; i < VGA_TOP_LAT_BUCKETS; i++)
+		if (atomic64_read(&stats.latency[i]))
+			seq_printf(m, "< %-14llu %llu\n", 1ULL << i,
+				   (unsigned long long) atomic64_read(&stats.latency[i]));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+/*
+ * Ring statistics in /sys/class/misc/vga_top: entries waiting now, the
+ * most ever waiting, and how often the ring filled up
+ */
+static ssize_t ring_depth_show(struct device *d, struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(dev.ring_head) - READ_ONCE(dev.ring_tail));
+}
+static DEVICE_ATTR_RO(ring_depth);
+
+static ssize_t ring_max_depth_show(struct device *d, struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(dev.ring_max_depth));
+}
+static DEVICE_ATTR_RO(ring_max_depth);
+
+static ssize_t ring_overflows_show(struct device *d, struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%llu\n", (unsigned long long) atomic64_read(&stats.ring_overflows));
+}
+static DEVICE_ATTR_RO(ring_overflows);
+
+static ssize_t ring_merged_show(struct device *d, struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%llu\n", (unsigned long long) atomic64_read(&stats.ring_merged));
+}
+static DEVICE_ATTR_RO(ring_merged);
+
+static struct attribute *vga_top_attrs[] = {
+	&dev_attr_ring_depth.attr,
+	&dev_attr_ring_max_depth.attr,
+	&dev_attr_ring_overflows.attr,
+	&dev_attr_ring_merged.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(vga_top);
+
 /* The operations our device knows how to do */
 static const struct file_operations fops = {
 	.owner		= THIS_MODULE,
 	.unlocked_ioctl = vga_top_ioctl,
+	.mmap		= vga_top_mmap,
+	.open		= vga_top_open,
+	.release	= vga_top_release,
+	.read		= vga_top_read,
+	.write		= vga_top_write,
+	.poll		= vga_top_poll,
 };
 
 /* Information about our device for the "misc" framework -- like a char dev */
@@ -92,6 +1036,7 @@ static struct miscdevice misc_device = {
 	.minor		= MISC_DYNAMIC_MINOR,
 	.name		= DRIVER_NAME,
 	.fops		= &fops,
+	.groups		= vga_top_groups,
 };
 
 /*
@@ -102,21 +1047,33 @@ static int __init probe(struct platform_device *pdev)
 {
 	int ret;
 
-	/* Register ourselves as a misc device: creates /dev/vga_top */
-	ret = misc_register(&misc_device);
+	spin_lock_init(&dev.lock);
+	mutex_init(&dev.ring_mutex);
+	init_waitqueue_head(&dev.vblank_wait);
+	atomic64_set(&dev.frame, 0);
+	hrtimer_init(&dev.stand_in_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev.stand_in_timer.function = stand_in_timer_fn;
+	if (stand_in_hz == 0)
+		stand_in_hz = 60;
+
+	/* Page for the mmap()able shadow tilemap */
+	dev.shadow = (vga_top_shadow_t *) get_zeroed_page(GFP_KERNEL);
+	if (dev.shadow == NULL)
+		return -ENOMEM;
+	SetPageReserved(virt_to_page(dev.shadow));
 
 	/* Get the address of our registers from the device tree */
 	ret = of_address_to_resource(pdev->dev.of_node, 0, &dev.res);
 	if (ret) {
 		ret = -ENOENT;
-		goto out_deregister;
+		goto out_free_shadow;
 	}
 
 	/* Make sure we can use these registers */
 	if (request_mem_region(dev.res.start, resource_size(&dev.res),
 			       DRIVER_NAME) == NULL) {
 		ret = -EBUSY;
-		goto out_deregister;
+		goto out_free_shadow;
 	}
 
 	/* Arrange access to our registers */
@@ -126,21 +1083,89 @@ static int __init probe(struct platform_device *pdev)
 		goto out_release_mem_region;
 	} 
 
+	/* vblank interrupt, or the timer standing in for it */
+	dev.irq = force_stand_in ? 0 : irq_of_parse_and_map(pdev->dev.of_node, 0);
+	if (dev.irq > 0) {
+		ret = request_irq(dev.irq, vga_top_irq, 0, DRIVER_NAME, &dev);
+		if (ret)
+			goto out_unmap;
+		iowrite32(1, VBLANK_STATUS(dev.virtbase));
+		iowrite32(1, VBLANK_CTRL(dev.virtbase));
+	} else {
+		dev.irq = 0;
+		pr_info(DRIVER_NAME ": no vblank irq, using a %u Hz timer\n", stand_in_hz);
+		hrtimer_start(&dev.stand_in_timer, ns_to_ktime(NSEC_PER_SEC / stand_in_hz),
+			      HRTIMER_MODE_REL);
+	}
+
+	/* Buffer the display list DMA fetches screens from; without it tiles go over the bridge one by one */
+	if (!dma_set_mask_and_coherent(&pdev->dev, DMA_BIT_MASK(32)))
+		dev.dma_frame = dma_alloc_coherent(&pdev->dev, sizeof(vga_top_frame_t),
+						   &dev.dma_handle, GFP_KERNEL);
+	if (dev.dma_frame)
+		iowrite32(dev.dma_handle, DMA_ADDR(dev.virtbase));
+	else
+		pr_info(DRIVER_NAME ": no DMA buffer, writing tiles one at a time\n");
+
+	/* Counters only, the driver works without debugfs */
+	dev.debugfs = debugfs_create_dir(DRIVER_NAME, NULL);
+	debugfs_create_file("stats", 0444, dev.debugfs, NULL, &stats_fops);
+
+	/* Last, once the irq, DMA buffer and ring the ioctls use are set up: creates /dev/vga_top */
+	ret = misc_register(&misc_device);
+	if (ret)
+		goto out_stop;
+
 	return 0;
 
+out_stop:
+	debugfs_remove_recursive(dev.debugfs);
+	if (dev.irq) {
+		iowrite32(0, VBLANK_CTRL(dev.virtbase));
+		free_irq(dev.irq, &dev);
+	} else {
+		hrtimer_cancel(&dev.stand_in_timer);
+	}
+	if (dev.dma_frame) {
+		iowrite32(0, DMA_ADDR(dev.virtbase));
+		dma_free_coherent(&pdev->dev, sizeof(vga_top_frame_t), dev.dma_frame, dev.dma_handle);
+		dev.dma_frame = NULL;
+	}
+out_unmap:
+	iounmap(dev.virtbase);
 out_release_mem_region:
 	release_mem_region(dev.res.start, resource_size(&dev.res));
-out_deregister:
-	misc_deregister(&misc_device);
+out_free_shadow:
+	ClearPageReserved(virt_to_page(dev.shadow));
+	free_page((unsigned long) dev.shadow);
 	return ret;
 }
 
 /* Clean-up code: release resources */
 static int vga_top_remove(struct platform_device *pdev)
 {
+	int i;
+
+	misc_deregister(&misc_device); /* no new callers before the rest goes */
+	debugfs_remove_recursive(dev.debugfs);
+	if (dev.irq) {
+		iowrite32(0, VBLANK_CTRL(dev.virtbase));
+		free_irq(dev.irq, &dev);
+	} else {
+		hrtimer_cancel(&dev.stand_in_timer);
+	}
+	iowrite32(0, SPRITE_CTRL(dev.virtbase));
+	if (dev.dma_frame) {
+		// cancel what is pending and let a running transfer finish
+		iowrite32(0, DMA_CTRL(dev.virtbase));
+		for (i = 0; i < 100 && (ioread32(DMA_STATUS(dev.virtbase)) & 1); i++)
+			usleep_range(100, 200);
+		dma_free_coherent(&pdev->dev, sizeof(vga_top_frame_t), dev.dma_frame, dev.dma_handle);
+	}
 	iounmap(dev.virtbase);
 	release_mem_region(dev.res.start, resource_size(&dev.res));
-	misc_deregister(&misc_device);
+	ClearPageReserved(virt_to_page(dev.shadow));
+	free_page((unsigned long) dev.shadow);
 	return 0;
 }
 
@@ -0,0 +1,51 @@
+/* Tracepoints for the vga_top driver: tile and sprite register writes */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM vga_top
+
+#if !defined(_VGA_TOP_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _VGA_TOP_TRACE_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(vga_top_write_tile,
+	TP_PROTO(unsigned char r, unsigned char c, unsigned char n),
+	TP_ARGS(r, c, n),
+	TP_STRUCT__entry(
+		__field(unsigned char, r)
+		__field(unsigned char, c)
+		__field(unsigned char, n)
+	),
+	TP_fast_assign(
+		__entry->r = r;
+		__entry->c = c;
+		__entry->n = n;
+	),
+	TP_printk("r=%u c=%u n=%u", __entry->r, __entry->c, __entry->n)
+);
+
+TRACE_EVENT(vga_top_write_sprite,
+	TP_PROTO(unsigned short register_n, unsigned int value),
+	TP_ARGS(register_n, value),
+	TP_STRUCT__entry(
+		__field(unsigned short, register_n)
+		__field(unsigned int, value)
+	),
+	TP_fast_assign(
+		__entry->register_n = register_n;
+		__entry->value = value;
+	),
+	TP_printk("reg=%u flip=%u act=%u r=%u c=%u n=%u value=0x%08x",
+		  __entry->register_n, (__entry->value >> 25) & 3, (__entry->value >> 24) & 1,
+		  (__entry->value >> 15) & 0x1ff, (__entry->value >> 5) & 0x3ff,
+		  __entry->value & 0x1f, __entry->value)
+);
+
+#endif /* _VGA_TOP_TRACE_H */
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE vga_top_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,229 @@
+/*
+ * Music sequencer: plays a song from a small RAM on four tone channels,
+ * so background music costs a few kilobytes instead of a rom full of
+ * samples, and its tempo is one register.
+ *
+ * The song is rows of four 16-bit entries, one per channel, 256 rows at
+ * most. A row lasts TEMPO samples. Entry:
+ *   bits 6:0   note: 0 leaves the channel as it is, 127 silences it,
+ *              otherwise a MIDI note number (69 is A 440 Hz)
+ *   bits 11:8  volume for the new note, 0-15
+ *   bits 13:12 duty of the square wave: 1/8, 1/4, 1/2, 3/4
+ * Channels 0-2 are square waves, channel 3 is noise from an LFSR clocked
+ * at the note's frequency.
+ *
+ * seq_tool renders the same song bit for bit on the host.
+ */
+
+module audio_seq(input logic clk,
+                 input logic reset,
+                 input logic tick, // one cycle per codec sample
+
+                 // registers, word offsets from the sequencer's base
+                 input logic write,
+                 input logic [2:0] address,
+                 input logic [31:0] writedata,
+                 output logic [31:0] readdata,
+
+                 output logic playing,
+                 output logic signed [15:0] sample);
+
+  localparam SEQ_CTRL   = 3'd0; // r/w: bit 0 plays from row 0, 0 stops
+  localparam SEQ_TEMPO  = 3'd1; // r/w: samples per row, from the next row on
+  localparam SEQ_ADDR   = 3'd2; // r/w: song RAM word SEQ_DATA writes next
+  localparam SEQ_DATA   = 3'd3; // w: one entry, then SEQ_ADDR moves on
+  localparam SEQ_LENGTH = 3'd4; // r/w: bits 8:0 rows in the song, bits 23:16 row to loop back to
+  localparam SEQ_ROW    = 3'd5; // r: row playing
+  localparam SEQ_VOLUME = 3'd6; // r/w: master volume, 255 is full scale
+
+  localparam CHANNELS = 4;
+  localparam NOISE = 3;
+
+  logic [15:0] song [1023:0];
+  logic [9:0] wr_addr;
+  logic [9:0] rd_addr;
+  logic [15:0] song_q;
+
+  logic [15:0] tempo;
+  logic [8:0] length;
+  logic [7:0] loop_row;
+  logic [7:0] volume;
+
+  logic [7:0] row;
+  logic [15:0] row_timer;
+
+  logic [23:0] phase [CHANNELS-1:0];
+  logic [23:0] inc [CHANNELS-1:0];
+  logic [3:0] ch_volume [CHANNELS-1:0];
+  logic [1:0] duty [CHANNELS-1:0];
+  logic [CHANNELS-1:0] ch_on;
+  logic [14:0] lfsr;
+
+  // fetching a row: one entry address per cycle, its data the cycle after
+  logic [7:0] fetch_row;
+  logic [2:0] fetch_ch;
+  logic fetching;
+  logic [1:0] apply_ch;
+  logic apply_valid;
+
+  assign rd_addr = {fetch_row, fetch_ch[1:0]};
+
+  always_ff @(posedge clk) begin
+    song_q <= song[rd_addr];
+    if (write && address == SEQ_DATA)
+      song[wr_addr] <= writedata[15:0];
+  end
+
+  // phase increment per sample at 8 kHz for each MIDI note
+  function automatic logic [23:0] note_inc(input logic [6:0] note);
+    case (note)
+      0: return 24'd0; 1: return 24'd18165; 2: return 24'd19246; 3: return 24'd20390;
+      4: return 24'd21602; 5: return 24'd22887; 6: return 24'd24248; 7: return 24'd25690;
+      8: return 24'd27217; 9: return 24'd28836; 10: return 24'd30551; 11: return 24'd32367;
+      12: return 24'd34292; 13: return 24'd36331; 14: return 24'd38491; 15: return 24'd40780;
+      16: return 24'd43205; 17: return 24'd45774; 18: return 24'd48496; 19: return 24'd51380;
+      20: return 24'd54435; 21: return 24'd57672; 22: return 24'd61101; 23: return 24'd64734;
+      24: return 24'd68584; 25: return 24'd72662; 26: return 24'd76982; 27: return 24'd81560;
+      28: return 24'd86410; 29: return 24'd91548; 30: return 24'd96992; 31: return 24'd102759;
+      32: return 24'd108870; 33: return 24'd115343; 34: return 24'd122202; 35: return 24'd129469;
+      36: return 24'd137167; 37: return 24'd145324; 38: return 24'd153965; 39: return 24'd163120;
+      40: return 24'd172820; 41: return 24'd183096; 42: return 24'd193984; 43: return 24'd205519;
+      44: return 24'd217739; 45: return 24'd230687; 46: return 24'd244404; 47: return 24'd258937;
+      48: return 24'd274334; 49: return 24'd290647; 50: return 24'd307930; 51: return 24'd326240;
+      52: return 24'd345640; 53: return 24'd366192; 54: return 24'd387967; 55: return 24'd411037;
+      56: return 24'd435479; 57: return 24'd461373; 58: return 24'd488808; 59: return 24'd517874;
+      60: return 24'd548669; 61: return 24'd581294; 62: return 24'd615860; 63: return 24'd652481;
+      64: return 24'd691279; 65: return 24'd732385; 66: return 24'd775935; 67: return 24'd822074;
+      68: return 24'd870957; 69: return 24'd922747; 70: return 24'd977616; 71: return 24'd1035748;
+      72: return 24'd1097337; 73: return 24'd1162588; 74: return 24'd1231719; 75: return 24'd1304961;
+      76: return 24'd1382558; 77: return 24'd1464769; 78: return 24'd1551869; 79: return 24'd1644148;
+      80: return 24'd1741914; 81: return 24'd1845494; 82: return 24'd1955233; 83: return 24'd2071497;
+      84: return 24'd2194674; 85: return 24'd2325176; 86: return 24'd2463439; 87: return 24'd2609922;
+      88: return 24'd2765116; 89: return 24'd2929539; 90: return 24'd3103738; 91: return 24'd3288296;
+      92: return 24'd3483828; 93: return 24'd3690988; 94: return 24'd3910465; 95: return 24'd4142993;
+      96: return 24'd4389349; 97: return 24'd4650353; 98: return 24'd4926877; 99: return 24'd5219845;
+      100: return 24'd5530233; 101: return 24'd5859077; 102: return 24'd6207476; 103: return 24'd6576592;
+      104: return 24'd6967657; 105: return 24'd7381975; 106: return 24'd7820930; 107: return 24'd8285987;
+      108: return 24'd8778697; 109: return 24'd9300706; 110: return 24'd9853754; 111: return 24'd10439689;
+      112: return 24'd11060465; 113: return 24'd11718155; 114: return 24'd12414953; 115: return 24'd13153184;
+      116: return 24'd13935313; 117: return 24'd14763950; 118: return 24'd15641860; 119: return 24'd16571974;
+      120: return 24'd16777215; 121: return 24'd16777215; 122: return 24'd16777215; 123: return 24'd16777215;
+      124: return 24'd16777215; 125: return 24'd16777215; 126: return 24'd16777215; 127: return 24'd0;
+    endcase
+  endfunction
+
+  // one channel's level for the current state
+  function automatic logic signed [13:0] level(input int ch);
+    logic high;
+    logic signed [13:0] amp;
+    amp = {1'b0, ch_volume[ch], 9'd0};
+    if (ch == NOISE)
+      high = lfsr[0];
+    else
+      case (duty[ch])
+        2'd0: high = phase[ch][23:21] < 3'd1;
+        2'd1: high = phase[ch][23:21] < 3'd2;
+        2'd2: high = phase[ch][23:21] < 3'd4;
+        default: high = phase[ch][23:21] < 3'd6;
+      endcase
+    if (!ch_on[ch])
+      return 0;
+    return high ? amp : -amp;
+  endfunction
+
+  logic signed [15:0] mix;
+  logic signed [24:0] scaled;
+  assign mix = level(0) + level(1) + level(2) + level(3);
+  assign scaled = mix * $signed({1'b0, volume});
+
+  logic [24:0] noise_next; // carry out of the noise phase clocks the lfsr
+  assign noise_next = phase[NOISE] + inc[NOISE];
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      wr_addr <= 0;
+      tempo <= 16'd1000;
+      length <= 0;
+      loop_row <= 0;
+      volume <= 8'd255;
+      playing <= 0;
+      sample <= 0;
+      ch_on <= 0;
+      fetching <= 0;
+      apply_valid <= 0;
+    end else begin
+      if (tick && playing) begin
+        sample <= scaled[23:8];
+        for (int ch = 0; ch < CHANNELS; ch++)
+          if (ch_on[ch])
+            phase[ch] <= phase[ch] + inc[ch];
+        if (ch_on[NOISE] && noise_next[24])
+          lfsr <= {lfsr[0] ^ lfsr[1], lfsr[14:1]};
+
+        if (row_timer == 0) begin
+          fetch_row <= row;
+          fetch_ch <= 0;
+          fetching <= 1;
+          row_timer <= tempo - 1'd1;
+          row <= (row + 1'd1 >= length) ? loop_row : row + 1'd1;
+        end else
+          row_timer <= row_timer - 1'd1;
+      end else if (fetching) begin
+        if (fetch_ch == CHANNELS - 1)
+          fetching <= 0;
+        fetch_ch <= fetch_ch + 1'd1;
+      end
+      apply_ch <= fetch_ch[1:0];
+      apply_valid <= fetching;
+
+      if (apply_valid) begin
+        if (song_q[6:0] == 7'd127)
+          ch_on[apply_ch] <= 0;
+        else if (song_q[6:0] != 0) begin
+          ch_on[apply_ch] <= 1;
+          inc[apply_ch] <= note_inc(song_q[6:0]);
+          ch_volume[apply_ch] <= song_q[11:8];
+          duty[apply_ch] <= song_q[13:12];
+        end
+      end
+
+      if (write) begin
+        case (address)
+          SEQ_CTRL: begin
+            playing <= writedata[0] && length != 0;
+            row <= 0;
+            row_timer <= 0;
+            ch_on <= 0;
+            fetching <= 0;
+            apply_valid <= 0;
+            sample <= 0;
+            lfsr <= 15'd1;
+            for (int ch = 0; ch < CHANNELS; ch++)
+              phase[ch] <= 0;
+          end
+          SEQ_TEMPO:  tempo <= writedata[15:0] == 0 ? 16'd1 : writedata[15:0];
+          SEQ_ADDR:   wr_addr <= writedata[9:0];
+          SEQ_DATA:   wr_addr <= wr_addr + 1'd1;
+          SEQ_LENGTH: begin
+            length <= writedata[8:0] > 9'd256 ? 9'd256 : writedata[8:0];
+            loop_row <= writedata[23:16];
+          end
+          SEQ_VOLUME: volume <= writedata[7:0];
+        endcase
+      end
+    end
+  end
+
+  always_comb begin
+    case (address)
+      SEQ_CTRL:   readdata = {31'd0, playing};
+      SEQ_TEMPO:  readdata = {16'd0, tempo};
+      SEQ_ADDR:   readdata = {22'd0, wr_addr};
+      SEQ_LENGTH: readdata = {8'd0, loop_row, 7'd0, length};
+      SEQ_ROW:    readdata = {24'd0, row};
+      SEQ_VOLUME: readdata = {24'd0, volume};
+      default:    readdata = 32'd0;
+    endcase
+  end
+
+endmodule
@@ -1,5 +1,3 @@
-`define BGM_BEGIN 18'h0
-`define BGM_END 18'h1387f
 module fpga_audio(input logic        clk,
 	        input logic 	   reset,
 
@@ -8,38 +6,373 @@ module fpga_audio(input logic        clk,
 		input right_chan_ready,
 
     // avalon slave
-		input logic [7:0]  writedata,
+		input logic [31:0] writedata,
 		input logic 	   write,
+		input logic 	   read,
 		input 		   chipselect,
-		input logic [3:0]  address,
+		input logic [5:0]  address,
+		output logic [31:0] readdata,
+		output logic 	   irq,
 
 		output logic [15:0] sample_data_l,
 		output logic sample_valid_l,
 		output logic [15:0] sample_data_r,
 		output logic sample_valid_r);
 
-  logic [17:0] sound_begin_addresses [5:0] = '{18'h13880, 18'h17700, 18'h1b580, 18'h1dc52, 18'h1fb92, 18'h21ad2};
-  logic [17:0] sound_end_addresses [5:0] = '{18'h176ff, 18'h1b57f, 18'h1dc51, 18'h1fb91, 18'h21ad1, 18'h23fd3};
+  // register map (word addresses)
+  localparam BGM_PLAY   = 6'd0; // w: bit 0 plays the bgm from the start, 0 stops it
+  localparam SFX_PLAY   = 6'd1; // w: bits 2:0 sound effect number, bits 27:16 its rate (0 is RATE_1X)
+  localparam FIFO_DATA  = 6'd2; // w: one signed 16-bit sample for the stream, dropped when full
+  localparam FIFO_LEVEL = 6'd3; // r: samples in the stream fifo
+  localparam FIFO_CTRL  = 6'd4; // r/w: bit 0 plays the stream, bit 1 enables the low-watermark irq, w: bit 2 empties the fifo
+  localparam FIFO_LOW   = 6'd5; // r/w: irq while fewer samples than this are left
+  localparam FIFO_GAPS  = 6'd6; // r: times the stream ran dry while playing, w: clears
+  localparam SOUND_SEL  = 6'd8;  // r/w: sound table slot SOUND_START and SOUND_LEN refer to
+  localparam SOUND_START = 6'd9; // r/w: rom address of the slot's first byte
+  localparam SOUND_LEN  = 6'd10; // r/w: bits 18:0 samples in the slot (0 is empty), bit 30 adpcm, bit 31 always loops
+  localparam VOICE_STATUS = 6'd12; // r: bits 7:0 voice playing, bits 15:8 voice reached its end; w: 1s clear bits 15:8
+  localparam VOICE_IRQ  = 6'd13; // r/w: irq while a voice with its bit set here has bit 8+n of VOICE_STATUS set
+  localparam POS_SEL    = 6'd14; // r/w: voice POSITION reads
+  localparam POSITION   = 6'd15; // r: samples that voice has played since it started or looped
+  localparam VOICE      = 6'd16; // 16-23 r/w: one per voice, see below
+  localparam VOICE_RATE = 6'd24; // 24-31 r/w: bits 11:0 the voice's rate, takes effect at once
+  localparam SEQ        = 6'd32; // 32-38: the music sequencer, see audio_seq.sv
+
+  // Voices: each plays a sound from the rom with its own address, end and
+  // volume, and all of them are summed every sample. Voice 0 is the one
+  // BGM_PLAY uses, SFX_PLAY takes a free one of the rest.
+  //   bits 2:0  sound table slot
+  //   bit 3     loop at the end instead of stopping (as does a looping slot)
+  //   bit 4     w: 1 starts the sound from its beginning, 0 stops; r: playing
+  //   bits 15:8 volume, 255 is full scale
+  // A voice steps through its sound by its rate every output sample, in
+  // 1/256ths of a sound sample, and plays the straight line between the
+  // two samples it is between; RATE_1X is the pitch it was recorded at
+  // and the highest rate is just under 16 times that.
+  localparam VOICES = 8;
+  localparam RATE_1X = 12'd256;
+  localparam BGM_SOUND = 3'd6; // slot BGM_PLAY starts
+
+  // Sound table: where each sound lives in the rom. It comes out of reset
+  // with the layout pack_audio wrote into combined_audio.mif, and the
+  // driver can load another one without rebuilding the bitstream. A slot
+  // holds either signed 8-bit PCM, a byte per sample, or 4-bit IMA ADPCM,
+  // two samples per byte with the low nibble first, decoded from a zero
+  // predictor and step index at the start of the slot.
+  `include "fpga_audio_sounds.svh"
+  localparam SOUNDS = 8;
+  logic [2:0] sound_sel;
+  logic [17:0] sound_start [SOUNDS-1:0];
+  logic [18:0] sound_len [SOUNDS-1:0];
+  logic [SOUNDS-1:0] sound_loop;
+  logic [SOUNDS-1:0] sound_adpcm;
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      sound_sel <= 0;
+      for (int i = 0; i < SOUNDS; i++) begin
+        sound_start[i] <= SOUND_START_INIT[i*18 +: 18];
+        sound_len[i] <= SOUND_LEN_INIT[i*19 +: 19];
+      end
+      sound_loop <= SOUND_LOOP_INIT;
+      sound_adpcm <= SOUND_ADPCM_INIT;
+    end else if (chipselect && write) begin
+      case (address)
+        SOUND_SEL:   sound_sel <= writedata[2:0];
+        SOUND_START: sound_start[sound_sel] <= writedata[17:0];
+        SOUND_LEN: begin
+          sound_len[sound_sel] <= writedata[18:0];
+          sound_adpcm[sound_sel] <= writedata[30];
+          sound_loop[sound_sel] <= writedata[31];
+        end
+      endcase
+    end
+  end
 
   logic [17:0] sound_address;
-  logic [17:0] sound_end_address;
-  logic [17:0] bgm_address;
-  logic [7:0] sound_data;
+  logic signed [7:0] sound_data;
 
   logic left_busy;
   logic right_busy;
 
-  logic bgm_playing;
-  logic sfx_playing;
+  logic [2:0] voice_sound [VOICES-1:0];
+  logic [VOICES-1:0] voice_loop;
+  logic [VOICES-1:0] voice_on;
+  logic [VOICES-1:0] voice_ended; // stopped at the end of its sound, not by software
+  logic [VOICES-1:0] voice_irq_en;
+  logic [2:0] pos_sel;
+  logic [7:0] voice_volume [VOICES-1:0];
+  logic [VOICES-1:0] voice_adpcm;
+  // positions count samples: rom bytes for pcm, nibbles for adpcm
+  logic [18:0] voice_begin [VOICES-1:0];
+  logic [18:0] voice_address [VOICES-1:0];
+  logic [18:0] voice_end [VOICES-1:0];
+  logic signed [15:0] voice_predictor [VOICES-1:0]; // adpcm decoder state
+  logic [6:0] voice_step_index [VOICES-1:0];
+  logic [11:0] voice_rate [VOICES-1:0];
+  logic [7:0] voice_frac [VOICES-1:0]; // how far from voice_prev to voice_cur this sample is
+  logic [4:0] voice_steps [VOICES-1:0]; // sound samples still to read for this output sample
+  logic signed [15:0] voice_prev [VOICES-1:0];
+  logic signed [15:0] voice_cur [VOICES-1:0]; // the last sample read
+
+  logic voices_playing;
+  assign voices_playing = |voice_on;
 
   //assign sample_valid_l = bgm_playing || sfx_playing;
   //assign sample_valid_r = bgm_playing || sfx_playing;
 
   audio_rom(sound_address, clk, sound_data);
 
-  // 8bit to 16bit
-  assign sample_data_l = sound_data << 8;
-  assign sample_data_r = sound_data << 8;
+  // background music from the sequencer, mixed like the stream
+  logic seq_playing;
+  logic signed [15:0] seq_sample;
+  logic [31:0] seq_readdata;
+
+  // samples streamed from the HPS, played at the codec rate and mixed
+  // with the rom; 1024 deep is 128 ms at 8 kHz
+  localparam FIFO_DEPTH = 1024;
+  logic [15:0] fifo [FIFO_DEPTH-1:0];
+  logic [10:0] fifo_wr; // one bit wider than the index, so full and empty differ
+  logic [10:0] fifo_rd;
+  logic [10:0] fifo_level;
+  logic [15:0] fifo_q;
+  logic [1:0] fifo_ctrl;
+  logic [10:0] fifo_low;
+  logic [31:0] fifo_gaps;
+  logic fifo_dry; // the last sample time found the fifo empty
+  logic signed [15:0] stream_sample;
+
+  assign fifo_level = fifo_wr - fifo_rd;
+  assign irq = (fifo_ctrl[1] && fifo_level < fifo_low) || |(voice_ended & voice_irq_en);
+
+  // a new sample goes out: both channels ready and the last one taken
+  logic sample_tick;
+  assign sample_tick = (voices_playing || fifo_ctrl[0] || seq_playing) &&
+                       left_chan_ready && right_chan_ready && !left_busy && !right_busy;
+
+  audio_seq seq(.clk(clk), .reset(reset), .tick(sample_tick),
+                .write(chipselect && write && address[5:3] == SEQ[5:3]),
+                .address(address[2:0]), .writedata(writedata), .readdata(seq_readdata),
+                .playing(seq_playing), .sample(seq_sample));
+
+  always_ff @(posedge clk) begin
+    fifo_q <= fifo[fifo_rd[9:0]];
+    if (chipselect && write && address == FIFO_DATA && fifo_level < FIFO_DEPTH)
+      fifo[fifo_wr[9:0]] <= writedata[15:0];
+  end
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      fifo_wr <= 0;
+      fifo_rd <= 0;
+      fifo_ctrl <= 0;
+      fifo_low <= 0;
+      fifo_gaps <= 0;
+      fifo_dry <= 0;
+      stream_sample <= 0;
+    end else begin
+      if (chipselect && write) begin
+        case (address)
+          FIFO_DATA: if (fifo_level < FIFO_DEPTH) fifo_wr <= fifo_wr + 1;
+          FIFO_CTRL: begin
+            fifo_ctrl <= writedata[1:0];
+            if (writedata[2])
+              fifo_rd <= fifo_wr; // flush
+          end
+          FIFO_LOW:  fifo_low <= writedata[10:0];
+          FIFO_GAPS: fifo_gaps <= 0;
+        endcase
+      end
+
+      if (!fifo_ctrl[0]) begin
+        stream_sample <= 0;
+        fifo_dry <= 0;
+      end else if (sample_tick) begin
+        if (fifo_level != 0) begin
+          stream_sample <= fifo_q;
+          fifo_rd <= fifo_rd + 1;
+          fifo_dry <= 0;
+        end else begin
+          stream_sample <= 0;
+          if (!fifo_dry)
+            fifo_gaps <= fifo_gaps + 1;
+          fifo_dry <= 1;
+        end
+      end
+    end
+  end
+
+  always_comb begin
+    case (address)
+      FIFO_LEVEL: readdata = {21'd0, fifo_level};
+      FIFO_CTRL:  readdata = {30'd0, fifo_ctrl};
+      FIFO_LOW:   readdata = {21'd0, fifo_low};
+      VOICE_STATUS: readdata = {16'd0, voice_ended, voice_on};
+      VOICE_IRQ:  readdata = {24'd0, voice_irq_en};
+      POS_SEL:    readdata = {29'd0, pos_sel};
+      POSITION:   readdata = {13'd0, voice_address[pos_sel] - voice_begin[pos_sel]};
+      FIFO_GAPS:  readdata = fifo_gaps;
+      SOUND_SEL:  readdata = {29'd0, sound_sel};
+      SOUND_START: readdata = {14'd0, sound_start[sound_sel]};
+      SOUND_LEN:  readdata = {sound_loop[sound_sel], sound_adpcm[sound_sel], 11'd0, sound_len[sound_sel]};
+      default:
+        if (address[5:3] == SEQ[5:3])
+          readdata = seq_readdata;
+        else if (address[5:3] == VOICE[5:3])
+          readdata = {16'd0, voice_volume[address[2:0]], 3'd0, voice_on[address[2:0]],
+                      voice_loop[address[2:0]], voice_sound[address[2:0]]};
+        else if (address[5:3] == VOICE_RATE[5:3])
+          readdata = {20'd0, voice_rate[address[2:0]]};
+        else
+          readdata = 32'd0;
+    endcase
+  end
+
+  // The rom has one port, so the voices take turns on it right after each
+  // sample goes out. A voice reads as many sound samples as its rate moved
+  // it on, one every other cycle so each is decoded before the next is
+  // addressed, then the point between its last two is interpolated, scaled
+  // by the volume and summed into voice_sum for the next sample. Eight
+  // voices at the top rate take under 300 of the ~6000 cycles a sample.
+  logic [3:0] seq_voice; // voice whose address is on the rom
+  logic seq_run;
+  logic [2:0] rom_voice; // voice sound_data belongs to
+  logic rom_valid;
+  logic signed [15:0] dec_sample; // interpolated sample of the voice before
+  logic [7:0] dec_volume;
+  logic dec_valid;
+  logic signed [19:0] voice_acc;
+  logic signed [19:0] voice_sum; // held for the whole sample period
+
+  // 16 bit sample times the 8 bit volume, 255 is full scale
+  logic signed [24:0] scaled;
+  assign scaled = dec_sample * $signed({1'b0, dec_volume});
+
+  // the point frac/256 of the way from the voice's previous sample to its last
+  logic signed [16:0] interp_diff;
+  logic signed [25:0] interp_step;
+  logic signed [15:0] interp_sample;
+  assign interp_diff = voice_cur[seq_voice[2:0]] - voice_prev[seq_voice[2:0]];
+  assign interp_step = interp_diff * $signed({1'b0, voice_frac[seq_voice[2:0]]});
+  assign interp_sample = voice_prev[seq_voice[2:0]] + $signed(interp_step[24:8]);
+
+  logic [18:0] seq_position;
+  assign seq_position = voice_address[seq_voice[2:0]];
+  assign sound_address = voice_adpcm[seq_voice[2:0]] ? seq_position[18:1] : seq_position[17:0];
+
+  // IMA ADPCM step size for each step index
+  function automatic logic [14:0] adpcm_step(input logic [6:0] index);
+    case (index)
+      0: return 15'd7; 1: return 15'd8; 2: return 15'd9; 3: return 15'd10;
+      4: return 15'd11; 5: return 15'd12; 6: return 15'd13; 7: return 15'd14;
+      8: return 15'd16; 9: return 15'd17; 10: return 15'd19; 11: return 15'd21;
+      12: return 15'd23; 13: return 15'd25; 14: return 15'd28; 15: return 15'd31;
+      16: return 15'd34; 17: return 15'd37; 18: return 15'd41; 19: return 15'd45;
+      20: return 15'd50; 21: return 15'd55; 22: return 15'd60; 23: return 15'd66;
+      24: return 15'd73; 25: return 15'd80; 26: return 15'd88; 27: return 15'd97;
+      28: return 15'd107; 29: return 15'd118; 30: return 15'd130; 31: return 15'd143;
+      32: return 15'd157; 33: return 15'd173; 34: return 15'd190; 35: return 15'd209;
+      36: return 15'd230; 37: return 15'd253; 38: return 15'd279; 39: return 15'd307;
+      40: return 15'd337; 41: return 15'd371; 42: return 15'd408; 43: return 15'd449;
+      44: return 15'd494; 45: return 15'd544; 46: return 15'd598; 47: return 15'd658;
+      48: return 15'd724; 49: return 15'd796; 50: return 15'd876; 51: return 15'd963;
+      52: return 15'd1060; 53: return 15'd1166; 54: return 15'd1282; 55: return 15'd1411;
+      56: return 15'd1552; 57: return 15'd1707; 58: return 15'd1878; 59: return 15'd2066;
+      60: return 15'd2272; 61: return 15'd2499; 62: return 15'd2749; 63: return 15'd3024;
+      64: return 15'd3327; 65: return 15'd3660; 66: return 15'd4026; 67: return 15'd4428;
+      68: return 15'd4871; 69: return 15'd5358; 70: return 15'd5894; 71: return 15'd6484;
+      72: return 15'd7132; 73: return 15'd7845; 74: return 15'd8630; 75: return 15'd9493;
+      76: return 15'd10442; 77: return 15'd11487; 78: return 15'd12635; 79: return 15'd13899;
+      80: return 15'd15289; 81: return 15'd16818; 82: return 15'd18500; 83: return 15'd20350;
+      84: return 15'd22385; 85: return 15'd24623; 86: return 15'd27086; 87: return 15'd29794;
+      88: return 15'd32767;
+      default: return 15'd32767;
+    endcase
+  endfunction
+
+  // Decode the nibble sound_data holds for rom_voice
+  logic [3:0] nibble;
+  logic [14:0] step;
+  logic [17:0] diff;
+  logic signed [17:0] predicted;
+  logic signed [15:0] next_predictor;
+  logic signed [7:0] next_index;
+  logic [6:0] next_step_index;
+
+  always_comb begin
+    nibble = voice_address[rom_voice][0] ? sound_data[7:4] : sound_data[3:0];
+    step = adpcm_step(voice_step_index[rom_voice]);
+    diff = step >> 3;
+    if (nibble[2]) diff = diff + step;
+    if (nibble[1]) diff = diff + (step >> 1);
+    if (nibble[0]) diff = diff + (step >> 2);
+    predicted = nibble[3] ? voice_predictor[rom_voice] - $signed(diff)
+                          : voice_predictor[rom_voice] + $signed(diff);
+    if (predicted > 18'sd32767)
+      next_predictor = 16'sh7fff;
+    else if (predicted < -18'sd32768)
+      next_predictor = -16'sh8000;
+    else
+      next_predictor = predicted[15:0];
+
+    next_index = $signed({1'b0, voice_step_index[rom_voice]}) + (nibble[2] ? 8'sd2 + $signed({5'd0, nibble[1:0], 1'b0}) : -8'sd1);
+    if (next_index < 0)
+      next_step_index = 0;
+    else if (next_index > 88)
+      next_step_index = 88;
+    else
+      next_step_index = next_index[6:0];
+  end
+
+  // add the stream and the music, and saturate
+  logic signed [19:0] mix;
+  assign mix = voice_sum + stream_sample + seq_sample;
+  always_comb begin
+    if (mix > 20'sd32767)
+      sample_data_l = 16'h7fff;
+    else if (mix < -20'sd32768)
+      sample_data_l = 16'h8000;
+    else
+      sample_data_l = mix[15:0];
+  end
+  assign sample_data_r = sample_data_l;
+
+  // SFX_PLAY takes the lowest idle voice after 0, or steals in turn when all are busy
+  logic [2:0] free_voice;
+  logic free_found;
+  logic [2:0] steal_voice;
+  always_comb begin
+    free_voice = 0;
+    free_found = 0;
+    for (int i = VOICES - 1; i >= 1; i--)
+      if (!voice_on[i]) begin
+        free_voice = i;
+        free_found = 1;
+      end
+  end
+
+  // the voice the sequencer is stopping this cycle, so clearing VOICE_STATUS keeps it
+  logic [VOICES-1:0] voice_ending;
+  assign voice_ending = (rom_valid && voice_on[rom_voice] && !voice_loop[rom_voice] &&
+                         voice_address[rom_voice] >= voice_end[rom_voice]) ? 8'd1 << rom_voice : 8'd0;
+
+  task automatic start_voice(input logic [2:0] v, input logic [2:0] n, input logic loop,
+                             input logic on, input logic [7:0] volume);
+    voice_sound[v] <= n;
+    voice_loop[v] <= loop || sound_loop[n];
+    voice_on[v] <= on && sound_len[n] != 0;
+    voice_volume[v] <= volume;
+    voice_adpcm[v] <= sound_adpcm[n];
+    voice_begin[v] <= sound_adpcm[n] ? {sound_start[n], 1'b0} : {1'b0, sound_start[n]};
+    voice_address[v] <= sound_adpcm[n] ? {sound_start[n], 1'b0} : {1'b0, sound_start[n]};
+    voice_end[v] <= (sound_adpcm[n] ? {sound_start[n], 1'b0} : {1'b0, sound_start[n]}) + sound_len[n] - 1'd1;
+    voice_predictor[v] <= 0;
+    voice_step_index[v] <= 0;
+    voice_frac[v] <= 0;
+    voice_steps[v] <= 0;
+    voice_prev[v] <= 0;
+    voice_cur[v] <= 0;
+  endtask
 
   always_ff @(posedge clk) begin
     if (reset) begin
@@ -47,52 +380,99 @@ module fpga_audio(input logic        clk,
       sample_valid_r <= 0;
       left_busy <= 0;
       right_busy <= 0;
-      sound_address <= `BGM_BEGIN;
-      bgm_address <= `BGM_BEGIN;
-      sound_end_address <= `BGM_END;
-      bgm_playing <= 0;
-      sfx_playing <= 0;
-    end else if (chipselect && write) begin
-       case (address) // control bgm start/stop
-	       0: begin 
-          bgm_playing <= writedata;
-          bgm_address <= `BGM_BEGIN;
-          if(!sfx_playing) begin
-            sound_address <= `BGM_BEGIN;
-            sound_end_address <= `BGM_END;          
+      voice_on <= 0;
+      voice_ended <= 0;
+      voice_irq_en <= 0;
+      pos_sel <= 0;
+      steal_voice <= 1;
+      seq_voice <= 0;
+      seq_run <= 0;
+      rom_valid <= 0;
+      dec_valid <= 0;
+      voice_acc <= 0;
+      voice_sum <= 0;
+      for (int i = 0; i < VOICES; i++)
+        voice_rate[i] <= RATE_1X;
+    end else begin
+      // walk the voices once per sample
+      rom_valid <= 0;
+      dec_valid <= 0;
+      if (sample_tick) begin
+        voice_sum <= voice_acc;
+        voice_acc <= 0;
+        seq_voice <= 0;
+        seq_run <= 1;
+        for (int i = 0; i < VOICES; i++)
+          {voice_steps[i], voice_frac[i]} <= voice_frac[i] + voice_rate[i];
+      end else if (seq_run && !rom_valid) begin
+        if (voice_on[seq_voice[2:0]] && voice_steps[seq_voice[2:0]] != 0) begin
+          rom_voice <= seq_voice[2:0];
+          rom_valid <= 1;
+          voice_steps[seq_voice[2:0]] <= voice_steps[seq_voice[2:0]] - 1'd1;
+        end else begin
+          dec_valid <= voice_on[seq_voice[2:0]];
+          dec_volume <= voice_volume[seq_voice[2:0]];
+          dec_sample <= interp_sample;
+          if (seq_voice == VOICES - 1)
+            seq_run <= 0;
+          seq_voice <= seq_voice + 1;
+        end
+      end
+
+      if (dec_valid)
+        voice_acc <= voice_acc + scaled[24:8];
+
+      if (rom_valid && voice_on[rom_voice]) begin
+        voice_prev[rom_voice] <= voice_cur[rom_voice];
+        voice_cur[rom_voice] <= voice_adpcm[rom_voice] ? next_predictor : {sound_data, 8'd0};
+        if (voice_adpcm[rom_voice]) begin
+          voice_predictor[rom_voice] <= next_predictor;
+          voice_step_index[rom_voice] <= next_step_index;
+        end
+        if (voice_address[rom_voice] >= voice_end[rom_voice]) begin
+          if (voice_loop[rom_voice]) begin
+            voice_address[rom_voice] <= voice_begin[rom_voice];
+            voice_predictor[rom_voice] <= 0;
+            voice_step_index[rom_voice] <= 0;
+          end else begin
+            voice_on[rom_voice] <= 0;
+            voice_ended[rom_voice] <= 1;
           end
-         end
-         1: begin // start playing sound effect
-          sound_address <= sound_begin_addresses[writedata];
-          sound_end_address <= sound_end_addresses[writedata];
-          sfx_playing <= 1;
-         end
-       endcase
-    end
+        end else
+          voice_address[rom_voice] <= voice_address[rom_voice] + 1;
+      end
 
-    if (bgm_playing || sfx_playing) begin
-      if (left_chan_ready == 1 && right_chan_ready == 1) begin // our fpga clock is much faster than sampling rate
-        if(left_busy == 0 && right_busy == 0) begin // only feed data when audio is ready
-          // current sound ends
-          if(sound_address >= sound_end_address) begin
-            // if sound effect ends, continue playing bgm
-            if(sfx_playing) begin
-              sound_address <= bgm_address;
-              sound_end_address <= `BGM_END;
-              sfx_playing <= 0;
-            // repeat bgm
+      // software wins over the voice that just finished
+      if (chipselect && write) begin
+        case (address)
+          BGM_PLAY: begin
+            start_voice(0, BGM_SOUND, 1, writedata[0], 8'd255);
+            voice_rate[0] <= RATE_1X;
+          end
+          SFX_PLAY: begin
+            if (free_found) begin
+              start_voice(free_voice, writedata[2:0], 0, 1, 8'd255);
+              voice_rate[free_voice] <= writedata[27:16] == 0 ? RATE_1X : writedata[27:16];
             end else begin
-              bgm_address <= `BGM_BEGIN;
-              sound_address <= `BGM_BEGIN;
-              sound_end_address <= `BGM_END;
+              start_voice(steal_voice, writedata[2:0], 0, 1, 8'd255);
+              voice_rate[steal_voice] <= writedata[27:16] == 0 ? RATE_1X : writedata[27:16];
+              steal_voice <= steal_voice == VOICES - 1 ? 3'd1 : steal_voice + 1;
             end
-          end else begin
-            sound_address <= sound_address + 1;
-            if(!sfx_playing)
-              bgm_address <= bgm_address + 1;
-          end // if(sound_address >= sound_end_address)
-        end // if(left_busy == 0 && right_busy == 0)
+          end
+          VOICE_STATUS: voice_ended <= (voice_ended | voice_ending) & ~writedata[15:8];
+          VOICE_IRQ: voice_irq_en <= writedata[7:0];
+          POS_SEL: pos_sel <= writedata[2:0];
+          default:
+            if (address[5:3] == VOICE[5:3])
+              start_voice(address[2:0], writedata[2:0], writedata[3], writedata[4], writedata[15:8]);
+            else if (address[5:3] == VOICE_RATE[5:3])
+              voice_rate[address[2:0]] <= writedata[11:0];
+        endcase
+      end
+    end
 
+    if (voices_playing || fifo_ctrl[0] || seq_playing) begin
+      if (left_chan_ready == 1 && right_chan_ready == 1) begin // our fpga clock is much faster than sampling rate
         left_busy <= 1;
         right_busy <= 1;
         sample_valid_l <= 1;
@@ -107,7 +487,7 @@ module fpga_audio(input logic        clk,
       sample_valid_l <= 0;
       sample_valid_r <= 0;
     end // if (left_chan_ready == 1 && right_chan_ready == 1)
-  end // if (bgm_playing || sfx_playing)
+  end // if (voices_playing || fifo_ctrl[0] || seq_playing)
 	       
 endmodule
 
@@ -40,8 +40,10 @@ set_fileset_property QUARTUS_SYNTH TOP_LEVEL fpga_audio
 set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
 set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
 add_fileset_file fpga_audio.sv SYSTEM_VERILOG PATH fpga_audio.sv TOP_LEVEL_FILE
+add_fileset_file fpga_audio_sounds.svh SYSTEM_VERILOG_INCLUDE PATH fpga_audio_sounds.svh
 add_fileset_file combined_audio.mif MIF PATH combined_audio.mif
 add_fileset_file audio_rom.v VERILOG PATH audio_rom.v
+add_fileset_file audio_seq.sv SYSTEM_VERILOG PATH audio_seq.sv
 
 
 # 
@@ -161,12 +163,32 @@ set_interface_property avalon_slave PORT_NAME_MAP ""
 set_interface_property avalon_slave CMSIS_SVD_VARIABLES ""
 set_interface_property avalon_slave SVD_ADDRESS_GROUP ""
 
-add_interface_port avalon_slave address address Input 4
+add_interface_port avalon_slave address address Input 6
 add_interface_port avalon_slave chipselect chipselect Input 1
 add_interface_port avalon_slave write write Input 1
-add_interface_port avalon_slave writedata writedata Input 8
+add_interface_port avalon_slave writedata writedata Input 32
+add_interface_port avalon_slave read read Input 1
+add_interface_port avalon_slave readdata readdata Output 32
 set_interface_assignment avalon_slave embeddedsw.configuration.isFlash 0
 set_interface_assignment avalon_slave embeddedsw.configuration.isMemoryDevice 0
 set_interface_assignment avalon_slave embeddedsw.configuration.isNonVolatileStorage 0
 set_interface_assignment avalon_slave embeddedsw.configuration.isPrintableDevice 0
 
+
+# 
+# connection point interrupt_sender
+# 
+add_interface interrupt_sender interrupt end
+set_interface_property interrupt_sender associatedAddressablePoint avalon_slave
+set_interface_property interrupt_sender associatedClock clock
+set_interface_property interrupt_sender associatedReset reset
+set_interface_property interrupt_sender bridgedReceiverOffset ""
+set_interface_property interrupt_sender bridgesToReceiver ""
+set_interface_property interrupt_sender ENABLED true
+set_interface_property interrupt_sender EXPORT_OF ""
+set_interface_property interrupt_sender PORT_NAME_MAP ""
+set_interface_property interrupt_sender CMSIS_SVD_VARIABLES ""
+set_interface_property interrupt_sender SVD_ADDRESS_GROUP ""
+
+add_interface_port interrupt_sender irq irq Output 1
+
@@ -0,0 +1,243 @@
+/*
+ * seq_tool: compile a song for the audio_seq sequencer and render it
+ *
+ * Usage: seq_tool song.seq fpga_audio_song.h [out.wav [seconds]]
+ *
+ * Writes the song as the header the driver loads into the sequencer's
+ * RAM at probe, and optionally renders it to a 16-bit 8 kHz WAV with a
+ * model of audio_seq.sv that matches it sample for sample, to listen to
+ * or compare against a capture from the board.
+ *
+ * Song text, one row per line, '#' starts a comment:
+ *   tempo 800          samples per row (8000 is a second)
+ *   loop 16            row to go back to after the last one
+ *   volume 255         master volume
+ *   C-4:12:2  E-4:8:1  ...  off
+ * A row has four fields, channels 0-2 square and 3 noise. A field is
+ * "..." to leave the channel alone, "off" to silence it, or
+ * note[:volume[:duty]] with the note as C-4, C#4 ... B-9, volume 0-15
+ * (default 15) and duty 0-3 for 1/8, 1/4, 1/2, 3/4 (default 2).
+ *
+ * Built on the host: cc -o seq_tool seq_tool.c -lm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CHANNELS 4
+#define NOISE 3
+#define MAX_ROWS 256
+#define RATE 8000
+
+static unsigned short song[MAX_ROWS * CHANNELS];
+static int rows;
+static int tempo = 1000;
+static int loop_row;
+static int volume = 255;
+
+static int parse_note(const char *s)
+{
+  static const char names[] = "C-C#D-D#E-F-F#G-G#A-A#B-";
+  int i;
+
+  for (i = 0; i < 12; i++)
+    if (s[0] == names[i * 2] && s[1] == names[i * 2 + 1])
+      break;
+  if (i == 12 || s[2] < '0' || s[2] > '9')
+    return -1;
+  return 12 * (s[2] - '0' + 1) + i; // C-4 is MIDI 60
+}
+
+static unsigned short parse_field(const char *field, int line)
+{
+  char note[8];
+  int vol = 15, duty = 2, n;
+
+  if (strcmp(field, "...") == 0)
+    return 0;
+  if (strcmp(field, "off") == 0)
+    return 127;
+  if (sscanf(field, "%3[^:]:%d:%d", note, &vol, &duty) < 1 ||
+      (n = parse_note(note)) < 1 || n > 126 || vol < 0 || vol > 15 || duty < 0 || duty > 3) {
+    fprintf(stderr, "line %d: bad field \"%s\"\n", line, field);
+    exit(1);
+  }
+  return n | vol << 8 | duty << 12;
+}
+
+static void load(const char *path)
+{
+  char buf[256], f[CHANNELS][32];
+  int line = 0, ch, n;
+  FILE *in;
+
+  if ((in = fopen(path, "r")) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  while (fgets(buf, sizeof(buf), in)) {
+    char *hash = strchr(buf, '#');
+
+    line++;
+    if (hash)
+      *hash = '\0';
+    if (sscanf(buf, " tempo %d", &tempo) == 1 || sscanf(buf, " loop %d", &loop_row) == 1 ||
+        sscanf(buf, " volume %d", &volume) == 1)
+      continue;
+    n = sscanf(buf, "%31s %31s %31s %31s", f[0], f[1], f[2], f[3]);
+    if (n <= 0)
+      continue;
+    if (n != CHANNELS) {
+      fprintf(stderr, "line %d: a row needs %d fields\n", line, CHANNELS);
+      exit(1);
+    }
+    if (rows == MAX_ROWS) {
+      fprintf(stderr, "line %d: more than %d rows\n", line, MAX_ROWS);
+      exit(1);
+    }
+    for (ch = 0; ch < CHANNELS; ch++)
+      song[rows * CHANNELS + ch] = parse_field(f[ch], line);
+    rows++;
+  }
+  fclose(in);
+  if (rows == 0 || loop_row >= rows || tempo < 1 || tempo > 65535 || volume < 0 || volume > 255) {
+    fprintf(stderr, "%s: empty song, or tempo, loop or volume out of range\n", path);
+    exit(1);
+  }
+}
+
+static void write_header(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  int i;
+
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fprintf(f, "/* Background music for the audio sequencer, generated by seq_tool */\n");
+  fprintf(f, "#ifndef _FPGA_AUDIO_SONG_H\n#define _FPGA_AUDIO_SONG_H\n\n");
+  fprintf(f, "#define FPGA_AUDIO_SONG_ROWS %d\n", rows);
+  fprintf(f, "#define FPGA_AUDIO_SONG_LOOP %d\n", loop_row);
+  fprintf(f, "#define FPGA_AUDIO_SONG_TEMPO %d\n", tempo);
+  fprintf(f, "#define FPGA_AUDIO_SONG_VOLUME %d\n\n", volume);
+  fprintf(f, "static const unsigned short fpga_audio_song[FPGA_AUDIO_SONG_ROWS * 4] = {\n");
+  for (i = 0; i < rows; i++)
+    fprintf(f, "  0x%04x, 0x%04x, 0x%04x, 0x%04x,\n", song[i * 4], song[i * 4 + 1], song[i * 4 + 2], song[i * 4 + 3]);
+  fprintf(f, "};\n\n#endif\n");
+  fclose(f);
+}
+
+/* The state of audio_seq.sv and one codec sample of it */
+struct seq {
+  unsigned int phase[CHANNELS], inc[CHANNELS];
+  int ch_volume[CHANNELS], duty[CHANNELS], on[CHANNELS];
+  unsigned int lfsr;
+  int row, row_timer;
+};
+
+static unsigned int note_inc(int note)
+{
+  double inc;
+
+  if (note == 0 || note == 127)
+    return 0;
+  inc = floor(440.0 * pow(2.0, (note - 69) / 12.0) * (1 << 24) / RATE + 0.5);
+  return inc > 0xffffff ? 0xffffff : (unsigned int) inc;
+}
+
+static int level(const struct seq *s, int ch)
+{
+  static const unsigned int duty_eighths[4] = { 1, 2, 4, 6 };
+  int amp = s->ch_volume[ch] << 9, high;
+
+  if (ch == NOISE)
+    high = s->lfsr & 1;
+  else
+    high = (s->phase[ch] >> 21) < duty_eighths[s->duty[ch]];
+  if (!s->on[ch])
+    return 0;
+  return high ? amp : -amp;
+}
+
+static short seq_tick(struct seq *s)
+{
+  int mix = 0, ch, row;
+  short out;
+
+  for (ch = 0; ch < CHANNELS; ch++)
+    mix += level(s, ch);
+  out = (short) floor(mix * volume / 256.0);
+
+  if (s->on[NOISE] && s->phase[NOISE] + s->inc[NOISE] > 0xffffff)
+    s->lfsr = (((s->lfsr ^ (s->lfsr >> 1)) & 1) << 14) | (s->lfsr >> 1);
+  for (ch = 0; ch < CHANNELS; ch++)
+    if (s->on[ch])
+      s->phase[ch] = (s->phase[ch] + s->inc[ch]) & 0xffffff;
+
+  if (s->row_timer == 0) {
+    row = s->row;
+    s->row_timer = tempo - 1;
+    s->row = s->row + 1 >= rows ? loop_row : s->row + 1;
+    for (ch = 0; ch < CHANNELS; ch++) {
+      int e = song[row * CHANNELS + ch];
+
+      if ((e & 127) == 127)
+        s->on[ch] = 0;
+      else if (e & 127) {
+        s->on[ch] = 1;
+        s->inc[ch] = note_inc(e & 127);
+        s->ch_volume[ch] = (e >> 8) & 15;
+        s->duty[ch] = (e >> 12) & 3;
+      }
+    }
+  } else
+    s->row_timer--;
+  return out;
+}
+
+static void put32(FILE *f, unsigned int v)
+{
+  fputc(v, f); fputc(v >> 8, f); fputc(v >> 16, f); fputc(v >> 24, f);
+}
+
+static void put16(FILE *f, unsigned int v)
+{
+  fputc(v, f); fputc(v >> 8, f);
+}
+
+static void write_wav(const char *path, double seconds)
+{
+  struct seq s = { .lfsr = 1 };
+  unsigned int n = seconds * RATE, i;
+  FILE *f = fopen(path, "wb");
+
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fputs("RIFF", f); put32(f, 36 + n * 2); fputs("WAVE", f);
+  fputs("fmt ", f); put32(f, 16); put16(f, 1); put16(f, 1);
+  put32(f, RATE); put32(f, RATE * 2); put16(f, 2); put16(f, 16);
+  fputs("data", f); put32(f, n * 2);
+  for (i = 0; i < n; i++)
+    put16(f, (unsigned short) seq_tick(&s));
+  fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3 || argc > 5) {
+    fprintf(stderr, "usage: seq_tool song.seq fpga_audio_song.h [out.wav [seconds]]\n");
+    return 1;
+  }
+  load(argv[1]);
+  write_header(argv[2]);
+  if (argc >= 4)
+    write_wav(argv[3], argc == 5 ? atof(argv[4]) : (double) rows * tempo / RATE);
+  printf("%d rows, %d bytes of song RAM, %.1f s to the loop point\n",
+         rows, rows * CHANNELS * 2, (double) rows * tempo / RATE);
+  return 0;
+}
@@ -16,6 +16,8 @@ module linebuffer(
   wren_pixel_display,
   wren_tile_draw,
   wren_pixel_draw,
+  byteena_pixel_display,
+  byteena_pixel_draw,
 
   q_tile_display,
   q_pixel_display,
@@ -26,43 +28,46 @@ module linebuffer(
   input reset;
   input switch;	// switch drawing and displaying buffer
   input	[5:0]  address_tile_display;
-	input	[9:0]  address_pixel_display;
+	input	[7:0]  address_pixel_display; // 4 pixels per word
 	input	[5:0]  address_tile_draw;
-	input	[9:0]  address_pixel_draw;
+	input	[7:0]  address_pixel_draw;
 
-	input	[255:0]  data_tile_display;
-  input	[15:0]  data_pixel_display;
-  input	[255:0]  data_tile_draw;
-  input	[15:0]  data_pixel_draw;
+	input	[127:0]  data_tile_display;
+  input	[31:0]  data_pixel_display; // palette indices, leftmost pixel in 7:0
+  input	[127:0]  data_tile_draw;
+  input	[31:0]  data_pixel_draw;
 	
   
 	input	  wren_tile_display;
 	input	  wren_pixel_display;
   input	  wren_tile_draw;
 	input	  wren_pixel_draw;
+  input	[3:0]  byteena_pixel_display; // 1 bit per pixel
+  input	[3:0]  byteena_pixel_draw;
 
-	output	[255:0]  q_tile_display;
-  output	[15:0]  q_pixel_display;
-  output	[255:0]  q_tile_draw;
-  output	[15:0]  q_pixel_draw;
+	output	[127:0]  q_tile_display;
+  output	[31:0]  q_pixel_display;
+  output	[127:0]  q_tile_draw;
+  output	[31:0]  q_pixel_draw;
 
   wire [5:0] address_tile[1:0];
-  wire [9:0] address_pixel[1:0];
+  wire [7:0] address_pixel[1:0];
 
-  wire [255:0] data_tile[1:0];
-  wire [16:0] data_pixel[1:0];
+  wire [127:0] data_tile[1:0];
+  wire [31:0] data_pixel[1:0];
 
   wire wren_tile[1:0];
   wire wren_pixel[1:0];
+  wire [3:0] byteena_pixel[1:0];
 
-  wire [255:0] q_tile[1:0];
-  wire [16:0] q_pixel[1:0];
+  wire [127:0] q_tile[1:0];
+  wire [31:0] q_pixel[1:0];
 
   logic display_index;
   logic draw_index;
 
-  linebuffer_ram ram0(address_tile[0], address_pixel[0], clk, data_tile[0], data_pixel[0], wren_tile[0], wren_pixel[0], q_tile[0], q_pixel[0]);
-  linebuffer_ram ram1(address_tile[1], address_pixel[1], clk, data_tile[1], data_pixel[1], wren_tile[1], wren_pixel[1], q_tile[1], q_pixel[1]);
+  linebuffer_ram ram0(address_tile[0], address_pixel[0], clk, data_tile[0], data_pixel[0], wren_tile[0], wren_pixel[0], byteena_pixel[0], q_tile[0], q_pixel[0]);
+  linebuffer_ram ram1(address_tile[1], address_pixel[1], clk, data_tile[1], data_pixel[1], wren_tile[1], wren_pixel[1], byteena_pixel[1], q_tile[1], q_pixel[1]);
 
   always_ff @(posedge clk) begin
     if(reset) begin
@@ -90,6 +95,9 @@ module linebuffer(
       wren_tile[draw_index] = wren_tile_draw;
       wren_pixel[draw_index] = wren_pixel_draw;
 
+      byteena_pixel[display_index] = byteena_pixel_display;
+      byteena_pixel[draw_index] = byteena_pixel_draw;
+
       q_tile_display = q_tile[display_index];
       q_pixel_display = q_pixel[display_index];
       q_tile_draw = q_tile[draw_index];
@@ -0,0 +1,411 @@
+/*
+ * pack_art: build the tile and sprite roms and the palette from the art
+ *
+ * Usage: pack_art sprite_pixels.mif tile_pixels.mif combined_sprite.mif
+ *                 sprite_spans.mif combined_tile.mif palette.mif
+ *
+ * The art is Quartus mifs of 16-bit pixels, red in bits 15:11, green in
+ * 10:6 and blue in 5:1. Sprite art is 32x32 per image, row major, image n
+ * at word n * 1024, one pixel per word; bit 0 set is a transparent pixel.
+ * Tile art is a 256-bit word per 16-pixel row, 16 rows per tile, the
+ * leftmost pixel in the low 16 bits.
+ *
+ * The roms hold 8-bit palette indices instead. The colours of all the art
+ * are cut down to the 255 of palette entries 1-255 (median cut, then a
+ * few k-means passes) and every pixel becomes the nearest of them; index
+ * 0 is a transparent sprite pixel. palette.mif is what the palette ram
+ * holds from reset, 16 bits an entry in the art's format.
+ *
+ * The sprite rom sprite_draw reads holds four pixels per 32-bit word, the
+ * leftmost in the low 8 bits, so a 32-pixel row is 8 words and image n
+ * starts at word n * 256. The tile rom holds a 128-bit word per tile row,
+ * the leftmost pixel in the low 8 bits. Words the art leaves out are
+ * transparent (sprites) or index 0 (tiles).
+ *
+ * The span table has a 16-bit word per row of each sprite image, row r of
+ * image n at word n * 32 + r: the first opaque column in bits 4:0, the
+ * last in bits 12:8, and bit 15 set if the row has no opaque pixel at all,
+ * so sprite_draw only reads the rom words that have something to draw.
+ *
+ * Built on the host: cc -o pack_art pack_art.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGES 22 // in sprite_pixels.mif; the 5-bit image number allows 32
+#define IMAGE_PIXELS (32 * 32)
+#define PIXELS_PER_WORD 4
+#define ROM_WORDS (IMAGES * IMAGE_PIXELS / PIXELS_PER_WORD)
+
+#define SPAN_WORDS (IMAGES * 32)
+#define SPAN_EMPTY 0x8000
+
+#define TILES 256 // 8-bit tile number
+#define TILE_PIXELS (16 * 16)
+#define TILE_WORDS (TILES * 16)
+
+#define TRANSPARENT 0x0001
+#define COLOURS (1 << 15) // 5 bits each of red, green and blue
+#define PALETTE 256 // entry 0 is transparent
+
+static unsigned short art[IMAGES * IMAGE_PIXELS];
+static unsigned short tile_art[TILES * TILE_PIXELS];
+
+static unsigned int counts[COLOURS]; // pixels of each colour in the art
+static unsigned short palette[PALETTE];
+static unsigned char index_of[COLOURS]; // palette entry each colour is drawn with
+
+/* Read "addr : data;" lines between BEGIN and END, both hex, into words of width 16 * per_word */
+static int read_mif(const char *path, unsigned short *pixels, int words, int per_word)
+{
+  FILE *f = fopen(path, "r");
+  char line[512];
+  int in_content = 0, read = 0;
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    unsigned int addr;
+    char data[256];
+    int len;
+
+    if (!in_content) {
+      if (strstr(line, "BEGIN"))
+        in_content = 1;
+      continue;
+    }
+    if (strstr(line, "END"))
+      break;
+    if (sscanf(line, " %x : %255[0-9A-Fa-f]", &addr, data) != 2)
+      continue;
+    if (addr >= (unsigned int) words) {
+      fprintf(stderr, "%s: address %x is past word %x\n", path, addr, words - 1);
+      fclose(f);
+      return -1;
+    }
+    // the last four digits are the leftmost pixel, the low 16 bits
+    len = strlen(data);
+    for (int k = 0; k < per_word; k++) {
+      char digits[5] = "0000";
+      for (int d = 0; d < 4; d++) {
+        int at = len - 4 * (k + 1) + d;
+        if (at >= 0)
+          digits[d] = data[at];
+      }
+      pixels[addr * per_word + k] = strtoul(digits, NULL, 16);
+    }
+    read++;
+  }
+  fclose(f);
+  if (!in_content) {
+    fprintf(stderr, "%s: no CONTENT BEGIN\n", path);
+    return -1;
+  }
+  return read;
+}
+
+/*
+ * Median cut: start with one box around every colour the art uses, keep
+ * splitting the box with the most pixels times its widest channel squared
+ * at the pixel-weighted median of that channel, and give each box the
+ * weighted mean of its colours
+ */
+struct box {
+  int first, count; // into colours[]
+  int axis, width; // widest channel and its range
+  long pixels; // of the art in the box
+};
+
+static int sort_axis;
+
+static int channel(int colour, int axis)
+{
+  return (colour >> (10 - 5 * axis)) & 0x1f; // 0 red, 1 green, 2 blue
+}
+
+static int compare_colours(const void *a, const void *b)
+{
+  return channel(*(const int *) a, sort_axis) - channel(*(const int *) b, sort_axis);
+}
+
+static void measure(struct box *b, const int *colours)
+{
+  b->pixels = 0;
+  for (int i = b->first; i < b->first + b->count; i++)
+    b->pixels += counts[colours[i]];
+  b->width = -1;
+  for (int axis = 0; axis < 3; axis++) {
+    int lo = 31, hi = 0;
+    for (int i = b->first; i < b->first + b->count; i++) {
+      int v = channel(colours[i], axis);
+      if (v < lo)
+        lo = v;
+      if (v > hi)
+        hi = v;
+    }
+    if (hi - lo > b->width) {
+      b->width = hi - lo;
+      b->axis = axis;
+    }
+  }
+}
+
+static int build_palette(void)
+{
+  static int colours[COLOURS];
+  static struct box boxes[PALETTE - 1];
+  int n = 0, nboxes = 1;
+
+  for (int c = 0; c < COLOURS; c++)
+    if (counts[c])
+      colours[n++] = c;
+  if (n == 0)
+    return 0;
+  boxes[0].first = 0;
+  boxes[0].count = n;
+  measure(&boxes[0], colours);
+
+  while (nboxes < PALETTE - 1) {
+    struct box *b = NULL, *split;
+    long total = 0, half = 0;
+    int i;
+
+    for (i = 0; i < nboxes; i++)
+      if (boxes[i].count > 1 && (!b || boxes[i].width * boxes[i].width * boxes[i].pixels >
+                                        b->width * b->width * b->pixels))
+        b = &boxes[i];
+    if (!b)
+      break; // every colour has an entry of its own
+    sort_axis = b->axis;
+    qsort(colours + b->first, b->count, sizeof(int), compare_colours);
+    for (i = b->first; i < b->first + b->count; i++)
+      total += counts[colours[i]];
+    // at least one colour either side, even if the last has most of the pixels
+    for (i = b->first; i < b->first + b->count - 2; i++) {
+      half += counts[colours[i]];
+      if (2 * half >= total)
+        break;
+    }
+    split = &boxes[nboxes++];
+    split->first = i + 1;
+    split->count = b->first + b->count - split->first;
+    b->count = split->first - b->first;
+    measure(b, colours);
+    measure(split, colours);
+  }
+
+  for (int e = 0; e < nboxes; e++) {
+    double sum[3] = {0, 0, 0}, total = 0;
+    int rgb[3];
+    for (int i = boxes[e].first; i < boxes[e].first + boxes[e].count; i++) {
+      for (int axis = 0; axis < 3; axis++)
+        sum[axis] += (double) channel(colours[i], axis) * counts[colours[i]];
+      total += counts[colours[i]];
+    }
+    for (int axis = 0; axis < 3; axis++)
+      rgb[axis] = (int) (sum[axis] / total + 0.5);
+    palette[e + 1] = rgb[0] << 11 | rgb[1] << 6 | rgb[2] << 1;
+  }
+  return nboxes;
+}
+
+/* Nearest entry for every colour the art uses; returns the mean squared error per pixel */
+static double map_colours(int entries, int *worst)
+{
+  long pixels = 0;
+  double error = 0;
+
+  *worst = 0;
+  for (int c = 0; c < COLOURS; c++) {
+    int best = 1, best_d = -1;
+    if (!counts[c])
+      continue;
+    for (int e = 1; e <= entries; e++) {
+      int p = palette[e] >> 1, d = 0;
+      for (int axis = 0; axis < 3; axis++) {
+        int diff = channel(c, axis) - channel(p, axis);
+        d += diff * diff;
+      }
+      if (best_d < 0 || d < best_d) {
+        best = e;
+        best_d = d;
+      }
+    }
+    index_of[c] = best;
+    if (best_d > *worst)
+      *worst = best_d;
+    error += (double) best_d * counts[c];
+    pixels += counts[c];
+  }
+  return pixels ? error / pixels : 0;
+}
+
+/* Move every entry to the weighted mean of the colours drawn with it (k-means), a few times over */
+#define REFINE_PASSES 16
+
+static void refine_palette(int entries)
+{
+  double before, after = 0;
+  int worst;
+
+  before = map_colours(entries, &worst);
+  for (int pass = 0; pass < REFINE_PASSES; pass++) {
+    static double sum[PALETTE][3], total[PALETTE];
+
+    memset(sum, 0, sizeof(sum));
+    memset(total, 0, sizeof(total));
+    for (int c = 0; c < COLOURS; c++) {
+      if (!counts[c])
+        continue;
+      for (int axis = 0; axis < 3; axis++)
+        sum[index_of[c]][axis] += (double) channel(c, axis) * counts[c];
+      total[index_of[c]] += counts[c];
+    }
+    for (int e = 1; e <= entries; e++) {
+      int rgb[3];
+      if (total[e] == 0)
+        continue; // nothing nearest to it, leave it be
+      for (int axis = 0; axis < 3; axis++)
+        rgb[axis] = (int) (sum[e][axis] / total[e] + 0.5);
+      palette[e] = rgb[0] << 11 | rgb[1] << 6 | rgb[2] << 1;
+    }
+    after = map_colours(entries, &worst);
+  }
+  printf("mean squared error %.2f (median cut) -> %.2f, worst %d (5-bit channels)\n",
+         before, REFINE_PASSES ? after : before, worst);
+}
+
+static int write_sprite_rom(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = %d;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          ROM_WORDS, 8 * PIXELS_PER_WORD);
+  for (int w = 0; w < ROM_WORDS; w++) {
+    const unsigned short *p = art + w * PIXELS_PER_WORD;
+    unsigned char n[PIXELS_PER_WORD];
+    for (int k = 0; k < PIXELS_PER_WORD; k++)
+      n[k] = (p[k] & TRANSPARENT) ? 0 : index_of[p[k] >> 1];
+    fprintf(f, "%04X : %02X%02X%02X%02X;\n", w, n[3], n[2], n[1], n[0]);
+  }
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+static int write_tile_rom(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 128;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          TILE_WORDS);
+  for (int w = 0; w < TILE_WORDS; w++) {
+    fprintf(f, "%03X : ", w);
+    for (int k = 15; k >= 0; k--)
+      fprintf(f, "%02X", index_of[tile_art[w * 16 + k] >> 1]);
+    fprintf(f, ";\n");
+  }
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+static int write_palette(const char *path, int entries)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 16;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          PALETTE);
+  for (int e = 0; e < PALETTE; e++)
+    fprintf(f, "%02X : %04X;\n", e, e <= entries ? palette[e] : 0);
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+/* First and last opaque column of every row, and what that saves sprite_draw on the art's images */
+static int write_spans(const char *path, int images)
+{
+  FILE *f = fopen(path, "w");
+  int empty = 0, full_words = 0, span_words = 0;
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 16;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          SPAN_WORDS);
+  for (int row = 0; row < SPAN_WORDS; row++) {
+    const unsigned short *p = art + row * 32;
+    int first = -1, last = -1;
+    unsigned int span;
+
+    for (int c = 0; c < 32; c++)
+      if (!(p[c] & TRANSPARENT)) {
+        if (first < 0)
+          first = c;
+        last = c;
+      }
+    span = first < 0 ? SPAN_EMPTY : last << 8 | first;
+    if (row < images * 32) {
+      if (first < 0)
+        empty++;
+      else
+        span_words += last / PIXELS_PER_WORD - first / PIXELS_PER_WORD + 1;
+      full_words += 32 / PIXELS_PER_WORD;
+    }
+    fprintf(f, "%03X : %04X;\n", row, span);
+  }
+  fprintf(f, "END;\n");
+  printf("%d of %d rows empty, %d of %d rom words in the spans\n",
+         empty, images * 32, span_words, full_words);
+  return fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+  int words, tile_words, images, used = 0, entries;
+
+  if (argc != 7) {
+    fprintf(stderr, "Usage: %s sprite_pixels.mif tile_pixels.mif combined_sprite.mif "
+            "sprite_spans.mif combined_tile.mif palette.mif\n", argv[0]);
+    return 1;
+  }
+  for (int i = 0; i < IMAGES * IMAGE_PIXELS; i++)
+    art[i] = TRANSPARENT;
+  if ((words = read_mif(argv[1], art, IMAGES * IMAGE_PIXELS, 1)) < 0 ||
+      (tile_words = read_mif(argv[2], tile_art, TILE_WORDS, 16)) < 0)
+    return 1;
+  images = (words + IMAGE_PIXELS - 1) / IMAGE_PIXELS;
+
+  for (int i = 0; i < IMAGES * IMAGE_PIXELS; i++)
+    if (!(art[i] & TRANSPARENT))
+      counts[art[i] >> 1]++;
+  for (int i = 0; i < tile_words * 16; i++)
+    counts[tile_art[i] >> 1]++;
+  for (int c = 0; c < COLOURS; c++)
+    used += counts[c] != 0;
+  entries = build_palette();
+  printf("%d colours -> %d palette entries\n", used, entries);
+  refine_palette(entries);
+
+  if (write_sprite_rom(argv[3]) || write_spans(argv[4], images) ||
+      write_tile_rom(argv[5]) || write_palette(argv[6], entries))
+    return 1;
+  printf("%d pixels (%d images) -> %d words of %d pixels, %d tile rows -> %d words of 16\n",
+         words, images, ROM_WORDS, PIXELS_PER_WORD, tile_words, TILE_WORDS);
+  return 0;
+}
@@ -3,66 +3,66 @@
 module sprite_active(input logic clk,
                       input logic reset,
                       input logic write_sprite,
-                      input logic [3:0] sprite_number_write,
-                      input logic [3:0] sprite_number,
-                      input logic [24:0] sprite_register,
-                      input logic write_vcount,
+                      input logic [4:0] sprite_number_write, // 0-31
+                      input logic [4:0] sprite_number, // the sprite to output
+                      input logic [4:0] next_number, // the sprite to draw after it
+                      input logic [26:0] sprite_register,
                       input logic [9:0] actual_vcount, // the line being drawn
-                      output logic [4:0] row_in_sprite, // the row needed to be drawn in the sprite
+                      output logic [31:0] hits, // bit i: sprite i shows on actual_vcount, one cycle late
+                      output logic [4:0] row_in_sprite, // the row needed to be drawn in the sprite, after vflip
                       output logic [9:0] sprite_column, // where the sprite is located
                       output logic [4:0] img_num,
-                      output logic is_active, // input sprite is indeed, active
-                      output logic finish // finish the sprite
+                      output logic hflip, // draw the row right to left
+                      output logic [4:0] next_row_in_sprite, // same for next_number, for its span
+                      output logic [4:0] next_img_num,
+                      input logic latch, // writes only go to the shadow bank
+                      input logic commit // one cycle pulse: shadow bank -> active bank
 );
 
 
   // sprite array access
-  logic [11:0][24:0] sprite_array;
-  // indexing: 24 is active, 23-15 is v/row, 14-5 is h/col 4-0 is image number
-  
+  logic [31:0][26:0] sprite_array;
+  // indexing: 26 is vflip, 25 is hflip, 24 is active, 23-15 is v/row, 14-5 is h/col 4-0 is image number
 
+
+  // every sprite is checked against the line at once, every cycle, so the
+  // hits for the next line are ready long before the tiles are done
   always_ff @(posedge clk) begin
-    if(reset) begin
-      finish <= 1;
-      is_active <= 0;
-    end else if (write_vcount) begin
-      finish <= 0;
-      if (actual_vcount < 480) begin
-        // check corresponding sprite register
-        if (sprite_array[sprite_number][24] == 1) begin
-          // if this sprite is active at somewhere on the screen
-          if (actual_vcount >= sprite_array[sprite_number][23:15] && 
-              actual_vcount - sprite_array[sprite_number][23:15] < 32) begin
-            // is within range, output sprite
-            row_in_sprite <= (actual_vcount - sprite_array[sprite_number][23:15]);
-            sprite_column <= sprite_array[sprite_number][14:5];
-            img_num <= sprite_array[sprite_number][4:0];
-            is_active <= 1;
-            finish <= 1;
-          end else begin
-            // is not within range
-            is_active <= 0;
-            finish <= 1;
-          end
-        end else begin
-          // sprite not active 
-          is_active <= 0;
-          finish <= 1;
-        end
-      end else if (actual_vcount >= 480) begin
-        is_active <= 0;
-        finish <= 1; // inactive lines, nothing to do
-      end
+    if (reset) begin
+      hits <= 0;
+    end else begin
+      for (int i = 0; i < 32; i++)
+        hits[i] <= actual_vcount < 480 && sprite_array[i][24] &&
+                   actual_vcount >= sprite_array[i][23:15] &&
+                   actual_vcount - sprite_array[i][23:15] < 32;
     end
   end
 
+  // the sprite being drawn; a vflipped sprite reads its rows bottom up
+  assign row_in_sprite = (actual_vcount - sprite_array[sprite_number][23:15]) ^ {5{sprite_array[sprite_number][26]}};
+  assign sprite_column = sprite_array[sprite_number][14:5];
+  assign img_num = sprite_array[sprite_number][4:0];
+  assign hflip = sprite_array[sprite_number][25];
+  assign next_row_in_sprite = (actual_vcount - sprite_array[next_number][23:15]) ^ {5{sprite_array[next_number][26]}};
+  assign next_img_num = sprite_array[next_number][4:0];
+
+  // software writes land in the shadow bank, and also in the active bank
+  // unless latched; commit copies the whole bank in one cycle so a
+  // multi-register update never shows half applied
+  logic [31:0][26:0] sprite_shadow;
+
   // for when needing to change sprite_register value
-  // -1 because incoming number because sprite register base is base + 1
   always_ff @(posedge clk) begin
+    if (commit) begin
+      sprite_array <= sprite_shadow;
+    end
+    if (write_sprite && !latch) begin
+      sprite_array[sprite_number_write][26:0] <= sprite_register[26:0];
+    end
     if (write_sprite) begin
-      sprite_array[sprite_number_write - 1][24:0] <= sprite_register[24:0];
+      sprite_shadow[sprite_number_write][26:0] <= sprite_register[26:0];
     end
   end
 
-  
+
 endmodule
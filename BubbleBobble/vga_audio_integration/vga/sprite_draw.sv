@@ -1,49 +1,133 @@
-
-
+/*
+ * Draws one row of a sprite four pixels a cycle. The rom holds four
+ * 8-bit palette indices per word (pack_art.c), 0 for a transparent pixel,
+ * and the line buffer takes a word of four with an enable per pixel, so
+ * the row goes out as aligned line buffer words: a sprite at a column
+ * that is not a multiple of 4 spans 9 of them, each made of the end of
+ * one rom word and the start of the next.
+ *
+ * Only the words between the first and last opaque pixel of the row are
+ * read, from the span table pack_art.c puts next to the rom. The span
+ * is looked up for the sprite the loader starts next (span_row, span_img)
+ * so it is ready on start; a row with nothing opaque finishes at once.
+ *
+ * An hflipped sprite reads the row's rom words right to left and puts
+ * the four pixels of each word in reverse; its span is mirrored too, so
+ * the same words are read and it costs the same. vflip is only a
+ * different row_in_sprite (sprite_active).
+ *
+ * Cycles from start to finish: 2 for the start and the rom, then one per
+ * line buffer word of the span, at most 10 (aligned) or 11 against 34 a
+ * pixel at a time; 1 for an empty row.
+ */
 module sprite_draw(input logic clk,
                     input logic reset,
                     input logic start,
                     input logic [4:0] row_in_sprite, // the row needed to be drawn in the sprite
                     input logic [9:0] sprite_column, // where the sprite is located
                     input logic [4:0] img_num,
+                    input logic hflip, // mirror the row left to right
+                    input logic [4:0] span_row, // row_in_sprite and img_num of the sprite the
+                    input logic [4:0] span_img, // next start draws, a cycle ahead of it
                     output logic wren,
-                    output logic [9:0] pixel_hcount, // where the pixel goes on the row
-                    output logic [15:0] data, // pixel data
+                    output logic [7:0] pixel_word, // which 4 pixels of the row, column / 4
+                    output logic [31:0] data, // palette indices, leftmost pixel in 7:0
+                    output logic [3:0] byteena, // 1 bit per pixel, off for transparent pixels
                     output logic finish
 );
 
-  logic [14:0] sprite_rom_address;
-  sprite_rom(sprite_rom_address, clk, data); 
+  logic [12:0] sprite_rom_address;
+  logic [31:0] q;
+  sprite_rom rom(sprite_rom_address, clk, q);
+
+  // 4:0 first opaque column, 12:8 last, 15 no opaque pixel in the row
+  logic [15:0] span;
+  sprite_span_rom spans({span_img, span_row}, clk, span);
+
+  // first and last opaque column as drawn, mirrored for hflip (31 - c is ~c)
+  logic [4:0] span_first;
+  logic [4:0] span_last;
+  assign span_first = hflip ? ~span[12:8] : span[4:0];
+  assign span_last = hflip ? ~span[4:0] : span[12:8];
+
+  logic [7:0] first_word; // line buffer word of the sprite's left edge
+  logic [1:0] offset; // pixels from the start of that word to the left edge
+  logic [3:0] last; // line buffer word of the last opaque pixel, from first_word
+  logic [3:0] n; // word being read from the rom, counted as drawn
+  logic flip; // hflip of the sprite being drawn
+  logic reading;
+  logic [3:0] n_q; // word that q holds
+  logic valid_q;
+  logic first_q; // q is the first word read, prev_q is not part of the span
+  logic [31:0] prev_q; // the rom word before it
+  logic [31:0] q_drawn; // q with its pixels in drawing order
+
+  assign q_drawn = flip ? {q[7:0], q[15:8], q[23:16], q[31:24]} : q;
 
-  logic [5:0] col;
-  assign wren = (!finish) && (col > 0) && (data[0] == 0); // write only not transparent 
+  // line buffer word n_q: the last offset pixels of rom word n_q - 1
+  // then the first 4 - offset pixels of rom word n_q
+  logic [63:0] pair;
+  logic [31:0] pixels;
+  logic [3:0] show;
+  assign pair = {q_drawn, prev_q} >> ((3'd4 - offset) * 8);
+  assign pixels = pair[31:0];
+
+  always_comb begin
+    for (int k = 0; k < 4; k++) begin
+      // pixel k is pixel 4 * n_q + k - offset of the sprite row
+      show[k] = !((first_q && k < offset) || (n_q == 8 && k >= offset)) &&
+                pixels[8*k +: 8] != 0; // write only not transparent
+    end
+  end
 
   always_ff @(posedge clk) begin
-    if (reset) begin 
+    wren <= 0;
+    if (reset) begin
       finish <= 1;
+      reading <= 0;
+      valid_q <= 0;
     end else if (start) begin
-      // img_num * 1024 (# of pixels per img) + row_in_sprite * 32 (# of pixels per row)
-      sprite_rom_address <= (img_num << 10) + (row_in_sprite << 5);
-      col <= 0;
-      finish <= 0;
-      pixel_hcount <= 0;
+      valid_q <= 0;
+      if (span[15]) begin
+        reading <= 0;
+        finish <= 1; // nothing to draw in this row
+      end else begin
+        // img_num * 256 (# of words per img) + row_in_sprite * 8 (# of words per row) + first opaque word,
+        // word 7 - n of the row when hflipped
+        sprite_rom_address <= (img_num << 8) + (row_in_sprite << 3) + (span_first[4:2] ^ {3{hflip}});
+        first_word <= sprite_column[9:2];
+        offset <= sprite_column[1:0];
+        last <= ({1'b0, span_last} + sprite_column[1:0]) >> 2;
+        n <= span_first[4:2];
+        flip <= hflip;
+        reading <= 1;
+        first_q <= 1;
+        finish <= 0;
+      end
     end else if (!finish) begin
-      // get pixel data from rom
-      if (col < 32 && pixel_hcount < 639) begin
-        col <= col + 1;
-        sprite_rom_address <= sprite_rom_address + 1;
-      end else
-        finish <= 1;
-
-      // output linebuffer address to draw
-      if (col == 0) begin // wait 1 cycle to sync with data_tile_draw 
-        pixel_hcount <= sprite_column;  
-      end else if (pixel_hcount < 639) begin
-        pixel_hcount <= pixel_hcount + 1;
+      // get pixel data from rom, it shows up on q a cycle after the address
+      if (reading) begin
+        if (n == last)
+          reading <= 0;
+        n <= n + 1;
+        sprite_rom_address <= flip ? sprite_rom_address - 1 : sprite_rom_address + 1;
+      end
+      n_q <= n;
+      valid_q <= reading;
+
+      // output linebuffer word to draw, nothing past column 639
+      if (valid_q) begin
+        prev_q <= q_drawn;
+        first_q <= 0;
+        pixel_word <= first_word + n_q;
+        data <= pixels;
+        byteena <= show;
+        wren <= (show != 0) && (first_word + n_q < 160);
+        if (n_q == last)
+          finish <= 1;
       end
     end
   end
 
 
-  
 endmodule
@@ -1,97 +1,105 @@
+/*
+ * Sprites for one line: sprite_active compares all 32 sprites against the
+ * next line in parallel while the tiles load, and on start the hits are
+ * drawn lowest number first (higher numbers end up on top), skipping the
+ * sprites that are not on the line at no cost.
+ *
+ * Line budget, 1600 cycles: the tiles are done at hcount 43, sprites
+ * start at 44 and the line buffers switch at 1597, which leaves about
+ * 1550 cycles. A sprite takes 4 cycles plus one per line buffer word of
+ * its row's span (2 in sprite_draw, 2 here to pick it and see it
+ * finish): 12 for a fully opaque row at a column that is a multiple of 4,
+ * 13 at any other column, 3 when the row is empty. So over 100 sprites
+ * would fit on one line; 32 fully opaque misaligned rows on the same line
+ * finish at hcount 46 + 32 * 13 = 462. tb_sprite_budget.sv checks these
+ * figures cycle for cycle, with the real art and with every row opaque.
+ * Measured there (tb_sprite_budget.log): tile_finish rises at hcount 43,
+ * sprites start at 44, and 32 sprites on one line finish at 393 with the
+ * real art at aligned columns, 408 misaligned with or without hflip, and
+ * 462 with every row opaque.
+ */
 module sprite_loader(input logic clk,
                    input logic reset,
                    input logic start,
                    input logic write,
-                   input logic [3:0] sprite_register_number,
-                   input logic [24:0] writedata,
+                   input logic [4:0] sprite_register_number, // 0-31
+                   input logic [26:0] writedata,
                    input logic [9:0] vcount,
-                   output logic [9:0] address_pixel_draw, 
-                   output logic [15:0] data_pixel_draw,
+                   output logic [7:0] address_pixel_draw, // 4 pixels per word
+                   output logic [31:0] data_pixel_draw, // palette indices
+                   output logic [3:0] byteena_pixel_draw,
                    output logic finish,
-                   output logic wren_pixel_draw
+                   output logic wren_pixel_draw,
+                   input logic latch, // sprite writes wait for a commit
+                   input logic commit // copy latched sprites to the active bank
 );
-    logic sprite_active_start;
-    logic [3:0] sprite_number;
-    logic [9:0] actual_vcount; 
+    logic [4:0] sprite_number;
+    logic [9:0] actual_vcount;
+    logic [31:0] hits;
     logic [4:0] row_in_sprite;
     logic [9:0] sprite_column;
     logic [4:0] img_num;
-    logic is_active;
-    logic sprite_active_finish;
-    logic checking;
-    logic checked;
+    logic hflip;
 
-    sprite_active(clk, reset, write, sprite_register_number, sprite_number, writedata, sprite_active_start, actual_vcount, row_in_sprite, sprite_column, img_num, is_active, sprite_active_finish);
+    // calculate actual vcount: the line after this one, 0 after the last blank line
+    assign actual_vcount = (vcount == 524) ? 10'd0 : vcount + 10'd1;
+
+    // sprites on this line not drawn yet, and the lowest of them
+    logic [31:0] pending;
+    logic [4:0] next_sprite;
+    logic [4:0] next_row_in_sprite;
+    logic [4:0] next_img_num;
+
+    sprite_active active(clk, reset, write, sprite_register_number, sprite_number, next_sprite, writedata, actual_vcount, hits, row_in_sprite, sprite_column, img_num, hflip, next_row_in_sprite, next_img_num, latch, commit);
 
 
     logic sprite_draw_start;
     logic sprite_draw_finish;
     logic drawing;
 
-    sprite_draw(clk, reset, sprite_draw_start, row_in_sprite, sprite_column, img_num, wren_pixel_draw, address_pixel_draw, data_pixel_draw, sprite_draw_finish); 
-    
+    sprite_draw draw(clk, reset, sprite_draw_start, row_in_sprite, sprite_column, img_num, hflip, next_row_in_sprite, next_img_num, wren_pixel_draw, address_pixel_draw, data_pixel_draw, byteena_pixel_draw, sprite_draw_finish);
+
+    always_comb begin
+        next_sprite = 0;
+        for (int i = 31; i >= 0; i--)
+            if (pending[i])
+                next_sprite = i;
+    end
 
     always_ff @(posedge clk) begin
         if (reset) begin
             finish <= 1;
             drawing <= 0;
-            checked <= 0;
-            checking <= 0;
-            sprite_active_start <= 0;
+            pending <= 0;
+            sprite_number <= 0;
             sprite_draw_start <= 0;
         end else if (start) begin
-            sprite_number <= 0;
-            finish <= 0;
-            checked <= 0;
-            checking <= 0;
             drawing <= 0;
-            // calculate actual vcount
-            if (vcount < 479) begin
-                actual_vcount <= vcount + 1;
-            end else if (vcount >= 479 && vcount < 524) begin
-                finish <= 1; // inactive lines, nothing to draw      
-            end else if (vcount == 524) begin 
-                actual_vcount <= 0; // draw the first line
+            sprite_draw_start <= 0;
+            pending <= hits; // none on inactive lines
+            if (vcount < 479 || vcount == 524) begin
+                finish <= 0;
+            end else begin
+                finish <= 1; // inactive lines, nothing to draw
             end
         end else if (!finish) begin
-            if (sprite_number < 12) begin
-                // check sprite active
-                if (!checked) begin
-                    if (!checking) begin
-                        sprite_active_start <= 1;
-                        checking <= 1;
-                    end else begin
-                        sprite_active_start <= 0;
-                        if (sprite_active_finish) begin
-                            checking <= 0;
-                            checked <= 1;
-                        end
-                    end
+            if (!drawing) begin
+                if (pending == 0) begin
+                    finish <= 1;
                 end else begin
-                    // start drawing if active
-                    if (is_active) begin 
-                        if (!drawing) begin
-                            drawing <= 1;
-                            sprite_draw_start <= 1;
-                        end else begin
-                            sprite_draw_start <= 0;
-                        end         
-                        
-                        // sprite_draw_start = 0 happens in the same cycle as sprite_draw_finish = 0
-                        // need to check sprite_draw_start = 0, otherwise will detect old finish value that haven't been set to 0
-                        if (drawing && (sprite_draw_start == 0) && sprite_draw_finish) begin
-                            drawing <= 0;
-                            sprite_number <= sprite_number + 1;
-                            checked <= 0;
-                        end
-                    // skip if not active
-                    end else begin
-                        sprite_number <= sprite_number + 1;
-                        checked <= 0;
-                    end
+                    // sprite_active looks up the sprite while sprite_draw_start is high
+                    sprite_number <= next_sprite;
+                    pending[next_sprite] <= 0;
+                    sprite_draw_start <= 1;
+                    drawing <= 1;
                 end
             end else begin
-                finish <= 1;
+                sprite_draw_start <= 0;
+                // sprite_draw_start = 0 happens in the same cycle as sprite_draw_finish = 0
+                // need to check sprite_draw_start = 0, otherwise will detect old finish value that haven't been set to 0
+                if ((sprite_draw_start == 0) && sprite_draw_finish) begin
+                    drawing <= 0;
+                end
             end
         end
     end
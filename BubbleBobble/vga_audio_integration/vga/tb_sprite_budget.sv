@@ -0,0 +1,288 @@
+/*
+ * Cycle budget testbench for sprite_loader and sprite_draw: puts all 32
+ * sprites on one line, starts them the way vga_top does after the tiles,
+ * and reports the hcount the sprites finish at.
+ *
+ *   verilator --binary --timing -Wno-fatal --top-module tb_sprite_budget tb_sprite_budget.sv \
+ *       sprite_loader.sv sprite_active.sv sprite_draw.sv tile_loader.sv
+ *   ./obj_dir/Vtb_sprite_budget
+ * or
+ *   vlog -sv sprite_loader.sv sprite_active.sv sprite_draw.sv tile_loader.sv tb_sprite_budget.sv
+ *   vsim -c tb_sprite_budget -do "run -all"
+ *
+ * from this directory. The rom megafunctions are replaced by the models at
+ * the end of this file, which load combined_sprite.mif and sprite_spans.mif.
+ *
+ * Four lines are drawn: aligned columns, misaligned columns, misaligned
+ * with hflip and vflip, and misaligned with every rom row fully opaque,
+ * the worst case. For each the finish hcount must be the one the budget in
+ * sprite_loader.sv gives, 46 plus 4 cycles a sprite and one per line buffer
+ * word of its span (3 for an empty row), and the pixels drawn must match
+ * the rom. tb_sprite_budget.log is the output of the last run.
+ */
+
+`timescale 1ns/1ps
+
+module tb_sprite_budget;
+
+  logic clk = 0;
+  logic reset = 1;
+  logic [10:0] hcount = 0;
+  logic [9:0] vcount = 0;
+
+  always #10 clk = ~clk; // 50 MHz
+
+  // 800x525 at two clocks a pixel, as vga_counters in vga_top.sv
+  always_ff @(posedge clk)
+    if (hcount == 1599) begin
+      hcount <= 0;
+      vcount <= (vcount == 524) ? 10'd0 : vcount + 10'd1;
+    end else
+      hcount <= hcount + 11'd1;
+
+  int errors = 0;
+
+  task automatic fail(input string msg);
+    errors++;
+    $display("ERROR: %s", msg);
+  endtask
+
+  // tiles, only for when they finish
+  logic tile_start;
+  logic tile_finish;
+  logic [5:0] address_tile_draw;
+  logic [127:0] data_tile_draw;
+
+  tile_loader tiles(clk, reset, tile_start, 1'b0, 19'd0, vcount, address_tile_draw, data_tile_draw, tile_finish);
+
+  logic sprite_start;
+  logic sprite_finish;
+  logic sprite_write = 0;
+  logic [4:0] sprite_register_number = 0;
+  logic [26:0] sprite_writedata = 0;
+  logic [7:0] address_pixel_draw;
+  logic [31:0] data_pixel_draw;
+  logic [3:0] byteena_pixel_draw;
+  logic wren_pixel_draw;
+
+  sprite_loader sprites(clk, reset, sprite_start, sprite_write, sprite_register_number, sprite_writedata, vcount,
+                        address_pixel_draw, data_pixel_draw, byteena_pixel_draw, sprite_finish, wren_pixel_draw,
+                        1'b0, 1'b0);
+
+  // start the tiles at hcount 0 and the sprites once they are done, as vga_top.sv
+  logic drawing_sprite;
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      tile_start <= 0;
+      sprite_start <= 0;
+      drawing_sprite <= 0;
+    end else if (vcount < 479 || vcount == 524) begin
+      if (hcount == 0) begin
+        tile_start <= 1;
+        drawing_sprite <= 0;
+      end else
+        tile_start <= 0;
+      if (hcount > 1 && tile_finish && (drawing_sprite == 0)) begin
+        sprite_start <= 1;
+        drawing_sprite <= 1;
+      end
+      if (drawing_sprite)
+        sprite_start <= 0;
+    end
+  end
+
+  // the sprite line buffer: what the sprites wrote, 0 where they did not
+  logic [7:0] line [0:639];
+  logic clear = 0;
+
+  always_ff @(posedge clk) begin
+    if (clear)
+      for (int x = 0; x < 640; x++)
+        line[x] <= 0;
+    else if (wren_pixel_draw)
+      for (int k = 0; k < 4; k++)
+        if (byteena_pixel_draw[k])
+          line[address_pixel_draw * 4 + k] <= data_pixel_draw[8*k +: 8];
+  end
+
+  // rom contents, through the models below
+  function automatic logic [7:0] rom_pixel(input int img, input int row, input int col);
+    return sprites.draw.rom.mem[img * 256 + row * 8 + col / 4][8 * (col % 4) +: 8];
+  endfunction
+
+  function automatic logic [15:0] rom_span(input int img, input int row);
+    return sprites.draw.spans.mem[img * 32 + row];
+  endfunction
+
+  // sprite register fields for one line
+  logic [26:0] regs [0:31];
+
+  // cycles sprite_loader takes for one sprite, per the budget
+  function automatic int sprite_cycles(input logic [26:0] r, input int line_n);
+    int row = (line_n - r[23:15]) ^ (r[26] ? 31 : 0);
+    logic [15:0] span = rom_span(r[4:0], row);
+    int first = r[25] ? 31 - span[12:8] : span[4:0];
+    int last = r[25] ? 31 - span[4:0] : span[12:8];
+    if (span[15])
+      return 3;
+    return 4 + ((last + r[6:5]) >> 2) - (first >> 2) + 1;
+  endfunction
+
+  // write the sprites, draw line line_n and check it
+  task automatic run(input string name, input int line_n);
+    logic [7:0] expect_line [0:639];
+    int start_h, finish_h, expect_h, cycles, row, x, src;
+    logic [7:0] p;
+
+    // the registers go in on the line before, the line is drawn while vcount is line_n - 1
+    while (!(vcount == line_n - 2 && hcount == 100))
+      @(negedge clk);
+    for (int i = 0; i < 32; i++) begin
+      sprite_write = 1;
+      sprite_register_number = 5'(i);
+      sprite_writedata = regs[i];
+      @(negedge clk);
+    end
+    sprite_write = 0;
+
+    while (!(vcount == line_n - 1 && hcount == 0))
+      @(negedge clk);
+    clear = 1;
+    @(negedge clk);
+    clear = 0;
+    while (!sprite_start)
+      @(negedge clk);
+    start_h = hcount;
+    @(negedge clk);
+    while (!sprite_finish)
+      @(negedge clk);
+    finish_h = hcount;
+
+    cycles = 0;
+    for (int i = 0; i < 32; i++)
+      cycles += sprite_cycles(regs[i], line_n);
+    expect_h = start_h + 2 + cycles; // a cycle to take hits, one to see none are left
+    $display("%s: sprites start at hcount %0d, finish at %0d, %0.2f cycles a sprite (budget %0d)",
+             name, start_h, finish_h, (finish_h - start_h - 2) / 32.0, expect_h);
+    if (finish_h != expect_h)
+      fail($sformatf("%s: finished at hcount %0d, the budget says %0d", name, finish_h, expect_h));
+    if (finish_h >= 1597)
+      fail($sformatf("%s: not done before the line buffers switch", name));
+
+    // lowest number first, so higher numbers end up on top
+    for (x = 0; x < 640; x++)
+      expect_line[x] = 0;
+    for (int i = 0; i < 32; i++) begin
+      row = (line_n - regs[i][23:15]) ^ (regs[i][26] ? 31 : 0);
+      for (x = 0; x < 32; x++) begin
+        src = regs[i][25] ? 31 - x : x;
+        p = rom_pixel(regs[i][4:0], row, src);
+        if (p != 0 && regs[i][14:5] + x < 640)
+          expect_line[regs[i][14:5] + x] = p;
+      end
+    end
+    for (x = 0; x < 640; x++)
+      if (line[x] !== expect_line[x])
+        fail($sformatf("%s: pixel %0d is %h, expected %h", name, x, line[x], expect_line[x]));
+  endtask
+
+  // sprite i at column col, its row i*7 % 32 on line line_n
+  function automatic logic [26:0] sprite(input int i, input int line_n, input int col,
+                                         input bit hflip, input bit vflip);
+    return {vflip, hflip, 1'b1, 9'(line_n - (i * 7) % 32), 10'(col), 5'(i % 16)};
+  endfunction
+
+  initial begin
+    repeat (4) @(negedge clk);
+    reset = 0;
+
+    for (int i = 0; i < 32; i++)
+      regs[i] = sprite(i, 100, 16 * i + 8, 0, 0);
+    run("aligned", 100);
+
+    for (int i = 0; i < 32; i++)
+      regs[i] = sprite(i, 200, 16 * i + 1 + i % 3, 0, 0);
+    run("misaligned", 200);
+
+    for (int i = 0; i < 32; i++)
+      regs[i] = sprite(i, 300, 16 * i + 1 + i % 3, 1, i % 2);
+    run("misaligned, hflip", 300);
+
+    // every row fully opaque: the most a line of sprites can take
+    for (int a = 0; a < 5632; a++)
+      sprites.draw.rom.mem[a] = 32'h05060708;
+    for (int a = 0; a < 704; a++)
+      sprites.draw.spans.mem[a] = 16'h1f00;
+    for (int i = 0; i < 32; i++)
+      regs[i] = sprite(i, 400, 16 * i + 1 + i % 3, i % 2, 0);
+    run("worst case", 400);
+
+    if (errors == 0)
+      $display("PASS");
+    else
+      $display("FAIL: %0d errors", errors);
+    $finish;
+  end
+
+  initial begin
+    #(20 * 1600 * 525 * 2);
+    $fatal(1, "timeout");
+  end
+
+endmodule
+
+// Simulation models of the altsyncram roms: the address is registered, q is not
+
+module sprite_rom(input logic [12:0] address, input logic clock, output logic [31:0] q);
+  logic [31:0] mem [0:5631]; // numwords_a in sprite_rom.v
+  initial begin
+    int fd = $fopen("combined_sprite.mif", "r");
+    string s;
+    int unsigned a, d;
+    if (fd == 0)
+      $fatal(1, "can't open combined_sprite.mif");
+    while (!$feof(fd)) begin
+      void'($fgets(s, fd));
+      if ($sscanf(s, "%h : %h;", a, d) == 2) // data lines only
+        mem[a] = d;
+    end
+    $fclose(fd);
+  end
+  always_ff @(posedge clock)
+    q <= mem[address];
+endmodule
+
+module sprite_span_rom(input logic [9:0] address, input logic clock, output logic [15:0] q);
+  logic [15:0] mem [0:703]; // numwords_a in sprite_span_rom.v
+  initial begin
+    int fd = $fopen("sprite_spans.mif", "r");
+    string s;
+    int unsigned a, d;
+    if (fd == 0)
+      $fatal(1, "can't open sprite_spans.mif");
+    while (!$feof(fd)) begin
+      void'($fgets(s, fd));
+      if ($sscanf(s, "%h : %h;", a, d) == 2)
+        mem[a] = 16'(d);
+    end
+    $fclose(fd);
+  end
+  always_ff @(posedge clock)
+    q <= mem[address];
+endmodule
+
+// contents don't matter for the timing
+module tile_array(input logic [10:0] address_a, input logic [10:0] address_b, input logic clock,
+                  input logic [7:0] data_a, input logic [7:0] data_b, input logic wren_a, input logic wren_b,
+                  output logic [7:0] q_a, output logic [7:0] q_b);
+  always_ff @(posedge clock) begin
+    q_a <= 0;
+    q_b <= 0;
+  end
+endmodule
+
+module tile_rom(input logic [11:0] address, input logic clock, output logic [127:0] q);
+  always_ff @(posedge clock)
+    q <= 0;
+endmodule
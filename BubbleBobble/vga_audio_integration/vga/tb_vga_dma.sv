@@ -0,0 +1,288 @@
+/*
+ * Testbench for vga_dma.sv. The frame sits in a model of HPS memory behind
+ * an Avalon slave with random wait states and a fixed read latency, and
+ * software writes steal random cycles through hold.
+ *
+ *   verilator --binary --timing -Wno-fatal --top-module tb_vga_dma tb_vga_dma.sv vga_dma.sv
+ *   ./obj_dir/Vtb_vga_dma
+ * or
+ *   vlog -sv vga_dma.sv tb_vga_dma.sv && vsim -c tb_vga_dma -do "run -all"
+ *
+ * Checks that a request before or inside the start window (lines 480-499)
+ * starts in it and a later one waits for the next frame, that the 300 tile
+ * and 32 sprite reads go out in order with only one outstanding, that every
+ * tile and sprite word arrives intact before line 524, and that a slave too
+ * slow for vertical blank sets the overrun flag. tb_vga_dma.log is the
+ * output of the last run.
+ */
+
+`timescale 1ns/1ps
+
+module tb_vga_dma;
+
+  localparam DMA_ADDR   = 6'd53;
+  localparam DMA_CTRL   = 6'd54;
+  localparam DMA_STATUS = 6'd55;
+  localparam DMA_CYCLES = 6'd56;
+
+  localparam BASE  = 32'h3000_0000;
+  localparam WORDS = 332;
+
+  logic clk = 0;
+  logic reset = 1;
+  logic [10:0] hcount = 0;
+  logic [9:0] vcount = 0;
+
+  logic csr_write = 0;
+  logic [5:0] address = DMA_STATUS;
+  logic [31:0] writedata = 0;
+  logic [31:0] csr_readdata;
+
+  logic [31:0] dma_address;
+  logic dma_read;
+  logic [31:0] dma_readdata = 0;
+  logic dma_waitrequest;
+  logic dma_readdatavalid = 0;
+
+  logic hold = 0;
+  logic tile_write;
+  logic [18:0] tile_writedata;
+  logic sprite_write;
+  logic [4:0] sprite_register_number;
+  logic [26:0] sprite_writedata;
+  logic commit;
+
+  vga_dma dut(.*);
+
+  always #10 clk = ~clk; // 50 MHz
+
+  // 800x525 at two clocks a pixel, as vga_counters in vga_top.sv
+  always @(posedge clk)
+    if (hcount == 1599) begin
+      hcount <= 0;
+      vcount <= (vcount == 524) ? 10'd0 : vcount + 10'd1;
+    end else
+      hcount <= hcount + 11'd1;
+
+  int errors = 0;
+
+  task automatic fail(input string msg);
+    errors++;
+    $display("ERROR line %0d hcount %0d: %s", vcount, hcount, msg);
+  endtask
+
+  // frame in memory: tile k is k*7+3, sprite word n has every field set
+  logic [31:0] mem [0:WORDS-1];
+
+  function automatic logic [7:0] tile_byte(input int k);
+    return 8'(k * 7 + 3);
+  endfunction
+
+  initial begin
+    for (int w = 0; w < 300; w++)
+      mem[w] = {tile_byte(w*4+3), tile_byte(w*4+2), tile_byte(w*4+1), tile_byte(w*4)};
+    for (int n = 0; n < 32; n++)
+      mem[300+n] = {5'b10101, 1'b1, 1'b0, 1'b1, 9'(n*13), 10'(n*19+1), 5'(n)};
+  end
+
+  // Avalon slave: 0 to wait_max wait states, data latency cycles after the read is taken
+  int wait_max = 3;
+  int latency = 3;
+  int wait_left = 0;
+  int valid_in = 0;
+  int outstanding = 0;
+  int reads = 0;
+  int expect_word = 0;
+  int first_word = 0; // word the next transfer starts on
+  logic clear = 0;    // from the test sequence: start counting afresh
+  logic [31:0] taken_address;
+  logic held = 0; // a read was stalled last cycle
+  logic [31:0] held_address;
+
+  assign dma_waitrequest = dma_read && wait_left != 0;
+
+  always @(posedge clk) begin
+    dma_readdatavalid <= 0;
+    if (valid_in != 0) begin
+      valid_in <= valid_in - 1;
+      if (valid_in == 1) begin
+        dma_readdatavalid <= 1;
+        dma_readdata <= mem[(taken_address - BASE) >> 2];
+        outstanding <= outstanding - 1;
+      end
+    end
+
+    if (held && (!dma_read || dma_address != held_address))
+      fail("read dropped or changed address under waitrequest");
+    held <= dma_read && dma_waitrequest;
+    held_address <= dma_address;
+
+    if (clear) begin
+      reads <= 0;
+      expect_word <= first_word;
+    end else if (dma_read) begin
+      if (wait_left != 0)
+        wait_left <= wait_left - 1;
+      else begin
+        if (outstanding != 0 || valid_in != 0)
+          fail("second read issued before the first returned");
+        if (dma_address != BASE + expect_word * 4)
+          fail($sformatf("read of %h, expected word %0d", dma_address, expect_word));
+        taken_address <= dma_address;
+        valid_in <= latency;
+        outstanding <= outstanding + 1;
+        reads <= reads + 1;
+        expect_word <= expect_word + 1;
+        wait_left <= $urandom_range(wait_max, 0);
+      end
+    end
+  end
+
+  // software register writes take a cycle now and then
+  always @(posedge clk)
+    hold <= ($urandom % 4) == 0;
+
+  // check everything the DMA writes
+  int tiles = 0;
+  int sprites = 0;
+  int commits = 0;
+
+  always @(posedge clk) begin
+    if (clear) begin
+      tiles <= 0;
+      sprites <= 0;
+      commits <= 0;
+    end
+    if (tile_write) begin
+      if (tile_writedata[18:14] * 40 + tile_writedata[13:8] != tiles)
+        fail($sformatf("tile %0d written to row %0d column %0d", tiles,
+                       tile_writedata[18:14], tile_writedata[13:8]));
+      if (tile_writedata[7:0] != tile_byte(tiles))
+        fail($sformatf("tile %0d is %0d, expected %0d", tiles,
+                       tile_writedata[7:0], tile_byte(tiles)));
+      tiles <= tiles + 1;
+    end
+    if (sprite_write) begin
+      if (sprite_register_number != 5'(sprites))
+        fail($sformatf("sprite %0d written to register %0d", sprites, sprite_register_number));
+      if (sprite_writedata != mem[300 + sprite_register_number][26:0])
+        fail($sformatf("sprite %0d is %h", sprite_register_number, sprite_writedata));
+      sprites <= sprites + 1;
+    end
+    if (commit)
+      commits <= commits + 1;
+  end
+
+  // the testbench drives and samples on the falling edge
+  task automatic wait_for(input int line, input int h);
+    while (!(vcount == line && hcount == h))
+      @(negedge clk);
+  endtask
+
+  task automatic csr(input logic [5:0] a, input logic [31:0] d);
+    @(negedge clk);
+    address = a;
+    writedata = d;
+    csr_write = 1;
+    @(negedge clk);
+    csr_write = 0;
+    address = DMA_STATUS;
+  endtask
+
+  task automatic csr_read(input logic [5:0] a, output logic [31:0] d);
+    @(negedge clk);
+    address = a;
+    #1 d = csr_readdata;
+    address = DMA_STATUS;
+  endtask
+
+  // request parts (bit 0 tiles, bit 1 sprites) on line request, expect the
+  // transfer to start on line start and, unless overrun, end before line 524
+  task automatic transfer(input string name, input logic [1:0] parts,
+                          input int request, input int start, input bit overrun);
+    logic [31:0] d;
+    int done;
+
+    wait_for(request, 800);
+    first_word = parts[0] ? 0 : 300;
+    clear = 1;
+    @(negedge clk);
+    clear = 0;
+    csr(DMA_CTRL, {30'd0, parts});
+
+    while (!dma_read)
+      @(negedge clk);
+    if (vcount != start)
+      fail($sformatf("%s: started on line %0d, expected %0d", name, vcount, start));
+
+    while (csr_readdata[0]) // busy; address rests on DMA_STATUS
+      @(negedge clk);
+    done = vcount;
+    repeat (2) @(negedge clk); // the commit pulse follows DONE
+
+    if (!overrun && (done < 480 || done >= 524))
+      fail($sformatf("%s: finished on line %0d, outside vertical blank", name, done));
+    if (reads != (parts[0] ? 300 : 0) + (parts[1] ? 32 : 0))
+      fail($sformatf("%s: %0d reads", name, reads));
+    if (tiles != (parts[0] ? 1200 : 0))
+      fail($sformatf("%s: %0d tiles written", name, tiles));
+    if (sprites != (parts[1] ? 32 : 0))
+      fail($sformatf("%s: %0d sprites written", name, sprites));
+    if (commits != (parts[1] ? 1 : 0))
+      fail($sformatf("%s: %0d commit pulses", name, commits));
+
+    csr_read(DMA_STATUS, d);
+    if (d[1] != overrun)
+      fail($sformatf("%s: overrun flag %0d", name, d[1]));
+    csr_read(DMA_CYCLES, d);
+    $display("%s: lines %0d-%0d, %0d cycles, wait states 0-%0d, latency %0d",
+             name, start, done, d, wait_max, latency);
+  endtask
+
+  logic [31:0] r;
+
+  initial begin
+    repeat (4) @(negedge clk);
+    reset = 0;
+    csr(DMA_ADDR, BASE);
+    csr_read(DMA_ADDR, r);
+    if (r != BASE)
+      fail($sformatf("DMA_ADDR reads back %h", r));
+
+    // requested during the frame, starts with vertical blank
+    transfer("whole frame", 2'b11, 470, 480, 0);
+
+    // requested on the last line that may start, with a slower slave
+    wait_max = 7;
+    latency = 12;
+    transfer("latest start", 2'b11, 499, 499, 0);
+
+    // too late for this frame: waits for the next one
+    wait_max = 3;
+    latency = 3;
+    transfer("tiles after the window", 2'b01, 500, 480, 0);
+
+    transfer("sprites only", 2'b10, 490, 490, 0);
+
+    // about 256 cycles a word is more than vertical blank holds
+    wait_max = 0;
+    latency = 250;
+    transfer("slow slave", 2'b11, 470, 480, 1);
+    csr(DMA_STATUS, 32'd2);
+    csr_read(DMA_STATUS, r);
+    if (r[1])
+      fail("overrun flag did not clear");
+
+    if (errors == 0)
+      $display("PASS");
+    else
+      $display("FAIL: %0d errors", errors);
+    $finish;
+  end
+
+  initial begin
+    #(20 * 1600 * 525 * 8);
+    $fatal(1, "timeout");
+  end
+
+endmodule
@@ -35,7 +35,7 @@ module tile_loader(input logic clk,
                    input logic [18:0] writedata,
                    input logic [9:0] vcount,
                    output logic [5:0] address_tile_draw, // = column of a tile
-                   output logic [255:0] data_tile_draw,
+                   output logic [127:0] data_tile_draw, // palette indices, leftmost pixel in 7:0
                    output logic finish
                    // output logic wren_tile_draw, // should I add this?
 );
@@ -54,7 +54,7 @@ module tile_loader(input logic clk,
   // address of the beginning of that row = row * 40
   assign tile_array_address_read = (actual_vcount >> 4)*40 + col; 
 
-  tile_array(.address_a(tile_array_address_read), // port a for read
+  tile_array tiles(.address_a(tile_array_address_read), // port a for read
            .address_b(tile_array_address_write), // port b for write
            .clock(clk),
            .data_b(writedata[7:0]), 
@@ -66,7 +66,7 @@ module tile_loader(input logic clk,
   // tile_img_num * 16 + actual_vcount % 16
   assign tile_rom_address = (tile_img_num << 4) + actual_vcount[3:0]; // + has higher priority than << 
 
-  tile_rom(tile_rom_address, clk, data_tile_draw);
+  tile_rom rom(tile_rom_address, clk, data_tile_draw);
 
   always_ff @(posedge clk) begin
     if(reset) begin
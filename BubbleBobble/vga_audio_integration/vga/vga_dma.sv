@@ -0,0 +1,180 @@
+/*
+ * Display list DMA: at the start of vertical blank, fetch a frame
+ * (tilemap and sprite table) from HPS memory over an Avalon master and
+ * write it into the tile array and the sprite registers, so a full
+ * screen redraw costs the CPU a memcpy instead of 1200 bus writes.
+ *
+ * Frame layout in memory, little endian:
+ *   bytes 0-1199:    tile image numbers, 30 rows of 40, row major
+ *   bytes 1200-1327: 32 sprite words, same format as the sprite registers
+ *
+ * A transfer starts within the first 20 lines of vertical blank, which
+ * leaves at least 24 lines (38400 cycles) before line 0 is drawn. One read
+ * is outstanding at a time and a word takes 4 more cycles to unpack, so
+ * the 332 reads of a whole frame fit with a wide margin: tb_vga_dma.log
+ * measured 4154 cycles (lines 480-482) with 0-3 wait states and a read
+ * latency of 3, and 7724 (lines 499-504) with 0-7 and 12. DMA_CYCLES
+ * reports the actual time, DMA_STATUS flags a transfer still running too
+ * late.
+ */
+
+module vga_dma(input logic clk,
+               input logic reset,
+               input logic [10:0] hcount,
+               input logic [9:0] vcount,
+
+               // control registers
+               input logic csr_write,
+               input logic [5:0] address,
+               input logic [31:0] writedata,
+               output logic [31:0] csr_readdata,
+
+               // Avalon master, reads only
+               output logic [31:0] dma_address,
+               output logic dma_read,
+               input logic [31:0] dma_readdata,
+               input logic dma_waitrequest,
+               input logic dma_readdatavalid,
+
+               // software writes win, the transfer waits a cycle
+               input logic hold,
+               output logic tile_write,
+               output logic [18:0] tile_writedata, // row(5b), column(6b), tile image number(8b)
+               output logic sprite_write,
+               output logic [4:0] sprite_register_number, // 0-31
+               output logic [26:0] sprite_writedata,
+               output logic commit // one cycle pulse after the sprites are written
+);
+
+  localparam DMA_ADDR   = 6'd53; // r/w: bus address of the frame, 4 byte aligned
+  localparam DMA_CTRL   = 6'd54; // w: bit 0 fetch tiles, bit 1 fetch sprites at the next vblank (0 cancels), r: still pending
+  localparam DMA_STATUS = 6'd55; // r: bit 0 busy, bit 1 overrun; w: 1 to bit 1 clears overrun
+  localparam DMA_CYCLES = 6'd56; // r: clock cycles the last transfer took
+
+  localparam TILE_WORDS = 9'd300; // 1200 bytes
+  localparam LAST_WORD  = 9'd331; // 32 sprite words follow the tiles
+
+  localparam START_LINE = 10'd480; // first line of vertical blank
+  localparam LAST_START = 10'd499; // later than this, wait for the next frame
+
+  typedef enum logic [2:0] {IDLE, READ, WAIT, TILES, SPRITE, NEXT, DONE} state_t;
+  state_t state;
+
+  logic [31:0] base;
+  logic [1:0] pending; // parts to fetch at the next chance: bit 0 tiles, bit 1 sprites
+  logic fetch_sprites; // this transfer includes the sprite table
+  logic overrun;
+  logic [31:0] cycles;
+  logic [31:0] last_cycles;
+
+  logic [8:0] word; // word of the frame being fetched
+  logic [31:0] data;
+  logic [1:0] byte_num; // byte of data being written as a tile
+  logic [4:0] row;
+  logic [5:0] col;
+
+  assign dma_address = base + (word << 2);
+  assign dma_read = (state == READ);
+
+  assign tile_write = (state == TILES) && !hold;
+  assign tile_writedata = {row, col, data[byte_num*8 +: 8]};
+
+  assign sprite_write = (state == SPRITE) && !hold;
+  assign sprite_register_number = word - TILE_WORDS;
+  assign sprite_writedata = data[26:0];
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      state <= IDLE;
+      base <= 0;
+      pending <= 0;
+      fetch_sprites <= 0;
+      overrun <= 0;
+      cycles <= 0;
+      last_cycles <= 0;
+      commit <= 0;
+    end else begin
+      commit <= 0;
+
+      if (csr_write && address == DMA_ADDR)
+        base <= {writedata[31:2], 2'b00};
+      if (csr_write && address == DMA_STATUS && writedata[1])
+        overrun <= 0;
+
+      // still fetching when line 0 is about to be drawn
+      if (state != IDLE && hcount == 0 && vcount == 524)
+        overrun <= 1;
+
+      if (state != IDLE)
+        cycles <= cycles + 1;
+
+      case (state)
+        IDLE: begin
+          if (pending != 0 && vcount >= START_LINE && vcount <= LAST_START) begin
+            fetch_sprites <= pending[1];
+            word <= pending[0] ? 9'd0 : TILE_WORDS;
+            row <= 0;
+            col <= 0;
+            cycles <= 0;
+            pending <= 0;
+            state <= READ;
+          end
+        end
+        READ: begin
+          if (!dma_waitrequest)
+            state <= WAIT;
+        end
+        WAIT: begin
+          if (dma_readdatavalid) begin
+            data <= dma_readdata;
+            byte_num <= 0;
+            state <= (word < TILE_WORDS) ? TILES : SPRITE;
+          end
+        end
+        TILES: begin
+          if (!hold) begin
+            byte_num <= byte_num + 1;
+            if (col == 39) begin
+              col <= 0;
+              row <= row + 1;
+            end else
+              col <= col + 1;
+            if (byte_num == 3)
+              state <= NEXT;
+          end
+        end
+        SPRITE: begin
+          if (!hold)
+            state <= NEXT;
+        end
+        NEXT: begin
+          word <= word + 1;
+          if ((word == TILE_WORDS - 1 && !fetch_sprites) || word == LAST_WORD)
+            state <= DONE;
+          else
+            state <= READ;
+        end
+        DONE: begin
+          commit <= fetch_sprites; // latched sprites show up this frame too
+          last_cycles <= cycles;
+          state <= IDLE;
+        end
+      endcase
+
+      // after the start check, so a write in the same cycle is kept for next time
+      if (csr_write && address == DMA_CTRL)
+        pending <= writedata[1:0];
+    end
+  end
+
+  always_comb begin
+    case (address)
+      DMA_ADDR:   csr_readdata = base;
+      DMA_CTRL:   csr_readdata = {30'd0, pending};
+      DMA_STATUS: csr_readdata = {30'd0, overrun, state != IDLE};
+      DMA_CYCLES: csr_readdata = last_cycles;
+      default:    csr_readdata = 32'd0;
+    endcase
+  end
+
+endmodule
@@ -9,8 +9,19 @@ module vga_top(input logic        clk,
 	        input logic 	   reset,
 		input logic [31:0]  writedata,
 		input logic 	   write,
+		input logic 	   read,
 		input 		   chipselect,
-		input logic [3:0]  address,
+		input logic [5:0]  address,
+
+		output logic [31:0] readdata,
+		output logic 	   irq,
+
+		// display list DMA master, reads HPS memory
+		output logic [31:0] dma_address,
+		output logic 	   dma_read,
+		input logic [31:0]  dma_readdata,
+		input logic 	   dma_waitrequest,
+		input logic 	   dma_readdatavalid,
 
 		output logic [7:0] VGA_R, VGA_G, VGA_B,
 		output logic 	   VGA_CLK, VGA_HS, VGA_VS,
@@ -21,47 +32,92 @@ module vga_top(input logic        clk,
    logic [9:0]     vcount;
 	
    vga_counters counters(.clk50(clk), .*);
+
+    // register map (word addresses)
+    // 0: tile, 1-32: sprites, 48 and up: control, 53-56: DMA (vga_dma.sv), 57: palette
+    localparam VBLANK_CTRL   = 6'd48; // w: bit 0 enables the vblank interrupt
+    localparam VBLANK_STATUS = 6'd49; // r: bit 0 interrupt pending, w: 1 to clear
+    localparam FRAME_COUNT   = 6'd50; // r: frames since reset
+    localparam SPRITE_CTRL   = 6'd51; // w: bit 0 latches sprite writes until a commit
+    localparam SPRITE_COMMIT = 6'd52; // w: copy the latched sprites to the screen at the next vblank, at once if in vblank
+    localparam PALETTE       = 6'd57; // w: bits 23:16 entry, 15:0 its colour (red 15:11, green 10:6, blue 5:1)
     
     // line buffer
     logic	[5:0]  address_tile_display;
-	  logic	[9:0]  address_pixel_display;
+	  logic	[7:0]  address_pixel_display; // 4 pixels per word
 	  logic	[5:0]  address_tile_draw;
-	  logic	[9:0]  address_pixel_draw;
+	  logic	[7:0]  address_pixel_draw;
 
-	  logic	[255:0]  data_tile_display;
-    logic	[15:0]  data_pixel_display;
-    logic	[255:0]  data_tile_draw;
-    logic	[15:0]  data_pixel_draw;
+	  logic	[127:0]  data_tile_display; // 8-bit palette indices
+    logic	[31:0]  data_pixel_display;
+    logic	[127:0]  data_tile_draw;
+    logic	[31:0]  data_pixel_draw;
 	  
     
 	  logic	  wren_tile_display;
 	  logic	  wren_pixel_display;
     logic	  wren_tile_draw;
 	  logic	  wren_pixel_draw;
+    logic	[3:0]  byteena_pixel_display;
+    logic	[3:0]  byteena_pixel_draw;
 
-	  logic	[255:0]  q_tile_display;
-    logic	[15:0]  q_pixel_display;
-    logic	[255:0]  q_tile_draw;
-    logic	[15:0]  q_pixel_draw;
+	  logic	[127:0]  q_tile_display;
+    logic	[31:0]  q_pixel_display;
+    logic	[127:0]  q_tile_draw;
+    logic	[31:0]  q_pixel_draw;
 
     logic switch;
 
     linebuffer(.*);
     
+    // display list DMA: fetches a whole frame from memory at vblank
+    logic dma_tile_write;
+    logic [18:0] dma_tile_writedata;
+    logic dma_sprite_write;
+    logic [4:0] dma_sprite_register_number;
+    logic [26:0] dma_sprite_writedata;
+    logic dma_commit;
+    logic [31:0] dma_csr_readdata;
+    vga_dma dma(.clk(clk), .reset(reset), .hcount(hcount), .vcount(vcount),
+                .csr_write(chipselect && write), .address(address), .writedata(writedata),
+                .csr_readdata(dma_csr_readdata),
+                .dma_address(dma_address), .dma_read(dma_read), .dma_readdata(dma_readdata),
+                .dma_waitrequest(dma_waitrequest), .dma_readdatavalid(dma_readdatavalid),
+                .hold(chipselect && write && (address <= 32)),
+                .tile_write(dma_tile_write), .tile_writedata(dma_tile_writedata),
+                .sprite_write(dma_sprite_write), .sprite_register_number(dma_sprite_register_number),
+                .sprite_writedata(dma_sprite_writedata), .commit(dma_commit));
+
     // tile loader
     logic tile_start;
     logic tile_finish;
     logic tile_write;
-    assign tile_write = (chipselect && write && (address == 0)); // address = 0: write tile
+    logic mmio_tile_write;
+    logic [18:0] tile_writedata;
+    assign mmio_tile_write = (chipselect && write && (address == 0)); // address = 0: write tile
     // low 19 bit of writedata: row(5b), column(6b), tile image number(8b)
-    tile_loader(clk, reset, tile_start, tile_write, writedata[18:0], vcount, address_tile_draw, data_tile_draw, tile_finish);
+    // the DMA uses the same format and waits while software writes
+    assign tile_write = mmio_tile_write || dma_tile_write;
+    assign tile_writedata = mmio_tile_write ? writedata[18:0] : dma_tile_writedata;
+    tile_loader(clk, reset, tile_start, tile_write, tile_writedata, vcount, address_tile_draw, data_tile_draw, tile_finish);
 
     // sprite loader
     logic sprite_start;
     logic sprite_finish;
     logic sprite_write;
-    assign sprite_write = (chipselect && write && (address >= 1)); // address >= 1: write sprite
-    sprite_loader(clk, reset, sprite_start, sprite_write, address, writedata[24:0], vcount, address_pixel_draw, data_pixel_draw, sprite_finish, wren_pixel_draw);
+    logic mmio_sprite_write;
+    logic [4:0] sprite_register_number; // 0-31
+    logic [26:0] sprite_writedata;
+    assign mmio_sprite_write = (chipselect && write && (address >= 1) && (address <= 32)); // address 1-32: write sprite
+    assign sprite_write = mmio_sprite_write || dma_sprite_write;
+    assign sprite_register_number = mmio_sprite_write ? address[4:0] - 5'd1 : dma_sprite_register_number;
+    assign sprite_writedata = mmio_sprite_write ? writedata[26:0] : dma_sprite_writedata;
+    // sprite commit: in latch mode sprite writes only reach the shadow bank,
+    // a commit copies the whole bank at the start of the next vblank
+    logic sprite_latch;
+    logic commit_pending;
+    logic sprite_commit;
+    sprite_loader(clk, reset, sprite_start, sprite_write, sprite_register_number, sprite_writedata, vcount, address_pixel_draw, data_pixel_draw, byteena_pixel_draw, sprite_finish, wren_pixel_draw, sprite_latch, sprite_commit || dma_commit);
     //logic [4:0] row_in_sprite;
     //assign row_in_sprite = (vcount+1)%525%32;
     //sprite_draw(clk, reset, sprite_start, row_in_sprite, 10'd16, 5'd0, wren_pixel_draw, address_pixel_draw, data_pixel_draw, sprite_finish);
@@ -108,23 +164,92 @@ module vga_top(input logic        clk,
     end
 
 
+   // vblank interrupt: raised once per frame when vcount reaches 480,
+   // held until the driver clears it
+   logic irq_enable;
+   logic [31:0] frame_count;
+
+   always_ff @(posedge clk) begin
+      if (reset) begin
+        irq <= 0;
+        irq_enable <= 0;
+        frame_count <= 0;
+        sprite_latch <= 0;
+        commit_pending <= 0;
+        sprite_commit <= 0;
+      end else begin
+        sprite_commit <= 0;
+        if (chipselect && write && address == SPRITE_CTRL)
+          sprite_latch <= writedata[0];
+        // during vertical blank nothing reads the sprites, so a commit
+        // (e.g. from the driver's per-frame flush) can apply at once
+        if (chipselect && write && address == SPRITE_COMMIT) begin
+          if (vcount >= 480 && vcount <= 523)
+            sprite_commit <= 1;
+          else
+            commit_pending <= 1;
+        end
+        if (chipselect && write && address == VBLANK_CTRL)
+          irq_enable <= writedata[0];
+        if (chipselect && write && address == VBLANK_STATUS && writedata[0])
+          irq <= 0;
+        // a new vblank wins over a clear in the same cycle
+        if (hcount == 0 && vcount == 480) begin
+          frame_count <= frame_count + 1;
+          if (irq_enable)
+            irq <= 1;
+          // commits written before vblank apply now
+          if (commit_pending) begin
+            sprite_commit <= 1;
+            commit_pending <= 0;
+          end
+        end
+      end
+   end
+
+   always_comb begin
+      case (address)
+        VBLANK_STATUS: readdata = {30'd0, commit_pending, irq}; // bit 1: commit not applied yet
+        FRAME_COUNT:   readdata = frame_count;
+        default:       readdata = dma_csr_readdata; // DMA registers, 0 elsewhere
+      endcase
+   end
+
    // output
+   logic [9:0] display_pixel;
+   logic [1:0] display_pick; // pixel of the word q_pixel_display holds
+   logic [7:0] pixel_index;
+   logic [15:0] pixel;
+
+   always_ff @(posedge clk)
+      display_pick <= display_pixel[1:0];
+
+   // the line buffer holds palette indices, looked up here a cycle after
+   // the line buffer read; a pixel lasts two cycles and is sampled at the
+   // end of its first, so the lookup fits within the pixel and only the
+   // buffer switch moves a cycle earlier. A write shows from the next
+   // pixel, so software changes the palette during vblank.
+   palette_ram palette(.clock(clk), .data(writedata[15:0]), .rdaddress(pixel_index),
+                       .wraddress(writedata[23:16]), .wren(chipselect && write && address == PALETTE), .q(pixel));
+
    always_comb begin 
       if (hcount[10:1] < 639) 
-        address_pixel_display = hcount[10:1] + 1; // account for memory delay
+        display_pixel = hcount[10:1] + 1; // account for memory delay
       else
-        address_pixel_display = 0; 
+        display_pixel = 0; 
+      address_pixel_display = display_pixel[9:2];
+      pixel_index = q_pixel_display[display_pick*8 +: 8];
       
-      if(hcount == 1598 && (vcount < 479 || vcount == 524)) // 2 cycles early: 1 cycle for switch, another for reading memory
+      if(hcount == 1597 && (vcount < 479 || vcount == 524)) // 3 cycles early: 1 cycle for switch, one for reading memory, one for the palette
         switch = 1;
       else
         switch = 0;
       
 	    //{VGA_R, VGA_G, VGA_B} = {q_pixel_display[15:11]<<3, q_pixel_display[10:6]<<3, q_pixel_display[4:0]<<3};
       // why the one-line assignment does not work?
-      VGA_R = q_pixel_display[15:11] << 3;
-      VGA_G = q_pixel_display[10:6] << 3;
-      VGA_B = q_pixel_display[5:1] << 3;
+      VGA_R = pixel[15:11] << 3;
+      VGA_G = pixel[10:6] << 3;
+      VGA_B = pixel[5:1] << 3;
    end
 	       
 endmodule
@@ -49,8 +49,13 @@ add_fileset_file sprite_loader.sv SYSTEM_VERILOG PATH sprite_loader.sv
 add_fileset_file sprite_draw.sv SYSTEM_VERILOG PATH sprite_draw.sv
 add_fileset_file sprite_active.sv SYSTEM_VERILOG PATH sprite_active.sv
 add_fileset_file sprite_rom.v VERILOG PATH sprite_rom.v
+add_fileset_file sprite_span_rom.v VERILOG PATH sprite_span_rom.v
+add_fileset_file palette_ram.v VERILOG PATH palette_ram.v
+add_fileset_file vga_dma.sv SYSTEM_VERILOG PATH vga_dma.sv
 add_fileset_file combined_sprite.mif MIF PATH combined_sprite.mif
+add_fileset_file sprite_spans.mif MIF PATH sprite_spans.mif
 add_fileset_file combined_tile.mif MIF PATH combined_tile.mif
+add_fileset_file palette.mif MIF PATH palette.mif
 
 
 # 
@@ -128,14 +133,68 @@ set_interface_property avalon_slave_0 SVD_ADDRESS_GROUP ""
 
 add_interface_port avalon_slave_0 writedata writedata Input 32
 add_interface_port avalon_slave_0 write write Input 1
+add_interface_port avalon_slave_0 read read Input 1
+add_interface_port avalon_slave_0 readdata readdata Output 32
 add_interface_port avalon_slave_0 chipselect chipselect Input 1
-add_interface_port avalon_slave_0 address address Input 4
+add_interface_port avalon_slave_0 address address Input 6
 set_interface_assignment avalon_slave_0 embeddedsw.configuration.isFlash 0
 set_interface_assignment avalon_slave_0 embeddedsw.configuration.isMemoryDevice 0
 set_interface_assignment avalon_slave_0 embeddedsw.configuration.isNonVolatileStorage 0
 set_interface_assignment avalon_slave_0 embeddedsw.configuration.isPrintableDevice 0
 
 
+# 
+# connection point interrupt_sender
+# 
+add_interface interrupt_sender interrupt end
+set_interface_property interrupt_sender associatedAddressablePoint avalon_slave_0
+set_interface_property interrupt_sender associatedClock clock
+set_interface_property interrupt_sender associatedReset reset
+set_interface_property interrupt_sender bridgedReceiverOffset ""
+set_interface_property interrupt_sender bridgesToReceiver ""
+set_interface_property interrupt_sender ENABLED true
+set_interface_property interrupt_sender EXPORT_OF ""
+set_interface_property interrupt_sender PORT_NAME_MAP ""
+set_interface_property interrupt_sender CMSIS_SVD_VARIABLES ""
+set_interface_property interrupt_sender SVD_ADDRESS_GROUP ""
+
+add_interface_port interrupt_sender irq irq Output 1
+
+
+# 
+# connection point dma
+# 
+add_interface dma avalon start
+set_interface_property dma addressUnits SYMBOLS
+set_interface_property dma associatedClock clock
+set_interface_property dma associatedReset reset
+set_interface_property dma bitsPerSymbol 8
+set_interface_property dma burstOnBurstBoundariesOnly false
+set_interface_property dma burstcountUnits WORDS
+set_interface_property dma doStreamReads false
+set_interface_property dma doStreamWrites false
+set_interface_property dma holdTime 0
+set_interface_property dma linewrapBursts false
+set_interface_property dma maximumPendingReadTransactions 0
+set_interface_property dma maximumPendingWriteTransactions 0
+set_interface_property dma readLatency 0
+set_interface_property dma readWaitTime 1
+set_interface_property dma setupTime 0
+set_interface_property dma timingUnits Cycles
+set_interface_property dma writeWaitTime 0
+set_interface_property dma ENABLED true
+set_interface_property dma EXPORT_OF ""
+set_interface_property dma PORT_NAME_MAP ""
+set_interface_property dma CMSIS_SVD_VARIABLES ""
+set_interface_property dma SVD_ADDRESS_GROUP ""
+
+add_interface_port dma dma_address address Output 32
+add_interface_port dma dma_read read Output 1
+add_interface_port dma dma_readdata readdata Input 32
+add_interface_port dma dma_waitrequest waitrequest Input 1
+add_interface_port dma dma_readdatavalid readdatavalid Input 1
+
+
 # 
 # connection point vga
 # 
@@ -0,0 +1,212 @@
+// mic_env: how loud the player is screaming, for ScreamJump
+//
+// Takes the microphone samples the audio core reads from the codec's ADC
+// (8 kHz; the mic is mono, so the right channel is drained and dropped)
+// and keeps two envelopes of them:
+//   peak  |x|, following a rise at once and falling by 1/2^n each sample
+//   rms   square root of an average of x^2 over about 2^n samples
+// The loud flag turns on when the chosen envelope reaches the on
+// threshold and off when it falls under the off threshold. Turning on
+// sets the sticky onset bit, which raises irq, and notes the sample count,
+// two clocks after the sample came in (17 on rms, which waits for the
+// square root); nothing waits for the CPU. The envelope is still rising
+// then, so how hard the scream was comes after a hold of HOLD samples,
+// or sooner if loud turns off: STRENGTH takes the loudest envelope since
+// the onset and the sticky strength bit raises irq again, as many clocks
+// after that sample. tb_mic_env.sv checks all of it.
+
+module mic_env(input logic        clk,
+	       input logic 	   reset,
+
+    // adc channels of the intel audio ip module
+	       input logic [15:0] left_data,
+	       input logic 	   left_valid,
+	       output logic 	   left_ready,
+	       input logic [15:0] right_data,
+	       input logic 	   right_valid,
+	       output logic 	   right_ready,
+
+    // avalon slave
+	       input logic [31:0] writedata,
+	       input logic 	   write,
+	       input logic 	   read,
+	       input 		   chipselect,
+	       input logic [3:0]  address,
+	       output logic [31:0] readdata,
+	       output logic 	   irq);
+
+  // register map (word addresses)
+  localparam CTRL     = 4'd0; // r/w: bit 0 takes samples, bit 1 enables the onset irq, bit 2 detects on rms instead of peak
+  localparam STATUS   = 4'd1; // r: bit 0 loud, bit 1 onset, bit 2 strength since last cleared; w: 1 in bit 1 or 2 clears it
+  localparam PEAK     = 4'd2; // r: peak envelope, 0-32767
+  localparam RMS      = 4'd3; // r: rms envelope, 0-32767
+  localparam THRESH   = 4'd4; // r/w: bits 15:0 on level (0 never turns on), bits 31:16 off level
+  localparam DECAY    = 4'd5; // r/w: bits 3:0 peak fall, bits 11:8 rms average, both as n in 2^n samples
+  localparam LOUDEST  = 4'd6; // r: loudest envelope since the last onset, how hard the scream was
+  localparam SAMPLES  = 4'd7; // r: samples taken, counting at 8 kHz
+  localparam ONSET_AT = 4'd8; // r: SAMPLES when loud last turned on
+  localparam HOLD     = 4'd9; // r/w: bits 15:0 envelope samples after an onset STRENGTH is taken over, 0 at the onset
+  localparam STRENGTH = 4'd10; // r: loudest envelope from the last onset to the end of its hold
+
+  logic [2:0] ctrl;
+  logic loud;
+  logic onset;
+  logic strong; // the strength of the last onset is in
+  logic [15:0] thresh_on;
+  logic [15:0] thresh_off;
+  logic [3:0] peak_shift;
+  logic [3:0] rms_shift;
+  logic [15:0] peak;
+  logic [15:0] rms;
+  logic [15:0] loudest;
+  logic [31:0] samples;
+  logic [31:0] onset_at;
+  logic [31:0] mean_square;
+  logic [15:0] hold;
+  logic [15:0] held; // envelope samples since the onset
+  logic holding;
+  logic [15:0] strength;
+
+  assign left_ready = ctrl[0];
+  assign right_ready = ctrl[0];
+  assign irq = ctrl[1] && (onset || strong);
+
+  logic take;
+  assign take = left_valid && left_ready;
+
+  // |x|, -32768 taken as 32767
+  logic [15:0] mag;
+  assign mag = !left_data[15] ? left_data : left_data == 16'h8000 ? 16'h7fff : -left_data;
+
+  // the peak falls by at least 1 so it gets back to 0
+  logic [15:0] peak_fall;
+  assign peak_fall = (peak >> peak_shift) == 0 && peak != 0 ? 16'd1 : peak >> peak_shift;
+
+  logic [31:0] square;
+  assign square = mag * mag;
+
+  // square root of mean_square, a bit a clock after each sample
+  logic [3:0] sqrt_bit;
+  logic sqrt_busy;
+  logic [14:0] root;
+  logic [14:0] trial;
+  assign trial = root | (15'd1 << sqrt_bit);
+
+  logic [15:0] level;
+  assign level = ctrl[2] ? rms : peak;
+
+  // level has just taken the next sample
+  logic level_new;
+
+  always_ff @(posedge clk) begin
+    if (reset) begin
+      ctrl <= 0;
+      loud <= 0;
+      onset <= 0;
+      strong <= 0;
+      thresh_on <= 16'd8000;
+      thresh_off <= 16'd4000;
+      peak_shift <= 4'd6;  // 8 ms
+      rms_shift <= 4'd7;   // 16 ms
+      peak <= 0;
+      rms <= 0;
+      loudest <= 0;
+      samples <= 0;
+      onset_at <= 0;
+      mean_square <= 0;
+      sqrt_bit <= 0;
+      sqrt_busy <= 0;
+      root <= 0;
+      level_new <= 0;
+      hold <= 16'd160;     // 20 ms
+      held <= 0;
+      holding <= 0;
+      strength <= 0;
+    end else begin
+      level_new <= ctrl[2] ? sqrt_busy && sqrt_bit == 0 : take;
+
+      if (take) begin
+        samples <= samples + 1;
+        peak <= mag > peak ? mag : peak - peak_fall;
+        mean_square <= mean_square + (square >> rms_shift) - (mean_square >> rms_shift);
+        sqrt_bit <= 4'd14;
+        sqrt_busy <= 1;
+        root <= 0;
+      end else if (sqrt_busy) begin
+        if ({17'd0, trial} * {17'd0, trial} <= mean_square)
+          root <= trial;
+        if (sqrt_bit == 0) begin
+          sqrt_busy <= 0;
+          rms <= {1'b0, {17'd0, trial} * {17'd0, trial} <= mean_square ? trial : root};
+        end
+        sqrt_bit <= sqrt_bit - 1'd1;
+      end
+
+      if (chipselect && write) begin
+        case (address)
+          CTRL:   ctrl <= writedata[2:0];
+          STATUS: begin
+            onset <= onset & ~writedata[1];
+            strong <= strong & ~writedata[2];
+          end
+          THRESH: begin
+            thresh_on <= writedata[15:0];
+            thresh_off <= writedata[31:16];
+          end
+          DECAY: begin
+            peak_shift <= writedata[3:0];
+            rms_shift <= writedata[11:8];
+          end
+          HOLD:   hold <= writedata[15:0];
+        endcase
+      end
+
+      // a new onset wins over software clearing the last one
+      if (!loud && level >= thresh_on && thresh_on != 0) begin
+        loud <= 1;
+        onset <= 1;
+        onset_at <= samples;
+        loudest <= level;
+        held <= 0;
+        holding <= hold != 0;
+        if (hold == 0) begin
+          strong <= 1;
+          strength <= level;
+        end
+      end else if (loud) begin
+        if (level < thresh_off)
+          loud <= 0;
+        if (level > loudest)
+          loudest <= level;
+      end
+
+      // the hold ends after hold more samples, or on the one loud turns off on
+      if (holding && level_new) begin
+        held <= held + 1'd1;
+        if (held + 1'd1 >= hold || level < thresh_off) begin
+          holding <= 0;
+          strong <= 1;
+          strength <= level > loudest ? level : loudest;
+        end
+      end
+    end
+  end
+
+  always_comb begin
+    case (address)
+      CTRL:     readdata = {29'd0, ctrl};
+      STATUS:   readdata = {29'd0, strong, onset, loud};
+      PEAK:     readdata = {16'd0, peak};
+      RMS:      readdata = {16'd0, rms};
+      THRESH:   readdata = {thresh_off, thresh_on};
+      DECAY:    readdata = {20'd0, rms_shift, 4'd0, peak_shift};
+      LOUDEST:  readdata = {16'd0, loudest};
+      SAMPLES:  readdata = samples;
+      ONSET_AT: readdata = onset_at;
+      HOLD:     readdata = {16'd0, hold};
+      STRENGTH: readdata = {16'd0, strength};
+      default:  readdata = 32'd0;
+    endcase
+  end
+
+endmodule
@@ -0,0 +1,190 @@
+# TCL File Generated by Component Editor 21.1
+# Thu May 09 22:58:20 EDT 2024
+# DO NOT MODIFY
+
+
+# 
+# mic_env "mic_env" v1.0
+#  2024.05.09.22:58:20
+# 
+# 
+
+# 
+# request TCL package from ACDS 16.1
+# 
+package require -exact qsys 16.1
+
+
+# 
+# module mic_env
+# 
+set_module_property DESCRIPTION ""
+set_module_property NAME mic_env
+set_module_property VERSION 1.0
+set_module_property INTERNAL false
+set_module_property OPAQUE_ADDRESS_MAP true
+set_module_property AUTHOR ""
+set_module_property DISPLAY_NAME mic_env
+set_module_property INSTANTIATE_IN_SYSTEM_MODULE true
+set_module_property EDITABLE true
+set_module_property REPORT_TO_TALKBACK false
+set_module_property ALLOW_GREYBOX_GENERATION false
+set_module_property REPORT_HIERARCHY false
+
+
+# 
+# file sets
+# 
+add_fileset QUARTUS_SYNTH QUARTUS_SYNTH "" ""
+set_fileset_property QUARTUS_SYNTH TOP_LEVEL mic_env
+set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
+set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
+add_fileset_file mic_env.sv SYSTEM_VERILOG PATH mic_env.sv TOP_LEVEL_FILE
+
+
+# 
+# parameters
+# 
+
+
+# 
+# module assignments
+# 
+set_module_assignment embeddedsw.dts.group mic
+set_module_assignment embeddedsw.dts.name mic_env
+set_module_assignment embeddedsw.dts.vendor csee4840
+
+
+# 
+# display items
+# 
+
+
+# 
+# connection point clock
+# 
+add_interface clock clock end
+set_interface_property clock clockRate 0
+set_interface_property clock ENABLED true
+set_interface_property clock EXPORT_OF ""
+set_interface_property clock PORT_NAME_MAP ""
+set_interface_property clock CMSIS_SVD_VARIABLES ""
+set_interface_property clock SVD_ADDRESS_GROUP ""
+
+add_interface_port clock clk clk Input 1
+
+
+# 
+# connection point reset
+# 
+add_interface reset reset end
+set_interface_property reset associatedClock clock
+set_interface_property reset synchronousEdges DEASSERT
+set_interface_property reset ENABLED true
+set_interface_property reset EXPORT_OF ""
+set_interface_property reset PORT_NAME_MAP ""
+set_interface_property reset CMSIS_SVD_VARIABLES ""
+set_interface_property reset SVD_ADDRESS_GROUP ""
+
+add_interface_port reset reset reset Input 1
+
+
+# 
+# connection point audio_in_l
+# 
+add_interface audio_in_l avalon_streaming end
+set_interface_property audio_in_l associatedClock clock
+set_interface_property audio_in_l associatedReset reset
+set_interface_property audio_in_l dataBitsPerSymbol 8
+set_interface_property audio_in_l errorDescriptor ""
+set_interface_property audio_in_l firstSymbolInHighOrderBits true
+set_interface_property audio_in_l maxChannel 0
+set_interface_property audio_in_l readyLatency 0
+set_interface_property audio_in_l ENABLED true
+set_interface_property audio_in_l EXPORT_OF ""
+set_interface_property audio_in_l PORT_NAME_MAP ""
+set_interface_property audio_in_l CMSIS_SVD_VARIABLES ""
+set_interface_property audio_in_l SVD_ADDRESS_GROUP ""
+
+add_interface_port audio_in_l left_data data Input 16
+add_interface_port audio_in_l left_valid valid Input 1
+add_interface_port audio_in_l left_ready ready Output 1
+
+
+# 
+# connection point audio_in_r
+# 
+add_interface audio_in_r avalon_streaming end
+set_interface_property audio_in_r associatedClock clock
+set_interface_property audio_in_r associatedReset reset
+set_interface_property audio_in_r dataBitsPerSymbol 8
+set_interface_property audio_in_r errorDescriptor ""
+set_interface_property audio_in_r firstSymbolInHighOrderBits true
+set_interface_property audio_in_r maxChannel 0
+set_interface_property audio_in_r readyLatency 0
+set_interface_property audio_in_r ENABLED true
+set_interface_property audio_in_r EXPORT_OF ""
+set_interface_property audio_in_r PORT_NAME_MAP ""
+set_interface_property audio_in_r CMSIS_SVD_VARIABLES ""
+set_interface_property audio_in_r SVD_ADDRESS_GROUP ""
+
+add_interface_port audio_in_r right_data data Input 16
+add_interface_port audio_in_r right_valid valid Input 1
+add_interface_port audio_in_r right_ready ready Output 1
+
+
+# 
+# connection point avalon_slave
+# 
+add_interface avalon_slave avalon end
+set_interface_property avalon_slave addressUnits WORDS
+set_interface_property avalon_slave associatedClock clock
+set_interface_property avalon_slave associatedReset reset
+set_interface_property avalon_slave bitsPerSymbol 8
+set_interface_property avalon_slave burstOnBurstBoundariesOnly false
+set_interface_property avalon_slave burstcountUnits WORDS
+set_interface_property avalon_slave explicitAddressSpan 0
+set_interface_property avalon_slave holdTime 0
+set_interface_property avalon_slave linewrapBursts false
+set_interface_property avalon_slave maximumPendingReadTransactions 0
+set_interface_property avalon_slave maximumPendingWriteTransactions 0
+set_interface_property avalon_slave readLatency 0
+set_interface_property avalon_slave readWaitTime 1
+set_interface_property avalon_slave setupTime 0
+set_interface_property avalon_slave timingUnits Cycles
+set_interface_property avalon_slave writeWaitTime 0
+set_interface_property avalon_slave ENABLED true
+set_interface_property avalon_slave EXPORT_OF ""
+set_interface_property avalon_slave PORT_NAME_MAP ""
+set_interface_property avalon_slave CMSIS_SVD_VARIABLES ""
+set_interface_property avalon_slave SVD_ADDRESS_GROUP ""
+
+add_interface_port avalon_slave address address Input 4
+add_interface_port avalon_slave chipselect chipselect Input 1
+add_interface_port avalon_slave write write Input 1
+add_interface_port avalon_slave writedata writedata Input 32
+add_interface_port avalon_slave read read Input 1
+add_interface_port avalon_slave readdata readdata Output 32
+set_interface_assignment avalon_slave embeddedsw.configuration.isFlash 0
+set_interface_assignment avalon_slave embeddedsw.configuration.isMemoryDevice 0
+set_interface_assignment avalon_slave embeddedsw.configuration.isNonVolatileStorage 0
+set_interface_assignment avalon_slave embeddedsw.configuration.isPrintableDevice 0
+
+
+# 
+# connection point interrupt_sender
+# 
+add_interface interrupt_sender interrupt end
+set_interface_property interrupt_sender associatedAddressablePoint avalon_slave
+set_interface_property interrupt_sender associatedClock clock
+set_interface_property interrupt_sender associatedReset reset
+set_interface_property interrupt_sender bridgedReceiverOffset ""
+set_interface_property interrupt_sender bridgesToReceiver ""
+set_interface_property interrupt_sender ENABLED true
+set_interface_property interrupt_sender EXPORT_OF ""
+set_interface_property interrupt_sender PORT_NAME_MAP ""
+set_interface_property interrupt_sender CMSIS_SVD_VARIABLES ""
+set_interface_property interrupt_sender SVD_ADDRESS_GROUP ""
+
+add_interface_port interrupt_sender irq irq Output 1
+
@@ -0,0 +1,357 @@
+// Testbench for mic_env: plays a recording into the left ADC channel and
+// checks when irq rises against a model of the envelopes in this file.
+//
+//   verilator --binary --timing -Wno-fatal --top-module tb_mic_env tb_mic_env.sv mic_env.sv
+//   ./obj_dir/Vtb_mic_env +wav=scream.wav +onset=2000
+// or
+//   vlog -sv mic_env.sv tb_mic_env.sv && vsim -c tb_mic_env +wav=scream.wav -do "run -all"
+//
+// The .wav is 16-bit PCM at 8 kHz; with more than one channel the first is
+// used. +onset is the sample the scream starts on, if known: the first onset
+// must then come within 16 ms of it. Without +wav a made-up scream is used:
+// quiet hiss with a 440 Hz tone at about 2/3 full scale from sample 2000.
+//
+// The recording is played once detecting on the peak envelope and once on
+// rms. Each onset must match the model's sample and ONSET_AT must agree;
+// its strength must come on the sample the model's hold ends on, with the
+// model's loudest envelope over the hold, and LOUDEST must agree at the
+// end. irq must rise 2 clocks after the sample came in with peak and 17
+// with rms, which waits for the square root to be worked out a bit a
+// clock, for both. Software acknowledges each as the driver does. With
+// the made-up scream the strength must also be near the loudest envelope
+// of the whole scream: the hold is there so it is not just the level
+// that crossed the threshold.
+
+`timescale 1ns/1ps
+
+module tb_mic_env;
+
+  localparam CTRL     = 4'd0;
+  localparam STATUS   = 4'd1;
+  localparam LOUDEST  = 4'd6;
+  localparam ONSET_AT = 4'd8;
+  localparam STRENGTH = 4'd10;
+
+  // reset values in mic_env.sv
+  localparam THRESH_ON  = 8000;
+  localparam THRESH_OFF = 4000;
+  localparam PEAK_SHIFT = 6;
+  localparam RMS_SHIFT  = 7;
+  localparam HOLD       = 160;
+
+  // the codec gives a sample every 6250 clocks at 50 MHz; the rms path only
+  // needs 17, so samples come faster here to keep long recordings quick
+  localparam SAMPLE_CLKS = 100;
+  localparam MAX_SAMPLES = 8000 * 60;
+
+  logic clk = 0;
+  logic reset = 1;
+  logic [15:0] left_data = 0;
+  logic left_valid = 0;
+  logic left_ready;
+  logic [15:0] right_data = 0;
+  logic right_valid = 0;
+  logic right_ready;
+  logic [31:0] writedata = 0;
+  logic write = 0;
+  logic read = 0;
+  logic chipselect = 0;
+  logic [3:0] address = 0;
+  logic [31:0] readdata;
+  logic irq;
+
+  mic_env dut(.*);
+
+  always #10 clk = ~clk; // 50 MHz
+
+  int errors = 0;
+
+  task automatic fail(input string msg);
+    errors++;
+    $display("ERROR: %s", msg);
+  endtask
+
+  logic signed [15:0] wav [0:MAX_SAMPLES-1];
+  int n = 0;
+  int onset_expect = -1;
+  string wav_name = "";
+
+  function automatic int unsigned get16(input int fd);
+    int unsigned lo = $fgetc(fd);
+    int unsigned hi = $fgetc(fd);
+    return lo | hi << 8;
+  endfunction
+
+  function automatic int unsigned get32(input int fd);
+    int unsigned lo = get16(fd);
+    int unsigned hi = get16(fd);
+    return lo | hi << 16;
+  endfunction
+
+  function automatic logic [31:0] get_id(input int fd);
+    logic [31:0] id;
+    for (int i = 0; i < 4; i++)
+      id = {id[23:0], 8'($fgetc(fd))};
+    return id;
+  endfunction
+
+  task automatic skip(input int fd, input int unsigned bytes);
+    for (int unsigned i = 0; i < bytes; i++)
+      void'($fgetc(fd));
+  endtask
+
+  task automatic load_wav(input string name);
+    int fd = $fopen(name, "rb");
+    int unsigned size, format, channels, rate, bits;
+    logic [31:0] id;
+
+    if (fd == 0)
+      $fatal(1, "can't open %s", name);
+    if (get_id(fd) != "RIFF")
+      $fatal(1, "%s is not a RIFF file", name);
+    void'(get32(fd));
+    if (get_id(fd) != "WAVE")
+      $fatal(1, "%s is not a WAVE file", name);
+    channels = 0;
+    forever begin
+      id = get_id(fd);
+      size = get32(fd);
+      if ($feof(fd))
+        $fatal(1, "%s has no data chunk", name);
+      if (id == "fmt ") begin
+        format = get16(fd);
+        channels = get16(fd);
+        rate = get32(fd);
+        skip(fd, 6); // byte rate, block align
+        bits = get16(fd);
+        skip(fd, size - 16 + size % 2);
+        if (format != 1 || bits != 16 || channels == 0)
+          $fatal(1, "%s: need 16-bit PCM, got format %0d, %0d bits", name, format, bits);
+        if (rate != 8000)
+          $display("warning: %s is %0d Hz, played as 8 kHz", name, rate);
+      end else if (id == "data") begin
+        if (channels == 0)
+          $fatal(1, "%s: data before fmt", name);
+        for (n = 0; n < size / (2 * channels) && n < MAX_SAMPLES; n++) begin
+          wav[n] = get16(fd);
+          skip(fd, 2 * (channels - 1));
+        end
+        break;
+      end else
+        skip(fd, size + size % 2);
+    end
+    $fclose(fd);
+  endtask
+
+  task automatic make_scream();
+    for (n = 0; n < 6000; n++)
+      if (n >= 2000 && n < 4000)
+        wav[n] = 16'(int'(20000.0 * $sin(2.0 * 3.14159265 * 440.0 * n / 8000.0)));
+      else
+        wav[n] = 16'(int'($urandom_range(400, 0)) - 200);
+    onset_expect = 2000;
+  endtask
+
+  // the square root as mic_env works it out, 15 bits from the top
+  function automatic int unsigned sqrt15(input int unsigned x);
+    longint unsigned root = 0;
+    longint unsigned trial;
+    for (int b = 14; b >= 0; b--) begin
+      trial = root | (64'd1 << b);
+      if (trial * trial <= x)
+        root = trial;
+    end
+    return int'(root);
+  endfunction
+
+  // model: the samples loud turns on at, the samples their holds end on
+  // with the strength, the loudest envelope of each scream, and LOUDEST
+  // after the last one
+  int ref_onsets[$];
+  int ref_holds[$];
+  int unsigned ref_strengths[$];
+  int unsigned ref_screams[$];
+  int unsigned ref_loudest;
+
+  task automatic model(input bit rms_mode);
+    int unsigned peak = 0, mean_square = 0, rms = 0;
+    int unsigned mag, fall, level;
+    int x;
+    int held = 0;
+    bit loud = 0;
+    bit holding = 0;
+
+    ref_onsets.delete();
+    ref_holds.delete();
+    ref_strengths.delete();
+    ref_screams.delete();
+    ref_loudest = 0;
+    for (int k = 0; k < n; k++) begin
+      x = wav[k];
+      mag = x >= 0 ? x : x == -32768 ? 32767 : -x;
+      fall = (peak >> PEAK_SHIFT) == 0 && peak != 0 ? 1 : peak >> PEAK_SHIFT;
+      peak = mag > peak ? mag : peak - fall;
+      mean_square = mean_square + ((mag * mag) >> RMS_SHIFT) - (mean_square >> RMS_SHIFT);
+      rms = sqrt15(mean_square);
+      level = rms_mode ? rms : peak;
+      if (!loud && level >= THRESH_ON) begin
+        loud = 1;
+        holding = 1;
+        held = 0;
+        ref_onsets.push_back(k);
+        ref_screams.push_back(level);
+        ref_loudest = level;
+      end else if (loud) begin
+        if (holding) begin
+          held++;
+          if (held >= HOLD || level < THRESH_OFF) begin
+            holding = 0;
+            ref_holds.push_back(k);
+            ref_strengths.push_back(level > ref_loudest ? level : ref_loudest);
+          end
+        end
+        if (level < THRESH_OFF)
+          loud = 0;
+        if (level > ref_loudest)
+          ref_loudest = level;
+        if (level > ref_screams[$])
+          ref_screams[$] = level;
+      end
+    end
+  endtask
+
+  task automatic csr_write(input logic [3:0] a, input logic [31:0] d);
+    @(negedge clk);
+    chipselect = 1;
+    write = 1;
+    address = a;
+    writedata = d;
+    @(negedge clk);
+    write = 0;
+  endtask
+
+  task automatic csr_read(input logic [3:0] a, output logic [31:0] d);
+    chipselect = 1;
+    read = 1;
+    address = a;
+    #1 d = readdata;
+    read = 0;
+  endtask
+
+  // play the recording with detection on the peak or rms envelope
+  task automatic run(input string name, input bit rms_mode, input int latency);
+    int got_onsets[$];
+    int got_latency[$];
+    logic [31:0] got_at[$];
+    int got_holds[$];
+    int got_hold_latency[$];
+    logic [31:0] got_strengths[$];
+    logic [31:0] d;
+    logic [1:0] flagged = 0; // status bits 2:1 seen
+
+    model(rms_mode);
+    reset = 1;
+    repeat (4) @(negedge clk);
+    reset = 0;
+    csr_write(CTRL, rms_mode ? 32'd7 : 32'd3); // take samples, onset irq, rms
+
+    for (int k = 0; k < n; k++) begin
+      @(negedge clk);
+      write = 0; // end of the acknowledge below
+      left_data = wav[k];
+      left_valid = 1;
+      @(negedge clk); // taken on the edge in between
+      left_valid = 0;
+      // e counts clock edges since the one that took the sample
+      for (int e = 1; e < SAMPLE_CLKS; e++) begin
+        if (irq && !flagged) begin
+          csr_read(STATUS, d);
+          flagged = d[2:1];
+          if (d[1]) begin
+            csr_read(ONSET_AT, d);
+            got_onsets.push_back(k);
+            got_latency.push_back(e);
+            got_at.push_back(d);
+          end
+          if (flagged[1]) begin
+            csr_read(STRENGTH, d);
+            got_holds.push_back(k);
+            got_hold_latency.push_back(e);
+            got_strengths.push_back(d);
+          end
+        end
+        @(negedge clk);
+      end
+      if (flagged) begin // acknowledge, as the driver does from the irq
+        chipselect = 1;
+        address = STATUS;
+        writedata = {29'd0, flagged, 1'b0};
+        write = 1;
+        flagged = 0;
+      end
+    end
+    @(negedge clk);
+    write = 0;
+
+    $display("%s: %0d onsets, model %0d", name, got_onsets.size(), ref_onsets.size());
+    if (got_onsets.size() != ref_onsets.size())
+      fail($sformatf("%s: %0d onsets, the model has %0d", name, got_onsets.size(), ref_onsets.size()));
+    for (int i = 0; i < got_onsets.size() && i < ref_onsets.size(); i++) begin
+      $display("  sample %0d (%0.1f ms), irq %0d clocks after it, ONSET_AT %0d",
+               got_onsets[i], got_onsets[i] / 8.0, got_latency[i], got_at[i]);
+      if (got_onsets[i] != ref_onsets[i])
+        fail($sformatf("%s: onset %0d on sample %0d, model %0d", name, i, got_onsets[i], ref_onsets[i]));
+      if (got_latency[i] != latency)
+        fail($sformatf("%s: irq %0d clocks after the sample, expected %0d", name, got_latency[i], latency));
+      if (got_at[i] != ref_onsets[i] + 1)
+        fail($sformatf("%s: ONSET_AT %0d, expected %0d", name, got_at[i], ref_onsets[i] + 1));
+    end
+    if (onset_expect >= 0 && got_onsets.size() != 0) begin
+      $display("  first onset %0.1f ms after the scream starts", (got_onsets[0] - onset_expect) / 8.0);
+      if (got_onsets[0] < onset_expect || got_onsets[0] > onset_expect + 128)
+        fail($sformatf("%s: first onset on sample %0d, the scream starts on %0d", name, got_onsets[0], onset_expect));
+    end
+    if (onset_expect >= 0 && got_onsets.size() == 0)
+      fail($sformatf("%s: the scream was not heard", name));
+
+    if (got_holds.size() != ref_holds.size())
+      fail($sformatf("%s: %0d strengths, the model has %0d", name, got_holds.size(), ref_holds.size()));
+    for (int i = 0; i < got_holds.size() && i < ref_holds.size(); i++) begin
+      $display("  strength %0d on sample %0d, %0d samples after the onset, irq %0d clocks after it; the scream got to %0d",
+               got_strengths[i], got_holds[i], got_holds[i] - ref_onsets[i], got_hold_latency[i], ref_screams[i]);
+      if (got_holds[i] != ref_holds[i])
+        fail($sformatf("%s: strength %0d on sample %0d, model %0d", name, i, got_holds[i], ref_holds[i]));
+      if (got_hold_latency[i] != latency)
+        fail($sformatf("%s: strength irq %0d clocks after the sample, expected %0d", name, got_hold_latency[i], latency));
+      if (got_strengths[i] != ref_strengths[i])
+        fail($sformatf("%s: strength %0d, model %0d", name, got_strengths[i], ref_strengths[i]));
+      // the made-up scream is a steady tone: by the end of the hold the
+      // envelope should be most of the way to where the whole scream gets
+      if (wav_name == "" && got_strengths[i] * 4 < ref_screams[i] * 3)
+        fail($sformatf("%s: strength %0d, under 3/4 of the scream's %0d", name, got_strengths[i], ref_screams[i]));
+    end
+
+    csr_read(LOUDEST, d);
+    if (d != ref_loudest)
+      fail($sformatf("%s: LOUDEST %0d, model %0d", name, d, ref_loudest));
+  endtask
+
+  initial begin
+    if ($value$plusargs("wav=%s", wav_name))
+      load_wav(wav_name);
+    else
+      make_scream();
+    void'($value$plusargs("onset=%d", onset_expect));
+    $display("%0d samples", n);
+
+    run("peak", 0, 2);
+    run("rms", 1, 17);
+
+    if (errors == 0)
+      $display("PASS");
+    else
+      $display("FAIL: %0d errors", errors);
+    $finish;
+  end
+
+endmodule
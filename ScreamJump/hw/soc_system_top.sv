@@ -278,11 +278,13 @@ module soc_system_top(
       .vga_blank_n (VGA_BLANK_N),
       .vga_sync_n (VGA_SYNC_N),
 
-    //   // connect the audio codec chip
-    //  .audio_0_external_interface_BCLK                  (AUD_BCLK),
-    //  .audio_0_external_interface_DACDAT                (AUD_DACDAT),
-    //  .audio_0_external_interface_DACLRCK               (AUD_DACLRCK),
-    //  .audio_pll_0_audio_clk_clk                        (AUD_XCK),***
+      // connect the audio codec chip; the mic comes in on the adc
+     .audio_0_external_interface_ADCDAT                (AUD_ADCDAT),
+     .audio_0_external_interface_ADCLRCK               (AUD_ADCLRCK),
+     .audio_0_external_interface_BCLK                  (AUD_BCLK),
+     .audio_0_external_interface_DACDAT                (AUD_DACDAT),
+     .audio_0_external_interface_DACLRCK               (AUD_DACLRCK),
+     .audio_pll_0_audio_clk_clk                        (AUD_XCK),
       // connect the audio/video config
      .audio_and_video_config_0_external_interface_SDAT (FPGA_I2C_SDAT),
      .audio_and_video_config_0_external_interface_SCLK (FPGA_I2C_SCLK)  
@@ -295,11 +297,11 @@ module soc_system_top(
    assign ADC_DIN = SW[0];
    assign ADC_SCLK = SW[0];
    
-   assign AUD_ADCLRCK = SW[1] ? SW[0] : 1'bZ;
-   assign AUD_BCLK = SW[1] ? SW[0] : 1'bZ;
-   assign AUD_DACDAT = SW[0];
-   assign AUD_DACLRCK = SW[1] ? SW[0] : 1'bZ;
-   assign AUD_XCK = SW[0];      
+   //assign AUD_ADCLRCK = SW[1] ? SW[0] : 1'bZ;
+   //assign AUD_BCLK = SW[1] ? SW[0] : 1'bZ;
+   //assign AUD_DACDAT = SW[0];
+   //assign AUD_DACLRCK = SW[1] ? SW[0] : 1'bZ;
+   //assign AUD_XCK = SW[0];      
 
    assign DRAM_ADDR = { 13{ SW[0] } };
    assign DRAM_BA = { 2{ SW[0] } };
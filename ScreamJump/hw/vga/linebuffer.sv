@@ -30,10 +30,10 @@ module linebuffer(
 	input	[5:0]  address_tile_draw;
 	input	[9:0]  address_pixel_draw;
 
-	input	[255:0]  data_tile_display;
-  input	[15:0]  data_pixel_display;
-  input	[255:0]  data_tile_draw;
-  input	[15:0]  data_pixel_draw;
+	input	[127:0]  data_tile_display;
+  input	[7:0]  data_pixel_display;
+  input	[127:0]  data_tile_draw;
+  input	[7:0]  data_pixel_draw;
 	
   
 	input	  wren_tile_display;
@@ -41,22 +41,22 @@ module linebuffer(
   input	  wren_tile_draw;
 	input	  wren_pixel_draw;
 
-	output	[255:0]  q_tile_display;
-  output	[15:0]  q_pixel_display;
-  output	[255:0]  q_tile_draw;
-  output	[15:0]  q_pixel_draw;
+	output	[127:0]  q_tile_display;
+  output	[7:0]  q_pixel_display;
+  output	[127:0]  q_tile_draw;
+  output	[7:0]  q_pixel_draw;
 
   wire [5:0] address_tile[1:0];
   wire [9:0] address_pixel[1:0];
 
-  wire [255:0] data_tile[1:0];
-  wire [16:0] data_pixel[1:0];
+  wire [127:0] data_tile[1:0];
+  wire [7:0] data_pixel[1:0];
 
   wire wren_tile[1:0];
   wire wren_pixel[1:0];
 
-  wire [255:0] q_tile[1:0];
-  wire [16:0] q_pixel[1:0];
+  wire [127:0] q_tile[1:0];
+  wire [7:0] q_pixel[1:0];
 
   logic display_index;
   logic draw_index;
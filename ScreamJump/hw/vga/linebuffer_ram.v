@@ -51,12 +51,12 @@ module linebuffer_ram (
 	input	[5:0]  address_a;
 	input	[9:0]  address_b;
 	input	  clock;
-	input	[255:0]  data_a;
-	input	[15:0]  data_b;
+	input	[127:0]  data_a;
+	input	[7:0]  data_b;
 	input	  wren_a;
 	input	  wren_b;
-	output	[255:0]  q_a;
-	output	[15:0]  q_b;
+	output	[127:0]  q_a;
+	output	[7:0]  q_b;
 `ifndef ALTERA_RESERVED_QIS
 // synopsys translate_off
 `endif
@@ -67,10 +67,10 @@ module linebuffer_ram (
 // synopsys translate_on
 `endif
 
-	wire [255:0] sub_wire0;
-	wire [15:0] sub_wire1;
-	wire [255:0] q_a = sub_wire0[255:0];
-	wire [15:0] q_b = sub_wire1[15:0];
+	wire [127:0] sub_wire0;
+	wire [7:0] sub_wire1;
+	wire [127:0] q_a = sub_wire0[127:0];
+	wire [7:0] q_b = sub_wire1[7:0];
 
 	altsyncram	altsyncram_component (
 				.address_a (address_a),
@@ -118,8 +118,8 @@ module linebuffer_ram (
 		altsyncram_component.read_during_write_mode_port_b = "NEW_DATA_NO_NBE_READ",
 		altsyncram_component.widthad_a = 6,
 		altsyncram_component.widthad_b = 10,
-		altsyncram_component.width_a = 256,
-		altsyncram_component.width_b = 16,
+		altsyncram_component.width_a = 128,
+		altsyncram_component.width_b = 8,
 		altsyncram_component.width_byteena_a = 1,
 		altsyncram_component.width_byteena_b = 1,
 		altsyncram_component.wrcontrol_wraddress_reg_b = "CLOCK0";
@@ -160,7 +160,7 @@ endmodule
 // Retrieval info: PRIVATE: JTAG_ENABLED NUMERIC "0"
 // Retrieval info: PRIVATE: JTAG_ID STRING "NONE"
 // Retrieval info: PRIVATE: MAXIMUM_DEPTH NUMERIC "0"
-// Retrieval info: PRIVATE: MEMSIZE NUMERIC "10240"
+// Retrieval info: PRIVATE: MEMSIZE NUMERIC "5120"
 // Retrieval info: PRIVATE: MEM_IN_BITS NUMERIC "1"
 // Retrieval info: PRIVATE: MIFfilename STRING ""
 // Retrieval info: PRIVATE: OPERATION_MODE NUMERIC "3"
@@ -181,9 +181,9 @@ endmodule
 // Retrieval info: PRIVATE: UseDPRAM NUMERIC "1"
 // Retrieval info: PRIVATE: VarWidth NUMERIC "1"
 // Retrieval info: PRIVATE: WIDTH_READ_A NUMERIC "128"
-// Retrieval info: PRIVATE: WIDTH_READ_B NUMERIC "16"
+// Retrieval info: PRIVATE: WIDTH_READ_B NUMERIC "8"
 // Retrieval info: PRIVATE: WIDTH_WRITE_A NUMERIC "128"
-// Retrieval info: PRIVATE: WIDTH_WRITE_B NUMERIC "16"
+// Retrieval info: PRIVATE: WIDTH_WRITE_B NUMERIC "8"
 // Retrieval info: PRIVATE: WRADDR_ACLR_B NUMERIC "0"
 // Retrieval info: PRIVATE: WRADDR_REG_B NUMERIC "1"
 // Retrieval info: PRIVATE: WRCTRL_ACLR_B NUMERIC "0"
@@ -212,7 +212,7 @@ endmodule
 // Retrieval info: CONSTANT: WIDTHAD_A NUMERIC "7"
 // Retrieval info: CONSTANT: WIDTHAD_B NUMERIC "10"
 // Retrieval info: CONSTANT: WIDTH_A NUMERIC "128"
-// Retrieval info: CONSTANT: WIDTH_B NUMERIC "16"
+// Retrieval info: CONSTANT: WIDTH_B NUMERIC "8"
 // Retrieval info: CONSTANT: WIDTH_BYTEENA_A NUMERIC "1"
 // Retrieval info: CONSTANT: WIDTH_BYTEENA_B NUMERIC "1"
 // Retrieval info: CONSTANT: WRCONTROL_WRADDRESS_REG_B STRING "CLOCK0"
@@ -220,20 +220,20 @@ endmodule
 // Retrieval info: USED_PORT: address_b 0 0 10 0 INPUT NODEFVAL "address_b[9..0]"
 // Retrieval info: USED_PORT: clock 0 0 0 0 INPUT VCC "clock"
 // Retrieval info: USED_PORT: data_a 0 0 128 0 INPUT NODEFVAL "data_a[127..0]"
-// Retrieval info: USED_PORT: data_b 0 0 16 0 INPUT NODEFVAL "data_b[15..0]"
+// Retrieval info: USED_PORT: data_b 0 0 8 0 INPUT NODEFVAL "data_b[7..0]"
 // Retrieval info: USED_PORT: q_a 0 0 128 0 OUTPUT NODEFVAL "q_a[127..0]"
-// Retrieval info: USED_PORT: q_b 0 0 16 0 OUTPUT NODEFVAL "q_b[15..0]"
+// Retrieval info: USED_PORT: q_b 0 0 8 0 OUTPUT NODEFVAL "q_b[7..0]"
 // Retrieval info: USED_PORT: wren_a 0 0 0 0 INPUT GND "wren_a"
 // Retrieval info: USED_PORT: wren_b 0 0 0 0 INPUT GND "wren_b"
 // Retrieval info: CONNECT: @address_a 0 0 7 0 address_a 0 0 7 0
 // Retrieval info: CONNECT: @address_b 0 0 10 0 address_b 0 0 10 0
 // Retrieval info: CONNECT: @clock0 0 0 0 0 clock 0 0 0 0
 // Retrieval info: CONNECT: @data_a 0 0 128 0 data_a 0 0 128 0
-// Retrieval info: CONNECT: @data_b 0 0 16 0 data_b 0 0 16 0
+// Retrieval info: CONNECT: @data_b 0 0 8 0 data_b 0 0 8 0
 // Retrieval info: CONNECT: @wren_a 0 0 0 0 wren_a 0 0 0 0
 // Retrieval info: CONNECT: @wren_b 0 0 0 0 wren_b 0 0 0 0
 // Retrieval info: CONNECT: q_a 0 0 128 0 @q_a 0 0 128 0
-// Retrieval info: CONNECT: q_b 0 0 16 0 @q_b 0 0 16 0
+// Retrieval info: CONNECT: q_b 0 0 8 0 @q_b 0 0 8 0
 // Retrieval info: GEN_FILE: TYPE_NORMAL ram.v TRUE
 // Retrieval info: GEN_FILE: TYPE_NORMAL ram.inc FALSE
 // Retrieval info: GEN_FILE: TYPE_NORMAL ram.cmp FALSE
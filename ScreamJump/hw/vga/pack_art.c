@@ -0,0 +1,520 @@
+/*
+ * pack_art: build the tile and sprite roms, the palette and the sky
+ * palettes from the art
+ *
+ * Usage: pack_art sprite_pixels.mif tile_pixels.mif combined_sprite.mif
+ *                 combined_tile.mif palette.mif sky_palette.h
+ *
+ * The art is Quartus mifs of 16-bit pixels, red in bits 15:11, green in
+ * 10:6 and blue in 5:1. Sprite art is 32x32 per image, row major, image n
+ * at word n * 1024, one pixel per word; bit 0 set is a transparent pixel.
+ * Tile art is a 256-bit word per 16-pixel row, 16 rows per tile, the
+ * leftmost pixel in the low 16 bits.
+ *
+ * The roms hold 8-bit palette indices instead, laid out as the art: the
+ * sprite rom one pixel per word, the tile rom a 128-bit word per tile row
+ * with the leftmost pixel in the low 8 bits. Words the art leaves out are
+ * transparent (sprites) or index 0 (tiles). The colours of the art are
+ * cut down to palette entries 1 to SKY_FIRST - 1 (median cut, then a few
+ * k-means passes) and every pixel becomes the nearest of them; index 0 is
+ * a transparent sprite pixel. palette.mif is what the palette ram holds
+ * from reset, 16 bits an entry in the art's format.
+ *
+ * The sky tile and the star tile are drawn with entries SKY_FIRST to 255
+ * only, so the game switches between day, evening and night by rewriting
+ * those entries instead of the tilemap. Each of their pixels has three
+ * colours: the sky tile is the day sky, the evening sky or the night sky
+ * tile, the star tile the day sky, the evening sky or the stars. The 512
+ * colour triples are clustered into SKY_ENTRIES, and sky_palette.h gets
+ * the day, evening and night colour of each for vga_interface.c.
+ * palette.mif starts with the day sky.
+ *
+ * Built on the host: cc -o pack_art pack_art.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGES 32 // 5-bit image number
+#define IMAGE_PIXELS (32 * 32)
+#define ROM_WORDS (IMAGES * IMAGE_PIXELS)
+
+#define TILES 256 // 8-bit tile number
+#define TILE_PIXELS (16 * 16)
+#define TILE_WORDS (TILES * 16)
+
+#define TRANSPARENT 0x0001
+#define COLOURS (1 << 15) // 5 bits each of red, green and blue
+#define PALETTE 256 // entry 0 is transparent
+
+// tile numbers as in vga_interface.h
+#define SKY_TILE 37 // SKY_TILE_IDX
+#define EVE_TILE 43 // EVE_TILE_IDX
+#define NIGHT_TILE 0 // NIGHTSKY_TILE_IDX
+#define STAR_TILE 44 // STAR_TILE_IDX
+
+#define SKIES 3 // day, evening, night
+#define SKY_ENTRIES 128 // the sky is most of the screen
+#define SKY_FIRST (PALETTE - SKY_ENTRIES)
+#define SKY_PIXELS (2 * TILE_PIXELS) // the sky tile's, then the star tile's
+
+static unsigned short art[IMAGES * IMAGE_PIXELS];
+static unsigned short tile_art[TILES * TILE_PIXELS];
+
+static unsigned int counts[COLOURS]; // pixels of each colour in the art
+static unsigned short palette[PALETTE];
+static unsigned char index_of[COLOURS]; // palette entry each colour is drawn with
+
+static unsigned short sky_palette[SKIES][SKY_ENTRIES];
+static unsigned char sky_index[SKY_PIXELS]; // sky entry, from SKY_FIRST
+
+/* Read "addr : data;" lines between BEGIN and END, both hex, into words of width 16 * per_word */
+static int read_mif(const char *path, unsigned short *pixels, int words, int per_word)
+{
+  FILE *f = fopen(path, "r");
+  char line[512];
+  int in_content = 0, read = 0;
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    unsigned int addr;
+    char data[256];
+    int len;
+
+    if (!in_content) {
+      if (strstr(line, "BEGIN"))
+        in_content = 1;
+      continue;
+    }
+    if (strstr(line, "END"))
+      break;
+    if (sscanf(line, " %x : %255[0-9A-Fa-f]", &addr, data) != 2)
+      continue;
+    if (addr >= (unsigned int) words) {
+      fprintf(stderr, "%s: address %x is past word %x\n", path, addr, words - 1);
+      fclose(f);
+      return -1;
+    }
+    // the last four digits are the leftmost pixel, the low 16 bits
+    len = strlen(data);
+    for (int k = 0; k < per_word; k++) {
+      char digits[5] = "0000";
+      for (int d = 0; d < 4; d++) {
+        int at = len - 4 * (k + 1) + d;
+        if (at >= 0)
+          digits[d] = data[at];
+      }
+      pixels[addr * per_word + k] = strtoul(digits, NULL, 16);
+    }
+    read++;
+  }
+  fclose(f);
+  if (!in_content) {
+    fprintf(stderr, "%s: no CONTENT BEGIN\n", path);
+    return -1;
+  }
+  return read;
+}
+
+/*
+ * Median cut: start with one box around every colour the art uses, keep
+ * splitting the box with the most pixels times its widest channel squared
+ * at the pixel-weighted median of that channel, and give each box the
+ * weighted mean of its colours
+ */
+struct box {
+  int first, count; // into colours[]
+  int axis, width; // widest channel and its range
+  long pixels; // of the art in the box
+};
+
+static int sort_axis;
+
+static int channel(int colour, int axis)
+{
+  return (colour >> (10 - 5 * axis)) & 0x1f; // 0 red, 1 green, 2 blue
+}
+
+static int compare_colours(const void *a, const void *b)
+{
+  return channel(*(const int *) a, sort_axis) - channel(*(const int *) b, sort_axis);
+}
+
+static void measure(struct box *b, const int *colours)
+{
+  b->pixels = 0;
+  for (int i = b->first; i < b->first + b->count; i++)
+    b->pixels += counts[colours[i]];
+  b->width = -1;
+  for (int axis = 0; axis < 3; axis++) {
+    int lo = 31, hi = 0;
+    for (int i = b->first; i < b->first + b->count; i++) {
+      int v = channel(colours[i], axis);
+      if (v < lo)
+        lo = v;
+      if (v > hi)
+        hi = v;
+    }
+    if (hi - lo > b->width) {
+      b->width = hi - lo;
+      b->axis = axis;
+    }
+  }
+}
+
+/* Entries 1 to max at most; returns how many are used */
+static int build_palette(int max)
+{
+  static int colours[COLOURS];
+  static struct box boxes[PALETTE - 1];
+  int n = 0, nboxes = 1;
+
+  for (int c = 0; c < COLOURS; c++)
+    if (counts[c])
+      colours[n++] = c;
+  if (n == 0)
+    return 0;
+  boxes[0].first = 0;
+  boxes[0].count = n;
+  measure(&boxes[0], colours);
+
+  while (nboxes < max) {
+    struct box *b = NULL, *split;
+    long total = 0, half = 0;
+    int i;
+
+    for (i = 0; i < nboxes; i++)
+      if (boxes[i].count > 1 && (!b || boxes[i].width * boxes[i].width * boxes[i].pixels >
+                                        b->width * b->width * b->pixels))
+        b = &boxes[i];
+    if (!b)
+      break; // every colour has an entry of its own
+    sort_axis = b->axis;
+    qsort(colours + b->first, b->count, sizeof(int), compare_colours);
+    for (i = b->first; i < b->first + b->count; i++)
+      total += counts[colours[i]];
+    // at least one colour either side, even if the last has most of the pixels
+    for (i = b->first; i < b->first + b->count - 2; i++) {
+      half += counts[colours[i]];
+      if (2 * half >= total)
+        break;
+    }
+    split = &boxes[nboxes++];
+    split->first = i + 1;
+    split->count = b->first + b->count - split->first;
+    b->count = split->first - b->first;
+    measure(b, colours);
+    measure(split, colours);
+  }
+
+  for (int e = 0; e < nboxes; e++) {
+    double sum[3] = {0, 0, 0}, total = 0;
+    int rgb[3];
+    for (int i = boxes[e].first; i < boxes[e].first + boxes[e].count; i++) {
+      for (int axis = 0; axis < 3; axis++)
+        sum[axis] += (double) channel(colours[i], axis) * counts[colours[i]];
+      total += counts[colours[i]];
+    }
+    for (int axis = 0; axis < 3; axis++)
+      rgb[axis] = (int) (sum[axis] / total + 0.5);
+    palette[e + 1] = rgb[0] << 11 | rgb[1] << 6 | rgb[2] << 1;
+  }
+  return nboxes;
+}
+
+/* Nearest entry for every colour the art uses; returns the mean squared error per pixel */
+static double map_colours(int entries, int *worst)
+{
+  long pixels = 0;
+  double error = 0;
+
+  *worst = 0;
+  for (int c = 0; c < COLOURS; c++) {
+    int best = 1, best_d = -1;
+    if (!counts[c])
+      continue;
+    for (int e = 1; e <= entries; e++) {
+      int p = palette[e] >> 1, d = 0;
+      for (int axis = 0; axis < 3; axis++) {
+        int diff = channel(c, axis) - channel(p, axis);
+        d += diff * diff;
+      }
+      if (best_d < 0 || d < best_d) {
+        best = e;
+        best_d = d;
+      }
+    }
+    index_of[c] = best;
+    if (best_d > *worst)
+      *worst = best_d;
+    error += (double) best_d * counts[c];
+    pixels += counts[c];
+  }
+  return pixels ? error / pixels : 0;
+}
+
+/* Move every entry to the weighted mean of the colours drawn with it (k-means), a few times over */
+#define REFINE_PASSES 16
+
+static void refine_palette(int entries)
+{
+  double before, after = 0;
+  int worst;
+
+  before = map_colours(entries, &worst);
+  for (int pass = 0; pass < REFINE_PASSES; pass++) {
+    static double sum[PALETTE][3], total[PALETTE];
+
+    memset(sum, 0, sizeof(sum));
+    memset(total, 0, sizeof(total));
+    for (int c = 0; c < COLOURS; c++) {
+      if (!counts[c])
+        continue;
+      for (int axis = 0; axis < 3; axis++)
+        sum[index_of[c]][axis] += (double) channel(c, axis) * counts[c];
+      total[index_of[c]] += counts[c];
+    }
+    for (int e = 1; e <= entries; e++) {
+      int rgb[3];
+      if (total[e] == 0)
+        continue; // nothing nearest to it, leave it be
+      for (int axis = 0; axis < 3; axis++)
+        rgb[axis] = (int) (sum[e][axis] / total[e] + 0.5);
+      palette[e] = rgb[0] << 11 | rgb[1] << 6 | rgb[2] << 1;
+    }
+    after = map_colours(entries, &worst);
+  }
+  printf("mean squared error %.2f (median cut) -> %.2f, worst %d (5-bit channels)\n",
+         before, REFINE_PASSES ? after : before, worst);
+}
+
+/* Colour of sky pixel p, as sky_index counts them, in each sky */
+static int sky_colour(int p, int sky)
+{
+  static const int looks[2][SKIES] = {
+    {SKY_TILE, EVE_TILE, NIGHT_TILE},
+    {SKY_TILE, EVE_TILE, STAR_TILE},
+  };
+  return tile_art[looks[p / TILE_PIXELS][sky] * TILE_PIXELS + p % TILE_PIXELS] >> 1;
+}
+
+/* Squared distance over all three skies between sky pixel p and a cluster centre */
+static double sky_distance(int p, const double *centre)
+{
+  double d = 0;
+  for (int sky = 0; sky < SKIES; sky++)
+    for (int axis = 0; axis < 3; axis++) {
+      double diff = channel(sky_colour(p, sky), axis) - centre[sky * 3 + axis];
+      d += diff * diff;
+    }
+  return d;
+}
+
+static int nearest_centre(int p, double centres[][SKIES * 3])
+{
+  int best = 0;
+  for (int e = 1; e < SKY_ENTRIES; e++)
+    if (sky_distance(p, centres[e]) < sky_distance(p, centres[best]))
+      best = e;
+  return best;
+}
+
+/*
+ * Cluster the sky pixels' colour triples into the sky entries: start from
+ * the pixel farthest from the centres so far, then k-means passes
+ */
+#define SKY_PASSES 32
+
+static void build_sky(void)
+{
+  static double centres[SKY_ENTRIES][SKIES * 3];
+  double error[SKIES] = {0, 0, 0};
+
+  for (int e = 0; e < SKY_ENTRIES; e++) {
+    int far = 0;
+    double far_d = -1;
+    for (int p = 0; p < SKY_PIXELS; p++) {
+      double d = -1;
+      for (int c = 0; c < e; c++)
+        if (d < 0 || sky_distance(p, centres[c]) < d)
+          d = sky_distance(p, centres[c]);
+      if (d > far_d) {
+        far = p;
+        far_d = d;
+      }
+    }
+    for (int sky = 0; sky < SKIES; sky++)
+      for (int axis = 0; axis < 3; axis++)
+        centres[e][sky * 3 + axis] = channel(sky_colour(far, sky), axis);
+  }
+
+  for (int pass = 0; pass < SKY_PASSES; pass++) {
+    static double sum[SKY_ENTRIES][SKIES * 3];
+    static int total[SKY_ENTRIES];
+
+    memset(sum, 0, sizeof(sum));
+    memset(total, 0, sizeof(total));
+    for (int p = 0; p < SKY_PIXELS; p++) {
+      int e = nearest_centre(p, centres);
+      for (int sky = 0; sky < SKIES; sky++)
+        for (int axis = 0; axis < 3; axis++)
+          sum[e][sky * 3 + axis] += channel(sky_colour(p, sky), axis);
+      total[e]++;
+    }
+    for (int e = 0; e < SKY_ENTRIES; e++)
+      if (total[e])
+        for (int k = 0; k < SKIES * 3; k++)
+          centres[e][k] = sum[e][k] / total[e];
+  }
+
+  for (int e = 0; e < SKY_ENTRIES; e++)
+    for (int sky = 0; sky < SKIES; sky++) {
+      int rgb[3];
+      for (int axis = 0; axis < 3; axis++) {
+        rgb[axis] = (int) (centres[e][sky * 3 + axis] + 0.5);
+        centres[e][sky * 3 + axis] = rgb[axis];
+      }
+      sky_palette[sky][e] = rgb[0] << 11 | rgb[1] << 6 | rgb[2] << 1;
+    }
+  for (int p = 0; p < SKY_PIXELS; p++) {
+    int e = sky_index[p] = nearest_centre(p, centres);
+    for (int sky = 0; sky < SKIES; sky++)
+      for (int axis = 0; axis < 3; axis++) {
+        int diff = channel(sky_colour(p, sky), axis) - channel(sky_palette[sky][e] >> 1, axis);
+        error[sky] += diff * diff;
+      }
+  }
+  printf("sky: %d entries, mean squared error %.2f day, %.2f evening, %.2f night\n", SKY_ENTRIES,
+         error[0] / SKY_PIXELS, error[1] / SKY_PIXELS, error[2] / SKY_PIXELS);
+}
+
+static int write_sprite_rom(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 8;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          ROM_WORDS);
+  for (int w = 0; w < ROM_WORDS; w++)
+    fprintf(f, "%04X : %02X;\n", w, (art[w] & TRANSPARENT) ? 0 : index_of[art[w] >> 1]);
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+static int write_tile_rom(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 128;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          TILE_WORDS);
+  for (int w = 0; w < TILE_WORDS; w++) {
+    int tile = w / 16;
+    fprintf(f, "%03X : ", w);
+    for (int k = 15; k >= 0; k--) {
+      int p = w % 16 * 16 + k;
+      if (tile == SKY_TILE)
+        fprintf(f, "%02X", SKY_FIRST + sky_index[p]);
+      else if (tile == STAR_TILE)
+        fprintf(f, "%02X", SKY_FIRST + sky_index[TILE_PIXELS + p]);
+      else
+        fprintf(f, "%02X", index_of[tile_art[w * 16 + k] >> 1]);
+    }
+    fprintf(f, ";\n");
+  }
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+static int write_palette(const char *path, int entries)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "DEPTH = %d;\nWIDTH = 16;\nADDRESS_RADIX = HEX;\nDATA_RADIX = HEX;\nCONTENT\nBEGIN\n",
+          PALETTE);
+  for (int e = 0; e < PALETTE; e++)
+    fprintf(f, "%02X : %04X;\n", e,
+            e >= SKY_FIRST ? sky_palette[0][e - SKY_FIRST] : e <= entries ? palette[e] : 0);
+  fprintf(f, "END;\n");
+  return fclose(f);
+}
+
+static int write_sky_h(const char *path)
+{
+  static const char *names[SKIES] = {"day", "evening", "night"};
+  FILE *f = fopen(path, "w");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  fprintf(f, "/* Sky palettes matching combined_tile.mif, generated by pack_art */\n");
+  fprintf(f, "#ifndef _SKY_PALETTE_H\n#define _SKY_PALETTE_H\n\n");
+  fprintf(f, "#define SKY_PALETTE_FIRST %d /* entries the sky and star tiles are drawn with */\n", SKY_FIRST);
+  fprintf(f, "#define SKY_PALETTE_ENTRIES %d\n\n", SKY_ENTRIES);
+  fprintf(f, "enum { SKY_DAY, SKY_EVENING, SKY_NIGHT, SKIES };\n\n");
+  fprintf(f, "static const unsigned short sky_palette[SKIES][SKY_PALETTE_ENTRIES] = {\n");
+  for (int sky = 0; sky < SKIES; sky++) {
+    fprintf(f, "  { /* %s */", names[sky]);
+    for (int e = 0; e < SKY_ENTRIES; e++)
+      fprintf(f, "%s0x%04x,", e % 8 ? " " : "\n    ", sky_palette[sky][e]);
+    fprintf(f, "\n  },\n");
+  }
+  fprintf(f, "};\n\n#endif\n");
+  return fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+  int words, tile_words, used = 0, entries;
+
+  if (argc != 7) {
+    fprintf(stderr, "Usage: %s sprite_pixels.mif tile_pixels.mif combined_sprite.mif "
+            "combined_tile.mif palette.mif sky_palette.h\n", argv[0]);
+    return 1;
+  }
+  for (int i = 0; i < IMAGES * IMAGE_PIXELS; i++)
+    art[i] = TRANSPARENT;
+  if ((words = read_mif(argv[1], art, IMAGES * IMAGE_PIXELS, 1)) < 0 ||
+      (tile_words = read_mif(argv[2], tile_art, TILE_WORDS, 16)) < 0)
+    return 1;
+  if (tile_words < (STAR_TILE + 1) * 16) {
+    fprintf(stderr, "%s: no star tile (%d)\n", argv[2], STAR_TILE);
+    return 1;
+  }
+
+  // the sky and star tiles only use the sky entries
+  for (int i = 0; i < IMAGES * IMAGE_PIXELS; i++)
+    if (!(art[i] & TRANSPARENT))
+      counts[art[i] >> 1]++;
+  for (int i = 0; i < tile_words * 16; i++)
+    if (i / TILE_PIXELS != SKY_TILE && i / TILE_PIXELS != STAR_TILE)
+      counts[tile_art[i] >> 1]++;
+  for (int c = 0; c < COLOURS; c++)
+    used += counts[c] != 0;
+  entries = build_palette(SKY_FIRST - 1);
+  printf("%d colours -> %d palette entries\n", used, entries);
+  refine_palette(entries);
+  build_sky();
+
+  if (write_sprite_rom(argv[3]) || write_tile_rom(argv[4]) ||
+      write_palette(argv[5], entries) || write_sky_h(argv[6]))
+    return 1;
+  printf("%d sprite pixels -> %d words, %d tile rows -> %d words of 16\n",
+         words, ROM_WORDS, tile_words, TILE_WORDS);
+  return 0;
+}
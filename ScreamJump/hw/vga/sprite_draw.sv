@@ -8,7 +8,7 @@ module sprite_draw(input logic clk,
                     input logic [4:0] img_num,
                     output logic wren,
                     output logic [9:0] pixel_hcount, // where the pixel goes on the row
-                    output logic [15:0] data, // pixel data
+                    output logic [7:0] data, // palette index, 0 is transparent
                     output logic finish
 );
 
@@ -16,7 +16,7 @@ module sprite_draw(input logic clk,
   sprite_rom(sprite_rom_address, clk, data); 
 
   logic [5:0] col;
-  assign wren = (!finish) && (col > 0) && (data[0] == 0); // write only not transparent 
+  assign wren = (!finish) && (col > 0) && (data != 0); // write only not transparent 
 
   always_ff @(posedge clk) begin
     if (reset) begin 
@@ -1,3 +1,15 @@
+/*
+ * Sprites for one line: sprite_active compares all 32 sprites against the
+ * next line in parallel while the tiles load, and on start the hits are
+ * drawn lowest number first (higher numbers end up on top), skipping the
+ * sprites that are not on the line at no cost.
+ *
+ * Line budget, 1600 cycles: the tiles are done around hcount 45 and the
+ * line buffers switch at 1597, which leaves about 1550 cycles. A sprite
+ * takes about 37 (3 to start it, 34 in sprite_draw), so up to 41 sprites
+ * fit on one line: all 32 on the same line still finish near hcount 1230.
+ * vga_top exposes NUM_SPRITES of them; the rest are never set active.
+ */
 module sprite_loader(input logic clk,
                    input logic reset,
                    input logic start,
@@ -5,93 +17,75 @@ module sprite_loader(input logic clk,
                    input logic [4:0] sprite_register_number, //kv2446
                    input logic [24:0] writedata,
                    input logic [9:0] vcount,
-                   output logic [9:0] address_pixel_draw, 
-                   output logic [15:0] data_pixel_draw,
+                   output logic [9:0] address_pixel_draw,
+                   output logic [7:0] data_pixel_draw,
                    output logic finish,
                    output logic wren_pixel_draw
 );
-    logic sprite_active_start;
-    logic [4:0] sprite_number; //kv2446
-    logic [9:0] actual_vcount; 
+    logic [4:0] sprite_number;
+    logic [9:0] actual_vcount;
+    logic [31:0] hits;
     logic [4:0] row_in_sprite;
     logic [9:0] sprite_column;
     logic [4:0] img_num;
-    logic is_active;
-    logic sprite_active_finish;
-    logic checking;
-    logic checked;
 
-    sprite_active(clk, reset, write, sprite_register_number, sprite_number, writedata, sprite_active_start, actual_vcount, row_in_sprite, sprite_column, img_num, is_active, sprite_active_finish);
+    // calculate actual vcount: the line after this one, 0 after the last blank line
+    assign actual_vcount = (vcount == 524) ? 10'd0 : vcount + 10'd1;
+
+    sprite_active(clk, reset, write, sprite_register_number, sprite_number, writedata, actual_vcount, hits, row_in_sprite, sprite_column, img_num);
 
 
     logic sprite_draw_start;
     logic sprite_draw_finish;
     logic drawing;
 
-    sprite_draw(clk, reset, sprite_draw_start, row_in_sprite, sprite_column, img_num, wren_pixel_draw, address_pixel_draw, data_pixel_draw, sprite_draw_finish); 
-    
+    sprite_draw(clk, reset, sprite_draw_start, row_in_sprite, sprite_column, img_num, wren_pixel_draw, address_pixel_draw, data_pixel_draw, sprite_draw_finish);
+
+    // sprites on this line not drawn yet, and the lowest of them
+    logic [31:0] pending;
+    logic [4:0] next_sprite;
+
+    always_comb begin
+        next_sprite = 0;
+        for (int i = 31; i >= 0; i--)
+            if (pending[i])
+                next_sprite = i;
+    end
 
     always_ff @(posedge clk) begin
         if (reset) begin
             finish <= 1;
             drawing <= 0;
-            checked <= 0;
-            checking <= 0;
-            sprite_active_start <= 0;
+            pending <= 0;
+            sprite_number <= 0;
             sprite_draw_start <= 0;
         end else if (start) begin
-            sprite_number <= 0;
-            finish <= 0;
-            checked <= 0;
-            checking <= 0;
             drawing <= 0;
-            // calculate actual vcount
-            if (vcount < 479) begin
-                actual_vcount <= vcount + 1;
-            end else if (vcount >= 479 && vcount < 524) begin
-                finish <= 1; // inactive lines, nothing to draw      
-            end else if (vcount == 524) begin 
-                actual_vcount <= 0; // draw the first line
+            sprite_draw_start <= 0;
+            pending <= hits; // none on inactive lines
+            if (vcount < 479 || vcount == 524) begin
+                finish <= 0;
+            end else begin
+                finish <= 1; // inactive lines, nothing to draw
             end
         end else if (!finish) begin
-          if (sprite_number < 16) begin //12) begin
-                // check sprite active
-                if (!checked) begin
-                    if (!checking) begin
-                        sprite_active_start <= 1;
-                        checking <= 1;
-                    end else begin
-                        sprite_active_start <= 0;
-                        if (sprite_active_finish) begin
-                            checking <= 0;
-                            checked <= 1;
-                        end
-                    end
+            if (!drawing) begin
+                if (pending == 0) begin
+                    finish <= 1;
                 end else begin
-                    // start drawing if active
-                    if (is_active) begin 
-                        if (!drawing) begin
-                            drawing <= 1;
-                            sprite_draw_start <= 1;
-                        end else begin
-                            sprite_draw_start <= 0;
-                        end         
-                        
-                        // sprite_draw_start = 0 happens in the same cycle as sprite_draw_finish = 0
-                        // need to check sprite_draw_start = 0, otherwise will detect old finish value that haven't been set to 0
-                        if (drawing && (sprite_draw_start == 0) && sprite_draw_finish) begin
-                            drawing <= 0;
-                            sprite_number <= sprite_number + 1;
-                            checked <= 0;
-                        end
-                    // skip if not active
-                    end else begin
-                        sprite_number <= sprite_number + 1;
-                        checked <= 0;
-                    end
+                    // sprite_active looks up the sprite while sprite_draw_start is high
+                    sprite_number <= next_sprite;
+                    pending[next_sprite] <= 0;
+                    sprite_draw_start <= 1;
+                    drawing <= 1;
                 end
             end else begin
-                finish <= 1;
+                sprite_draw_start <= 0;
+                // sprite_draw_start = 0 happens in the same cycle as sprite_draw_finish = 0
+                // need to check sprite_draw_start = 0, otherwise will detect old finish value that haven't been set to 0
+                if ((sprite_draw_start == 0) && sprite_draw_finish) begin
+                    drawing <= 0;
+                end
             end
         end
     end
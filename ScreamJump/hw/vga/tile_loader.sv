@@ -35,7 +35,7 @@ module tile_loader(input logic clk,
                    input logic [18:0] writedata,
                    input logic [9:0] vcount,
                    output logic [5:0] address_tile_draw, // = column of a tile
-                   output logic [255:0] data_tile_draw,
+                   output logic [127:0] data_tile_draw, // palette indices, leftmost pixel in 7:0
                    output logic finish
                    // output logic wren_tile_draw, // should I add this?
 );
@@ -44,7 +44,7 @@ module tile_rom (
 
 	input	[11:0]  address;
 	input	  clock;
-	output	[255:0]  q;
+	output	[127:0]  q;
 `ifndef ALTERA_RESERVED_QIS
 // synopsys translate_off
 `endif
@@ -53,8 +53,8 @@ module tile_rom (
 // synopsys translate_on
 `endif
 
-	wire [255:0] sub_wire0;
-	wire [255:0] q = sub_wire0[255:0];
+	wire [127:0] sub_wire0;
+	wire [127:0] q = sub_wire0[127:0];
 
 	altsyncram	altsyncram_component (
 				.address_a (address),
@@ -72,7 +72,7 @@ module tile_rom (
 				.clocken1 (1'b1),
 				.clocken2 (1'b1),
 				.clocken3 (1'b1),
-				.data_a ({256{1'b1}}),
+				.data_a ({128{1'b1}}),
 				.data_b (1'b1),
 				.eccstatus (),
 				.q_b (),
@@ -93,7 +93,7 @@ module tile_rom (
 		altsyncram_component.outdata_aclr_a = "NONE",
 		altsyncram_component.outdata_reg_a = "UNREGISTERED",
 		altsyncram_component.widthad_a = 12,
-		altsyncram_component.width_a = 256,
+		altsyncram_component.width_a = 128,
 		altsyncram_component.width_byteena_a = 1;
 
 
@@ -128,7 +128,7 @@ endmodule
 // Retrieval info: PRIVATE: SingleClock NUMERIC "1"
 // Retrieval info: PRIVATE: UseDQRAM NUMERIC "0"
 // Retrieval info: PRIVATE: WidthAddr NUMERIC "12"
-// Retrieval info: PRIVATE: WidthData NUMERIC "256"
+// Retrieval info: PRIVATE: WidthData NUMERIC "128"
 // Retrieval info: PRIVATE: rden NUMERIC "0"
 // Retrieval info: LIBRARY: altera_mf altera_mf.altera_mf_components.all
 // Retrieval info: CONSTANT: ADDRESS_ACLR_A STRING "NONE"
@@ -143,14 +143,14 @@ endmodule
 // Retrieval info: CONSTANT: OUTDATA_ACLR_A STRING "NONE"
 // Retrieval info: CONSTANT: OUTDATA_REG_A STRING "UNREGISTERED"
 // Retrieval info: CONSTANT: WIDTHAD_A NUMERIC "12"
-// Retrieval info: CONSTANT: WIDTH_A NUMERIC "256"
+// Retrieval info: CONSTANT: WIDTH_A NUMERIC "128"
 // Retrieval info: CONSTANT: WIDTH_BYTEENA_A NUMERIC "1"
 // Retrieval info: USED_PORT: address 0 0 12 0 INPUT NODEFVAL "address[11..0]"
 // Retrieval info: USED_PORT: clock 0 0 0 0 INPUT VCC "clock"
-// Retrieval info: USED_PORT: q 0 0 256 0 OUTPUT NODEFVAL "q[255..0]"
+// Retrieval info: USED_PORT: q 0 0 128 0 OUTPUT NODEFVAL "q[127..0]"
 // Retrieval info: CONNECT: @address_a 0 0 12 0 address 0 0 12 0
 // Retrieval info: CONNECT: @clock0 0 0 0 0 clock 0 0 0 0
-// Retrieval info: CONNECT: q 0 0 256 0 @q_a 0 0 256 0
+// Retrieval info: CONNECT: q 0 0 128 0 @q_a 0 0 128 0
 // Retrieval info: GEN_FILE: TYPE_NORMAL tile_rom.v TRUE
 // Retrieval info: GEN_FILE: TYPE_NORMAL tile_rom.inc FALSE
 // Retrieval info: GEN_FILE: TYPE_NORMAL tile_rom.cmp FALSE
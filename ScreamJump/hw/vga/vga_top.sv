@@ -28,10 +28,10 @@ module vga_top(input logic        clk,
 	  logic	[5:0]  address_tile_draw;
 	  logic	[9:0]  address_pixel_draw;
 
-	  logic	[255:0]  data_tile_display;
-    logic	[15:0]  data_pixel_display;
-    logic	[255:0]  data_tile_draw;
-    logic	[15:0]  data_pixel_draw;
+	  logic	[127:0]  data_tile_display; // 8-bit palette indices
+    logic	[7:0]  data_pixel_display;
+    logic	[127:0]  data_tile_draw;
+    logic	[7:0]  data_pixel_draw;
 	  
     
 	  logic	  wren_tile_display;
@@ -39,10 +39,10 @@ module vga_top(input logic        clk,
     logic	  wren_tile_draw;
 	  logic	  wren_pixel_draw;
 
-	  logic	[255:0]  q_tile_display;
-    logic	[15:0]  q_pixel_display;
-    logic	[255:0]  q_tile_draw;
-    logic	[15:0]  q_pixel_draw;
+	  logic	[127:0]  q_tile_display;
+    logic	[7:0]  q_pixel_display;
+    logic	[127:0]  q_tile_draw;
+    logic	[7:0]  q_pixel_draw;
 
     logic switch;
 
@@ -63,6 +63,7 @@ module vga_top(input logic        clk,
     //assign sprite_write = (chipselect && write && (address >= 1)); // address >= 1: write sprite
 	localparam int NUM_SPRITES = 16;
 	assign sprite_write = chipselect  && write && (address >= 1)  && (address < 1 + NUM_SPRITES);
+	localparam PALETTE = 5'd17; // w: bits 23:16 entry, 15:0 its colour (red 15:11, green 10:6, blue 5:1)
 
 
 
@@ -114,22 +115,32 @@ module vga_top(input logic        clk,
 
 
    // output
+   logic [15:0] pixel;
+
+   // the line buffer holds palette indices, looked up here a cycle after
+   // the line buffer read; a pixel lasts two cycles and is sampled at the
+   // end of its first, so the lookup fits within the pixel and only the
+   // buffer switch moves a cycle earlier. A write shows from the next
+   // pixel, so the sky swaps are best done between frames.
+   palette_ram palette(.clock(clk), .data(writedata[15:0]), .rdaddress(q_pixel_display),
+                       .wraddress(writedata[23:16]), .wren(chipselect && write && address == PALETTE), .q(pixel));
+
    always_comb begin 
       if (hcount[10:1] < 639) 
         address_pixel_display = hcount[10:1] + 1; // account for memory delay
       else
         address_pixel_display = 0; 
       
-      if(hcount == 1598 && (vcount < 479 || vcount == 524)) // 2 cycles early: 1 cycle for switch, another for reading memory
+      if(hcount == 1597 && (vcount < 479 || vcount == 524)) // 3 cycles early: 1 cycle for switch, one for reading memory, one for the palette
         switch = 1;
       else
         switch = 0;
       
-	    //{VGA_R, VGA_G, VGA_B} = {q_pixel_display[15:11]<<3, q_pixel_display[10:6]<<3, q_pixel_display[4:0]<<3};
+	    //{VGA_R, VGA_G, VGA_B} = {pixel[15:11]<<3, pixel[10:6]<<3, pixel[4:0]<<3};
       // why the one-line assignment does not work?
-      VGA_R = q_pixel_display[15:11] << 3;
-      VGA_G = q_pixel_display[10:6] << 3;
-      VGA_B = q_pixel_display[5:1] << 3;
+      VGA_R = pixel[15:11] << 3;
+      VGA_G = pixel[10:6] << 3;
+      VGA_B = pixel[5:1] << 3;
    end
 	       
 endmodule
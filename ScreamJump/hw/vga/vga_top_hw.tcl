@@ -49,8 +49,10 @@ add_fileset_file sprite_loader.sv SYSTEM_VERILOG PATH sprite_loader.sv
 add_fileset_file sprite_draw.sv SYSTEM_VERILOG PATH sprite_draw.sv
 add_fileset_file sprite_active.sv SYSTEM_VERILOG PATH sprite_active.sv
 add_fileset_file sprite_rom.v VERILOG PATH sprite_rom.v
+add_fileset_file palette_ram.v VERILOG PATH palette_ram.v
 add_fileset_file combined_sprite.mif MIF PATH combined_sprite.mif
 add_fileset_file combined_tile.mif MIF PATH combined_tile.mif
+add_fileset_file palette.mif MIF PATH palette.mif
 
 
 # 
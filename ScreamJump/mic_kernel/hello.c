@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include "mic_env.h"
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+
+int mic_env_fd;
+
+/*
+ * Print every scream the detector flags, with how long after the onset
+ * sample read() returned: the irq, the driver and the wakeup together.
+ * Then its strength, once the hold after the onset is over.
+ */
+int main(int argc, char *argv[])
+{
+  mic_env_config_t vlc = { .thresh_on = 8000, .thresh_off = 4000, .peak_decay = 6, .rms_decay = 7, .hold = 160 };
+  mic_env_state_t vls;
+  struct timespec now;
+  static const char filename[] = "/dev/mic_env";
+
+  if (argc == 3) {
+    vlc.thresh_on = atoi(argv[1]);
+    vlc.thresh_off = atoi(argv[2]);
+  } else if (argc != 1) {
+    printf("usage: hello [on-level off-level], levels 0-%d\n", MIC_ENV_FULL_SCALE);
+    return 0;
+  }
+
+  printf("mic userspace program started\n");
+
+  if ( (mic_env_fd = open(filename, O_RDWR)) == -1) {
+    fprintf(stderr, "could not open %s\n", filename);
+    return -1;
+  }
+  if (ioctl(mic_env_fd, MIC_ENV_SET_CONFIG, &vlc)) {
+      perror("ioctl(MIC_ENV_SET_CONFIG) failed");
+      return -1;
+  }
+
+  while (read(mic_env_fd, &vls, sizeof(vls)) == sizeof(vls)) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (vls.strength) {
+      printf("  strength %u, %lld us after the onset\n", vls.strength,
+             (now.tv_sec * 1000000000LL + now.tv_nsec - vls.onset_ns) / 1000);
+      continue;
+    }
+    printf("scream at sample %u: peak %u rms %u, %lld us after the onset\n",
+           vls.onset_at, vls.peak, vls.rms,
+           (now.tv_sec * 1000000000LL + now.tv_nsec - vls.onset_ns) / 1000);
+  }
+
+  printf("mic userspace program terminating\n");
+  return 0;
+}
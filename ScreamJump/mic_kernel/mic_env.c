@@ -0,0 +1,338 @@
+// adapted from vga_top.c
+
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/errno.h>
+#include <linux/version.h>
+#include <linux/kernel.h>
+#include <linux/platform_device.h>
+#include <linux/miscdevice.h>
+#include <linux/slab.h>
+#include <linux/io.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/fs.h>
+#include <linux/uaccess.h>
+#include <linux/spinlock.h>
+#include <linux/interrupt.h>
+#include <linux/of_irq.h>
+#include <linux/hrtimer.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/string.h>
+#include "mic_env.h"
+
+#define DRIVER_NAME "mic_env"
+
+/* Device registers, 32-bit words */
+#define CTRL(x) (x)
+#define STATUS(x) (x+1*4)
+#define PEAK(x) (x+2*4)
+#define RMS(x) (x+3*4)
+#define THRESH(x) (x+4*4)
+#define DECAY(x) (x+5*4)
+#define LOUDEST(x) (x+6*4)
+#define SAMPLES(x) (x+7*4)
+#define ONSET_AT(x) (x+8*4)
+#define HOLD(x) (x+9*4)
+#define STRENGTH(x) (x+10*4)
+
+#define CTRL_RUN 1
+#define CTRL_IRQ 2
+#define CTRL_RMS 4
+
+#define STATUS_LOUD 1
+#define STATUS_ONSET 2
+#define STATUS_STRENGTH 4
+
+#define SAMPLE_NS (NSEC_PER_SEC / MIC_ENV_RATE)
+
+/* Without an irq in the device tree the onset flag is polled */
+#define POLL_US 500
+
+/*
+ * Information about our device
+ */
+struct mic_env_dev {
+	struct resource res; /* Resource: our registers */
+	void __iomem *virtbase; /* Where registers can be accessed in memory */
+	spinlock_t lock; /* Guards onset and pending against the irq */
+	mic_env_state_t onset; /* The last onset or its strength, as the irq saw it */
+	bool pending; /* onset not read() yet */
+	wait_queue_head_t onset_wait; /* Woken on an onset */
+	int irq; /* onset interrupt, 0 when the timer is used */
+	u32 ctrl;
+	struct hrtimer poll_timer;
+} dev;
+
+static void read_state(mic_env_state_t *s)
+{
+	u32 status = ioread32(STATUS(dev.virtbase));
+
+	memset(s, 0, sizeof(*s));
+	s->loud = status & STATUS_LOUD;
+	s->peak = ioread32(PEAK(dev.virtbase));
+	s->rms = ioread32(RMS(dev.virtbase));
+	s->loudest = ioread32(LOUDEST(dev.virtbase));
+	s->samples = ioread32(SAMPLES(dev.virtbase));
+	s->onset_at = ioread32(ONSET_AT(dev.virtbase));
+}
+
+/*
+ * Take an onset or the strength of one from the hardware, which also drops
+ * the irq. An onset not read() yet is overwritten by its strength.
+ * False when there was neither, so a shared line is not claimed.
+ */
+static bool collect_onset(void)
+{
+	unsigned long flags;
+	ktime_t now = ktime_get();
+	u32 status = ioread32(STATUS(dev.virtbase)) & (STATUS_ONSET | STATUS_STRENGTH);
+
+	if (!status)
+		return false;
+	iowrite32(status, STATUS(dev.virtbase));
+
+	spin_lock_irqsave(&dev.lock, flags);
+	read_state(&dev.onset);
+	if (status & STATUS_STRENGTH)
+		dev.onset.strength = ioread32(STRENGTH(dev.virtbase));
+	// the samples since the onset put it that long before now
+	dev.onset.onset_ns = ktime_to_ns(now) -
+		(s64) (dev.onset.samples - dev.onset.onset_at) * SAMPLE_NS;
+	dev.pending = true;
+	spin_unlock_irqrestore(&dev.lock, flags);
+	wake_up_interruptible(&dev.onset_wait);
+	return true;
+}
+
+static irqreturn_t mic_env_irq(int irq, void *dev_id)
+{
+	return collect_onset() ? IRQ_HANDLED : IRQ_NONE;
+}
+
+static enum hrtimer_restart poll_timer_fn(struct hrtimer *t)
+{
+	collect_onset();
+	hrtimer_forward_now(t, us_to_ktime(POLL_US));
+	return HRTIMER_RESTART;
+}
+
+static int set_config(const mic_env_config_t *c)
+{
+	if (c->peak_decay > 15 || c->rms_decay > 15 ||
+	    (c->thresh_on && c->thresh_off > c->thresh_on))
+		return -EINVAL;
+
+	iowrite32(c->thresh_on | (u32) c->thresh_off << 16, THRESH(dev.virtbase));
+	iowrite32(c->peak_decay | c->rms_decay << 8, DECAY(dev.virtbase));
+	iowrite32(c->hold, HOLD(dev.virtbase));
+	dev.ctrl = (dev.ctrl & ~CTRL_RMS) | (c->use_rms ? CTRL_RMS : 0);
+	iowrite32(dev.ctrl, CTRL(dev.virtbase));
+	return 0;
+}
+
+/* read(): one mic_env_state_t per onset and strength, waiting for the next if none is pending */
+static ssize_t mic_env_read(struct file *f, char __user *buf, size_t count, loff_t *off)
+{
+	mic_env_state_t s;
+	unsigned long flags;
+	int ret;
+
+	if (count < sizeof(s))
+		return -EINVAL;
+
+	for (;;) {
+		spin_lock_irqsave(&dev.lock, flags);
+		if (dev.pending) {
+			s = dev.onset;
+			dev.pending = false;
+			spin_unlock_irqrestore(&dev.lock, flags);
+			break;
+		}
+		spin_unlock_irqrestore(&dev.lock, flags);
+		if (f->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(dev.onset_wait, READ_ONCE(dev.pending));
+		if (ret)
+			return ret;
+	}
+
+	if (copy_to_user(buf, &s, sizeof(s)))
+		return -EACCES;
+	return sizeof(s);
+}
+
+static __poll_t mic_env_poll(struct file *f, poll_table *wait)
+{
+	poll_wait(f, &dev.onset_wait, wait);
+	return READ_ONCE(dev.pending) ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+/*
+ * Handle ioctl() calls from userspace:
+ * Read the envelopes now, or tune the detector.
+ * Note extensive error checking of arguments
+ */
+static long mic_env_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
+{
+  mic_env_state_t vls;
+  mic_env_config_t vlc;
+  unsigned long flags;
+  int ret;
+	switch (cmd) {
+	  case MIC_ENV_READ:
+		  read_state(&vls);
+		  spin_lock_irqsave(&dev.lock, flags);
+		  vls.onset_ns = dev.onset.onset_ns;
+		  spin_unlock_irqrestore(&dev.lock, flags);
+		  if (copy_to_user((mic_env_state_t *) arg, &vls, sizeof(mic_env_state_t)))
+			  return -EACCES;
+		  break;
+	  case MIC_ENV_SET_CONFIG:
+		  if (copy_from_user(&vlc, (mic_env_config_t *) arg, sizeof(mic_env_config_t)))
+			  return -EACCES;
+		  ret = set_config(&vlc);
+		  if (ret)
+			  return ret;
+		  break;
+	  default:
+		  return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* The operations our device knows how to do */
+static const struct file_operations fops = {
+	.owner		= THIS_MODULE,
+	.read		= mic_env_read,
+	.poll		= mic_env_poll,
+	.unlocked_ioctl = mic_env_ioctl,
+};
+
+/* Information about our device for the "misc" framework -- like a char dev */
+static struct miscdevice misc_device = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= DRIVER_NAME,
+	.fops		= &fops,
+};
+
+/*
+ * Initialization code: get resources (registers), start taking samples
+ * and listen for onsets
+ */
+static int __init probe(struct platform_device *pdev)
+{
+	int ret;
+
+	spin_lock_init(&dev.lock);
+	init_waitqueue_head(&dev.onset_wait);
+	hrtimer_init(&dev.poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dev.poll_timer.function = poll_timer_fn;
+
+	/* Get the address of our registers from the device tree */
+	ret = of_address_to_resource(pdev->dev.of_node, 0, &dev.res);
+	if (ret)
+		return -ENOENT;
+
+	/* Make sure we can use these registers */
+	if (request_mem_region(dev.res.start, resource_size(&dev.res),
+			       DRIVER_NAME) == NULL)
+		return -EBUSY;
+
+	/* Arrange access to our registers */
+	dev.virtbase = of_iomap(pdev->dev.of_node, 0);
+	if (dev.virtbase == NULL) {
+		ret = -ENOMEM;
+		goto out_release_mem_region;
+	}
+
+	/* Drop whatever was flagged before we were here */
+	iowrite32(STATUS_ONSET | STATUS_STRENGTH, STATUS(dev.virtbase));
+	dev.ctrl = CTRL_RUN;
+	dev.irq = irq_of_parse_and_map(pdev->dev.of_node, 0);
+	if (dev.irq > 0) {
+		ret = request_irq(dev.irq, mic_env_irq, 0, DRIVER_NAME, &dev);
+		if (ret)
+			goto out_unmap;
+		dev.ctrl |= CTRL_IRQ;
+	} else {
+		dev.irq = 0;
+		pr_info(DRIVER_NAME ": no irq, polling every %d us\n", POLL_US);
+		hrtimer_start(&dev.poll_timer, us_to_ktime(POLL_US), HRTIMER_MODE_REL);
+	}
+	iowrite32(dev.ctrl, CTRL(dev.virtbase));
+
+	/* Last, once read() and poll() have registers to work with: creates /dev/mic_env */
+	ret = misc_register(&misc_device);
+	if (ret)
+		goto out_stop;
+
+	return 0;
+
+out_stop:
+	iowrite32(0, CTRL(dev.virtbase));
+	if (dev.irq)
+		free_irq(dev.irq, &dev);
+	else
+		hrtimer_cancel(&dev.poll_timer);
+out_unmap:
+	iounmap(dev.virtbase);
+out_release_mem_region:
+	release_mem_region(dev.res.start, resource_size(&dev.res));
+	return ret;
+}
+
+/* Clean-up code: release resources */
+static int mic_env_remove(struct platform_device *pdev)
+{
+	iowrite32(0, CTRL(dev.virtbase));
+	if (dev.irq)
+		free_irq(dev.irq, &dev);
+	else
+		hrtimer_cancel(&dev.poll_timer);
+	iounmap(dev.virtbase);
+	release_mem_region(dev.res.start, resource_size(&dev.res));
+	misc_deregister(&misc_device);
+	return 0;
+}
+
+/* Which "compatible" string(s) to search for in the Device Tree */
+#ifdef CONFIG_OF
+static const struct of_device_id device_of_match[] = {
+	{ .compatible = "csee4840,mic_env-1.0" },
+	{},
+};
+MODULE_DEVICE_TABLE(of, device_of_match);
+#endif
+
+/* Information for registering ourselves as a "platform" driver */
+static struct platform_driver driver = {
+	.driver	= {
+		.name	= DRIVER_NAME,
+		.owner	= THIS_MODULE,
+		.of_match_table = of_match_ptr(device_of_match),
+	},
+	.remove	= __exit_p(mic_env_remove),
+};
+
+/* Called when the module is loaded: set things up */
+static int __init mic_env_init(void)
+{
+	pr_info(DRIVER_NAME ": init\n");
+	return platform_driver_probe(&driver, probe);
+}
+
+/* Called when the module is unloaded: release resources */
+static void __exit mic_env_exit(void)
+{
+	platform_driver_unregister(&driver);
+	pr_info(DRIVER_NAME ": exit\n");
+}
+
+module_init(mic_env_init);
+module_exit(mic_env_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("mic_env driver");
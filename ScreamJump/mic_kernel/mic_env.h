@@ -0,0 +1,45 @@
+#ifndef _MIC_ENV_H
+#define _MIC_ENV_H
+
+#include <linux/ioctl.h>
+
+/*
+ * The hardware follows the microphone's loudness at MIC_ENV_RATE samples
+ * a second and flags an onset the moment it crosses the on threshold,
+ * then again once the hold after it is over and its strength is known.
+ * read() on /dev/mic_env blocks until the next of these and returns a
+ * mic_env_state_t of that moment, strength 0 for an onset; poll()
+ * reports POLLIN while one waits.
+ */
+#define MIC_ENV_RATE 8000
+#define MIC_ENV_FULL_SCALE 32767 // loudest peak or rms
+
+// def of argument for reading the detector
+typedef struct {
+  unsigned char loud;      // over the threshold now
+  unsigned short peak;     // peak envelope
+  unsigned short rms;      // rms envelope
+  unsigned short loudest;  // loudest envelope since the onset so far
+  unsigned short strength; // loudest envelope over the hold after the onset, how hard the scream was; 0 until the hold is over
+  unsigned int samples;    // samples taken so far
+  unsigned int onset_at;   // samples when the last onset happened
+  long long onset_ns;      // CLOCK_MONOTONIC time of that sample, 0 before the first
+} mic_env_state_t;
+
+// def of argument for tuning the detector
+typedef struct {
+  unsigned short thresh_on;  // envelope level that starts a scream, 0 turns detection off
+  unsigned short thresh_off; // level it has to fall under before the next one
+  unsigned char peak_decay;  // peak falls by 1/2^n a sample, 0-15
+  unsigned char rms_decay;   // rms averages about 2^n samples, 0-15
+  unsigned char use_rms;     // detect on rms, steadier but slower, rather than peak
+  unsigned short hold;       // samples after an onset its strength is taken over, 0 for the onset's own level
+} mic_env_config_t;
+
+#define MIC_ENV_MAGIC 'm'
+
+/* ioctls and their arguments */
+#define MIC_ENV_READ _IOR(MIC_ENV_MAGIC, 1, mic_env_state_t *)
+#define MIC_ENV_SET_CONFIG _IOW(MIC_ENV_MAGIC, 2, mic_env_config_t *)
+
+#endif
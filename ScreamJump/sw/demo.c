@@ -15,6 +15,8 @@
 
 #include "usbcontroller.h"
 #include "vga_interface.h"
+#include "mic_env.h"
+#include "scream.h"
 
 // Screen and physics
 #define SCR_W              640   // VGA width
@@ -43,6 +45,8 @@
 // Game settings
 #define INIT_LIVES         5
 #define JUMP_VEL           -20   // Initial jump velocity Y
+#define SCREAM_VEL_MIN     -14   // Jump velocity Y of a scream just over the threshold
+#define SCREAM_VEL_MAX     -26   // ... and of one at full scale
 #define BASE_JUMP_DELAY    2000  // us
 #define LONG_JUMP_DELAY    4000  // us
 #define PTS_PER_LVL        10
@@ -81,6 +85,8 @@
 int vga_fd;
 //int g_audio_fd;
 struct controller_output_packet g_ctrl_state;
+volatile int g_jump_strength = 0; // Loudest level of a scream not jumped on yet, 0 for none
+volatile long long g_jump_stamp_ns = 0; // When that scream was heard
 bool g_tower_on = true;
 int  g_coins_total = 0;
 bool g_do_restart = true;
@@ -115,6 +121,7 @@ void draw_bars_buffered(Bar bars_a[], Bar bars_b[], int size);
 void move_bars(Bar bars_a[], Bar bars_b[], int size, int speed);
 bool check_bar_collision(Bar bars[], int grp_id, int size, int prev_y_ckn, Chicken *ckn, int *score, bool *landed);
 void *ctrl_thread(void *arg);
+void *mic_thread(void *arg);
 void init_ckn(Chicken *c);
 void move_ckn(Chicken *c);
 void update_sun_moon_sprite(int current_level);
@@ -244,6 +251,31 @@ void *ctrl_thread(void *arg) {
     pthread_exit(NULL);
 }
 
+// Waits on the microphone detector and posts each scream for the game loop,
+// once the hold after its onset is over and how loud it got is known
+void *mic_thread(void *arg) {
+    mic_env_state_t st;
+    int mic_fd = open("/dev/mic_env", O_RDWR);
+    if (mic_fd < 0) {
+        perror("Mic thread: /dev/mic_env"); // Gamepad only
+        pthread_exit(NULL);
+    }
+
+    while (g_do_restart) {
+        if (read(mic_fd, &st, sizeof(st)) != sizeof(st)) {
+            perror("Mic thread: read");
+            break;
+        }
+        if (st.strength == 0)
+            continue; // The onset; its strength follows
+        g_jump_stamp_ns = st.onset_ns;
+        __sync_synchronize(); // The stamp is there before the strength
+        g_jump_strength = st.strength;
+    }
+    close(mic_fd);
+    pthread_exit(NULL);
+}
+
 void init_ckn(Chicken *c) {
     c->x = 32; c->y = CKN_TOWER_Y; c->vy = 0; c->jumping = false;
     c->coin_idx = -1; c->coin_timer_us = 0;
@@ -410,7 +442,9 @@ void reset_for_death(Chicken *c, Bar bA[], Bar bB[], bool *tower_on,
 }
 
 
-int main(void) {
+// demo [source]: screams come from the mic_env block, or with a source from
+// the software detector (an ALSA device, a WAV file, or - for stdin)
+int main(int argc, char *argv[]) {
     // Static vars for bar Y positions, persist across deaths, reset on new game.
     static int s_last_y_a = L12_BAR_Y_A;
     static int s_last_y_b = L12_BAR_Y_B;
@@ -426,6 +460,12 @@ int main(void) {
     if (pthread_create(&ctrl_tid, NULL, ctrl_thread, NULL) != 0) {
         perror("Ctrl thread create"); close(vga_fd); return -1;
     }
+    pthread_t mic_tid;
+    if (argc > 1 && scream_start(argv[1]) == 0) {
+        printf("Listening for screams on %s\n", argv[1]);
+    } else if (pthread_create(&mic_tid, NULL, mic_thread, NULL) != 0) {
+        perror("Mic thread create"); // Play on with the gamepad
+    }
 
 game_restart_point: // Label for full game restart
     score = 0;
@@ -513,9 +553,16 @@ game_restart_point: // Label for full game restart
 
         update_grass_scroll(bar_speed); // Scroll grass based on effective bar speed
 
-        // Handle jump input
-        if (g_ctrl_state.b && !ckn.jumping) {
-            ckn.vy = jump_vy; ckn.jumping = true;
+        // Handle jump input: B, or a scream that jumps as high as it was loud
+        // Taken and cleared in one step, so a scream stored in between is not lost;
+        // one mid-air is not saved for landing. Acquire: its stamp is read after it.
+        int scream = __atomic_exchange_n(&g_jump_strength, 0, __ATOMIC_ACQUIRE);
+        long long scream_stamp_ns = g_jump_stamp_ns;
+        if ((g_ctrl_state.b || scream) && !ckn.jumping) {
+            ckn.vy = scream ? SCREAM_VEL_MIN + (SCREAM_VEL_MAX - SCREAM_VEL_MIN) * scream / MIC_ENV_FULL_SCALE
+                            : jump_vy;
+            ckn.jumping = true;
+            if (scream) report_jump_latency(scream_stamp_ns);
             landed_jump = false; g_tower_on = false; // play_sfx(0);
             if(ckn.coin_idx != -1) { 
                 ckn.coin_timer_us = 0; ckn.coin_idx = -1;
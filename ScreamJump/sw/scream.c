@@ -0,0 +1,324 @@
+// scream.c
+// Software scream detector for ScreamJump.
+// A capture thread reads SCREAM_PERIOD frames at a time from ALSA (built
+// with HAVE_ALSA), or from a WAV file or pipe standing in for it, into a lock-free ring. A detector
+// thread takes each period and works out its RMS. At an onset the level is
+// still rising, so it keeps the loudest RMS over the next SCREAM_HOLD
+// periods, or until the scream ends, and then posts that to
+// g_jump_strength for the game loop, the same way mic_thread does for the
+// hardware detector.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#ifdef HAVE_ALSA
+#include <alsa/asoundlib.h>
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "scream.h"
+#include "mic_env.h"
+
+// Detector settings, RMS levels of 16-bit samples
+#define SCREAM_ON_LEVEL    5600  // RMS that starts a scream
+#define SCREAM_OFF_LEVEL   2800  // RMS it has to fall under before the next one
+#define SCREAM_OVER_FLOOR  4     // ... and it has to be this many times the background noise
+#define SCREAM_HOLD        5     // Periods after the onset its strength is taken over, 20 ms
+#define FLOOR_SHIFT        6     // Noise floor follows quiet periods over 2^6 periods, ~256 ms
+#define REPORT_PERIODS     2500  // Print capture stats every 10 s
+
+#define RING_PERIODS       16    // 64 ms of slack between capture and detection
+
+typedef struct {
+    int16_t pcm[SCREAM_PERIOD];
+    long long stamp_ns; // When the last frame of the period was read
+} Period;
+
+// Single producer (capture), single consumer (detector); the indices only
+// grow, and the semaphore only wakes the detector, it guards nothing
+static Period ring[RING_PERIODS];
+static atomic_uint ring_head; // Periods written
+static atomic_uint ring_tail; // Periods read
+static sem_t ring_ready;
+static atomic_uint ring_overruns;
+
+// The capture source: ALSA, or a file or pipe with a header already read
+#ifdef HAVE_ALSA
+static snd_pcm_t *pcm_dev;
+#endif
+static FILE *pcm_file;
+static bool pcm_file_paced;   // Play the file in real time, a pipe paces itself
+static unsigned int pcm_rate = SCREAM_RATE;
+static unsigned int pcm_channels = 1;
+static pthread_t capture_tid;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Sum of squares of a period; NEON squares eight samples at a time
+static long long period_energy(const int16_t *pcm) {
+#ifdef __ARM_NEON
+    int64x2_t acc = vdupq_n_s64(0);
+    for (int i = 0; i < SCREAM_PERIOD; i += 8) {
+        int16x8_t x = vld1q_s16(pcm + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(x)));
+    }
+    return vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+#else
+    long long sum = 0;
+    for (int i = 0; i < SCREAM_PERIOD; i++)
+        sum += (int) pcm[i] * pcm[i];
+    return sum;
+#endif
+}
+
+// Read one period of mono frames from the source; false at its end
+static bool read_period(int16_t *out) {
+    int16_t frames[SCREAM_PERIOD * 2];
+
+#ifdef HAVE_ALSA
+    if (pcm_dev) {
+        snd_pcm_sframes_t n = snd_pcm_readi(pcm_dev, out, SCREAM_PERIOD);
+        while (n < 0) {
+            if (snd_pcm_recover(pcm_dev, n, 1) < 0) {
+                fprintf(stderr, "Scream: capture error: %s\n", snd_strerror(n));
+                return false;
+            }
+            atomic_fetch_add(&ring_overruns, 1);
+            n = snd_pcm_readi(pcm_dev, out, SCREAM_PERIOD);
+        }
+        if (n < SCREAM_PERIOD)
+            memset(out + n, 0, (SCREAM_PERIOD - n) * sizeof(int16_t));
+        return true;
+    }
+#endif
+
+    if (fread(frames, sizeof(int16_t) * pcm_channels, SCREAM_PERIOD, pcm_file) != SCREAM_PERIOD)
+        return false;
+    for (int i = 0; i < SCREAM_PERIOD; i++)
+        out[i] = frames[i * pcm_channels]; // Left channel of a stereo file
+    return true;
+}
+
+static void *capture_thread(void *arg) {
+    struct timespec due;
+    long long period_ns = 1000000000LL * SCREAM_PERIOD / pcm_rate;
+    clock_gettime(CLOCK_MONOTONIC, &due);
+
+    for (;;) {
+        unsigned int head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+        Period *p = &ring[head % RING_PERIODS];
+        int16_t scratch[SCREAM_PERIOD];
+        bool full = head - tail == RING_PERIODS;
+
+        // A full ring drops the new period rather than block the capture
+        if (!read_period(full ? scratch : p->pcm))
+            break;
+        if (pcm_file_paced) { // As fast as the sound card would deliver it
+            due.tv_nsec += period_ns;
+            while (due.tv_nsec >= 1000000000L) { due.tv_nsec -= 1000000000L; due.tv_sec++; }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        }
+        if (full) {
+            atomic_fetch_add(&ring_overruns, 1);
+            continue;
+        }
+        p->stamp_ns = now_ns();
+        atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+        sem_post(&ring_ready);
+    }
+
+    printf("Scream: capture source ended\n");
+    pthread_exit(NULL);
+}
+
+static void *detect_thread(void *arg) {
+    bool loud = false;
+    int holding = 0;         // Periods of the hold left, 0 once the strength is posted
+    double loudest_rms = 0;  // Over the hold so far
+    long long onset_ns = 0;
+    double floor_rms = 0;
+    unsigned int periods = 0;
+    long long detect_ns_total = 0, detect_ns_max = 0;
+    long long report_ns = now_ns();
+    clockid_t capture_clock, detect_clock;
+    struct timespec ts;
+    double capture_cpu0 = 0, detect_cpu0 = 0;
+
+    pthread_getcpuclockid(capture_tid, &capture_clock);
+    pthread_getcpuclockid(pthread_self(), &detect_clock);
+
+    for (;;) {
+        if (sem_wait(&ring_ready) != 0)
+            continue; // Interrupted
+        unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+        Period *p = &ring[tail % RING_PERIODS];
+        double rms = sqrt((double) period_energy(p->pcm) / SCREAM_PERIOD);
+        long long stamp_ns = p->stamp_ns;
+        atomic_store_explicit(&ring_tail, tail + 1, memory_order_release);
+
+        if (!loud && rms >= SCREAM_ON_LEVEL && rms >= floor_rms * SCREAM_OVER_FLOOR) {
+            loud = true;
+            holding = SCREAM_HOLD;
+            loudest_rms = rms;
+            onset_ns = stamp_ns;
+        } else if (loud) {
+            if (rms < SCREAM_OFF_LEVEL)
+                loud = false;
+            if (holding && rms > loudest_rms)
+                loudest_rms = rms;
+            if (holding && (--holding == 0 || !loud)) {
+                // Peak of a sine with this RMS, the scale mic_env reports in
+                int strength = loudest_rms * M_SQRT2 > MIC_ENV_FULL_SCALE ? MIC_ENV_FULL_SCALE
+                                                                            : (int) (loudest_rms * M_SQRT2);
+                holding = 0;
+                g_jump_stamp_ns = onset_ns;
+                __sync_synchronize(); // The stamp is there before the strength
+                g_jump_strength = strength;
+            }
+        }
+        if (!loud)
+            floor_rms += (rms - floor_rms) / (1 << FLOOR_SHIFT);
+
+        long long detect_ns = now_ns() - stamp_ns;
+        detect_ns_total += detect_ns;
+        if (detect_ns > detect_ns_max) detect_ns_max = detect_ns;
+
+        if (++periods == REPORT_PERIODS) {
+            long long t = now_ns();
+            double wall = (t - report_ns) / 1e9;
+            clock_gettime(capture_clock, &ts);
+            double capture_cpu = ts.tv_sec + ts.tv_nsec / 1e9;
+            clock_gettime(detect_clock, &ts);
+            double detect_cpu = ts.tv_sec + ts.tv_nsec / 1e9;
+            printf("Scream: %u periods, %u dropped, capture to detect avg %lld us max %lld us, "
+                   "CPU capture %.2f%% detect %.2f%%, noise floor %.0f\n",
+                   periods, atomic_exchange(&ring_overruns, 0),
+                   detect_ns_total / periods / 1000, detect_ns_max / 1000,
+                   100 * (capture_cpu - capture_cpu0) / wall, 100 * (detect_cpu - detect_cpu0) / wall,
+                   floor_rms);
+            capture_cpu0 = capture_cpu; detect_cpu0 = detect_cpu;
+            report_ns = t;
+            periods = 0; detect_ns_total = 0; detect_ns_max = 0;
+        }
+    }
+    return NULL;
+}
+
+#ifdef HAVE_ALSA
+static int open_alsa(const char *name) {
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_uframes_t period = SCREAM_PERIOD, buffer = SCREAM_PERIOD * 4;
+    int err;
+
+    if ((err = snd_pcm_open(&pcm_dev, name, SND_PCM_STREAM_CAPTURE, 0)) < 0) {
+        fprintf(stderr, "Scream: %s: %s\n", name, snd_strerror(err));
+        return -1;
+    }
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_hw_params_any(pcm_dev, hw);
+    if ((err = snd_pcm_hw_params_set_access(pcm_dev, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+        (err = snd_pcm_hw_params_set_format(pcm_dev, hw, SND_PCM_FORMAT_S16_LE)) < 0 ||
+        (err = snd_pcm_hw_params_set_channels(pcm_dev, hw, 1)) < 0 ||
+        (err = snd_pcm_hw_params_set_rate_near(pcm_dev, hw, &pcm_rate, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_period_size_near(pcm_dev, hw, &period, NULL)) < 0 ||
+        (err = snd_pcm_hw_params_set_buffer_size_near(pcm_dev, hw, &buffer)) < 0 ||
+        (err = snd_pcm_hw_params(pcm_dev, hw)) < 0) {
+        fprintf(stderr, "Scream: %s: mono 16-bit capture: %s\n", name, snd_strerror(err));
+        snd_pcm_close(pcm_dev);
+        pcm_dev = NULL;
+        return -1;
+    }
+    printf("Scream: %s at %u Hz, %lu-frame periods\n", name, pcm_rate, (unsigned long) period);
+    return 0;
+}
+#else
+static int open_alsa(const char *name) {
+    fprintf(stderr, "Scream: %s: built without ALSA, only a .wav file or - for stdin\n", name);
+    return -1;
+}
+#endif
+
+static unsigned int le32(const unsigned char *b) { return b[0] | b[1] << 8 | b[2] << 16 | (unsigned int) b[3] << 24; }
+static unsigned int le16(const unsigned char *b) { return b[0] | b[1] << 8; }
+
+// Leaves pcm_file at the first sample of a 16-bit PCM WAV
+static int open_wav(const char *path) {
+    unsigned char hdr[16];
+    bool have_fmt = false;
+
+    if ((pcm_file = fopen(path, "rb")) == NULL) { perror(path); return -1; }
+    if (fread(hdr, 1, 12, pcm_file) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4))
+        goto bad;
+    while (fread(hdr, 1, 8, pcm_file) == 8) {
+        unsigned int size = le32(hdr + 4);
+        if (!memcmp(hdr, "fmt ", 4) && size >= 16) {
+            if (fread(hdr, 1, 16, pcm_file) != 16 || le16(hdr) != 1 || le16(hdr + 14) != 16)
+                goto bad;
+            pcm_channels = le16(hdr + 2);
+            pcm_rate = le32(hdr + 4);
+            have_fmt = pcm_channels == 1 || pcm_channels == 2;
+            fseek(pcm_file, size - 16 + (size & 1), SEEK_CUR);
+        } else if (!memcmp(hdr, "data", 4) && have_fmt) {
+            pcm_file_paced = true;
+            printf("Scream: %s at %u Hz, %u channel(s)\n", path, pcm_rate, pcm_channels);
+            return 0;
+        } else {
+            fseek(pcm_file, size + (size & 1), SEEK_CUR);
+        }
+    }
+bad:
+    fprintf(stderr, "Scream: %s is not a 16-bit PCM WAV\n", path);
+    fclose(pcm_file);
+    pcm_file = NULL;
+    return -1;
+}
+
+int scream_start(const char *source) {
+    pthread_t detect_tid;
+    size_t len = strlen(source);
+
+    if (!strcmp(source, "-")) {
+        pcm_file = stdin;
+    } else if (len > 4 && !strcasecmp(source + len - 4, ".wav")) {
+        if (open_wav(source)) return -1;
+    } else if (open_alsa(source)) {
+        return -1;
+    }
+
+    sem_init(&ring_ready, 0, 0);
+    if (pthread_create(&capture_tid, NULL, capture_thread, NULL) != 0 ||
+        pthread_create(&detect_tid, NULL, detect_thread, NULL) != 0) {
+        perror("Scream thread create");
+        return -1;
+    }
+    return 0;
+}
+
+void report_jump_latency(long long stamp_ns) {
+    static long long total_us, max_us;
+    static unsigned int jumps;
+    long long us = (now_ns() - stamp_ns) / 1000;
+
+    if (stamp_ns == 0) return;
+    jumps++;
+    total_us += us;
+    if (us > max_us) max_us = us;
+    printf("Scream jump: %lld us from capture to jump (avg %lld, max %lld over %u)\n",
+           us, total_us / jumps, max_us, jumps);
+}
@@ -0,0 +1,24 @@
+// scream.h
+// Software scream detector, the CPU-side alternative to the mic_env block.
+
+#ifndef SCREAM_H
+#define SCREAM_H
+
+#define SCREAM_RATE   16000 // Capture rate, Hz
+#define SCREAM_PERIOD 64    // Frames per capture period, 4 ms at SCREAM_RATE
+
+// Posted by either detector, taken by the game loop (defined in demo.c)
+extern volatile int g_jump_strength;      // Loudness of a scream not jumped on yet, 0 for none
+extern volatile long long g_jump_stamp_ns; // CLOCK_MONOTONIC time the scream was captured
+
+// Start detecting screams from source: an ALSA capture device ("default",
+// "hw:1,0"), a 16-bit WAV file played in real time, or "-" for raw
+// S16_LE mono at SCREAM_RATE on stdin, e.g. piped from arecord. ALSA
+// needs the game built with HAVE_ALSA (the Makefile's ALSA=1).
+// Returns 0, or -1 if the source cannot be opened.
+int scream_start(const char *source);
+
+// Print how long the scream the game just jumped on took from capture
+void report_jump_latency(long long stamp_ns);
+
+#endif
@@ -0,0 +1,67 @@
+/* Sky palettes matching combined_tile.mif, generated by pack_art */
+#ifndef _SKY_PALETTE_H
+#define _SKY_PALETTE_H
+
+#define SKY_PALETTE_FIRST 128 /* entries the sky and star tiles are drawn with */
+#define SKY_PALETTE_ENTRIES 128
+
+enum { SKY_DAY, SKY_EVENING, SKY_NIGHT, SKIES };
+
+static const unsigned short sky_palette[SKIES][SKY_PALETTE_ENTRIES] = {
+  { /* day */
+    0xc1b0, 0xf7c6, 0x1d64, 0xf7c6, 0xfc30, 0x69a2, 0xfbf6, 0x9442,
+    0xf7e6, 0x2d96, 0xf7c6, 0x1974, 0x2d18, 0xe4b2, 0xf2c6, 0xfbf6,
+    0xd344, 0x9872, 0xf7c6, 0xfc30, 0xf7c6, 0xfc12, 0x1974, 0xf2c6,
+    0x9c48, 0xfcb0, 0x3dea, 0xfbf6, 0x946c, 0x1d64, 0x6992, 0xfcec,
+    0xe892, 0x1974, 0xf6e6, 0xf7c6, 0xf7c6, 0x1d44, 0x2890, 0xe492,
+    0xfcae, 0x699a, 0xf7c6, 0xf7c6, 0x3dc2, 0xf7e6, 0xf2c6, 0xfc5e,
+    0xf70c, 0x9c62, 0xfc58, 0x9872, 0xfce8, 0xf30c, 0xfd22, 0xfd62,
+    0x34ea, 0xe4b2, 0xc346, 0xfc6c, 0xfcac, 0xf7c6, 0xf7c6, 0xf3f6,
+    0x9c62, 0x6992, 0x9c4e, 0x1974, 0x9442, 0x9c62, 0xfcc6, 0xf476,
+    0xf36e, 0x35d4, 0xfd5a, 0xf7c6, 0xfd26, 0xfc6e, 0xf474, 0xfcea,
+    0xfc2e, 0x1d64, 0xf7c6, 0xfc0c, 0xf2c6, 0x9872, 0x69a2, 0xfce6,
+    0xf7c6, 0xfc6a, 0xfc4e, 0xf7c6, 0xfcaa, 0xf7c6, 0xf7c6, 0x33f4,
+    0xcd30, 0x2d8e, 0xfc4e, 0xe892, 0xfbd6, 0x9872, 0xf7e6, 0x9872,
+    0xfcc6, 0xfc96, 0xf7c6, 0xeb8e, 0x1d64, 0xe4a2, 0xe492, 0xf7c6,
+    0xfcde, 0xf6c6, 0xfdd6, 0x699e, 0xfcea, 0xfdd6, 0xfbc6, 0xfc30,
+    0xfbd6, 0xfbc6, 0x9872, 0xf3c6, 0xfbe6, 0xf3f6, 0x9c52, 0xfd24,
+  },
+  { /* evening */
+    0x4036, 0xf7d2, 0xe832, 0xf348, 0xfdb2, 0x2836, 0xf7d0, 0x3d86,
+    0xf7d4, 0xcca0, 0xf374, 0xe4b6, 0xcbe2, 0x2800, 0xfb86, 0xf382,
+    0xdc24, 0x3da4, 0xf794, 0xfc70, 0xfb82, 0xf762, 0xe4b2, 0xfdb2,
+    0x3b64, 0xf792, 0xba4c, 0xf282, 0x3d06, 0xe832, 0x2812, 0xf328,
+    0x2936, 0xe4b6, 0xf7d4, 0xfdb4, 0xfbea, 0xe406, 0xc136, 0x2800,
+    0xf746, 0x2834, 0xfdb4, 0xf304, 0xbca6, 0xf382, 0xf382, 0xfb74,
+    0xf7a4, 0x3b60, 0xf7d6, 0xbca0, 0xf388, 0xf6a8, 0xfbaa, 0xf79a,
+    0xba56, 0x4088, 0xcae0, 0xf344, 0xfb62, 0xf7a0, 0xf7e0, 0xf7e0,
+    0xe832, 0x2812, 0x3c04, 0xe4b6, 0x3372, 0xe832, 0xf78c, 0xf7d8,
+    0xfdb4, 0xbca0, 0xf382, 0xf35a, 0xf78a, 0xfb84, 0xf7d8, 0xfb6a,
+    0xf384, 0xe832, 0xfb46, 0xf384, 0xf7e0, 0xbca0, 0x2836, 0xf70e,
+    0xfcb2, 0xfdb2, 0xf78c, 0xfbea, 0xfb4c, 0xf360, 0xf3ae, 0xba60,
+    0x4b60, 0xcc4c, 0xf7d0, 0x2936, 0xf7d6, 0x3da4, 0xf382, 0x3386,
+    0xfb72, 0xf360, 0xf746, 0xec70, 0xe832, 0x2824, 0x2800, 0xf79c,
+    0xf78a, 0xfb58, 0xfb8c, 0x2836, 0xf74a, 0xf666, 0xf382, 0xfc32,
+    0xf7d0, 0xfdb2, 0x3386, 0xf7d4, 0xfb5a, 0xfb66, 0x3b46, 0xfb5e,
+  },
+  { /* night */
+    0x0000, 0xd6f6, 0xd746, 0x0000, 0xc936, 0xc936, 0x2480, 0x4924,
+    0x0136, 0x0000, 0xc812, 0x9eee, 0xc936, 0x0022, 0xc936, 0xb7f6,
+    0x2522, 0x48aa, 0x36c0, 0x0000, 0xcc92, 0x0000, 0xc812, 0xedb6,
+    0x1000, 0xde12, 0xa492, 0x0124, 0x0000, 0x714a, 0x4924, 0xec92,
+    0xc812, 0x0040, 0x0000, 0x954c, 0x0000, 0xa5b6, 0x0000, 0x0800,
+    0x92b6, 0xa492, 0x9376, 0x559e, 0xa492, 0x7ec0, 0x0a5c, 0x76e4,
+    0xd50e, 0x8136, 0x6d22, 0x0000, 0xbb50, 0x8ab6, 0x4400, 0x46c0,
+    0x0000, 0x0000, 0x0000, 0x0000, 0xccf6, 0x4662, 0x4924, 0x9252,
+    0x0000, 0x0000, 0x0000, 0x5b64, 0x4924, 0xa492, 0x8a76, 0x3522,
+    0xa894, 0x2480, 0xa5f6, 0x5224, 0xd5b6, 0x3480, 0x0800, 0x2be4,
+    0x54e4, 0x9272, 0x4540, 0x0800, 0x37e4, 0x8022, 0x4924, 0x7fdc,
+    0x0124, 0xb40e, 0xec92, 0x4480, 0x9a76, 0x7daa, 0xcc92, 0xc812,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x5a40, 0x0000, 0x1880, 0x0000,
+    0xb7f6, 0xc936, 0xb6d2, 0x0000, 0x0000, 0x2800, 0x0124, 0x0000,
+    0x24e0, 0xc376, 0x135c, 0x0000, 0x0000, 0x7fe4, 0xec92, 0xbdb6,
+    0xb7f6, 0x2480, 0x4924, 0x4924, 0x34e4, 0xc916, 0x0124, 0x0000,
+  },
+};
+
+#endif
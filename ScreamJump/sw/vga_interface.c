@@ -1,6 +1,7 @@
 //LAST WORKING REVERT 2.3 of A
 #include "vga_top.h"      
 #include "vga_interface.h" 
+#include "sky_palette.h"
 #include <stdio.h>         
 #include <sys/ioctl.h>     
 #include <sys/types.h>     
@@ -29,6 +30,11 @@ static SpriteHWState actual_hw_sprites[MAX_HARDWARE_SPRITES];
 static int grass_pixel_scroll_accumulator = 0;
 static int grass_current_tile_shift = 0; // How many full tiles the grass pattern has shifted
 
+// The sky is the same tiles by day, evening and night; only the palette
+// entries they are drawn with change. Stars are picked once, at init.
+static unsigned char sky_layout[GRASS_ROW_START][TILE_COLS];
+static int current_sky = -1; // SKY_DAY etc. in the palette, -1 if not known
+
 
 static void vga_hardware_write_tile(unsigned char r, unsigned char c, unsigned char n) {
     if (r >= TILE_ROWS || c >= TILE_COLS) return;
@@ -43,6 +49,19 @@ static void vga_hardware_write_tile(unsigned char r, unsigned char c, unsigned c
     shadow_hardware_map[r][c] = n;
 }
 
+static void vga_hardware_set_sky(int sky) {
+    if (sky == current_sky) return;
+
+    vga_top_arg_palette vla;
+    vla.colours = (unsigned short *) sky_palette[sky];
+    vla.first = SKY_PALETTE_FIRST; vla.count = SKY_PALETTE_ENTRIES;
+    if (ioctl(vga_fd, VGA_TOP_WRITE_PALETTE, &vla)) {
+        perror("ioctl(VGA_TOP_WRITE_PALETTE) failed in vga_hardware_set_sky");
+        return;
+    }
+    current_sky = sky;
+}
+
 static void vga_hardware_write_sprite(unsigned char active, unsigned short r, unsigned short c, unsigned char n, unsigned short register_n) {
   if (register_n >= MAX_HARDWARE_SPRITES) return;
   
@@ -80,6 +99,15 @@ void init_vga_interface(void) {
     }
     grass_pixel_scroll_accumulator = 0; // Initialize grass scroll variables
     grass_current_tile_shift = 0;
+
+    // about one sky tile in six is plain at night, the rest have stars
+    for (int r = 0; r < GRASS_ROW_START; r++) {
+        for (int c = 0; c < TILE_COLS; c++) {
+            sky_layout[r][c] = (rand() % 6 == 0) ? SKY_TILE_IDX : STAR_TILE_IDX;
+        }
+    }
+    current_sky = -1;
+    vga_hardware_set_sky(SKY_DAY);
     vga_initialized = true;
 }
 
@@ -218,8 +246,9 @@ void update_grass_scroll(int scroll_speed_px) {
 
 
 // MODIFICATION: Fills the sky and randomly distributes three types of grass tiles,
-// taking into account the current scroll offset.
-void fill_sky_and_grass(void) {
+// taking into account the current scroll offset. The sky tiles are the same
+// for every sky; sky picks the palette they are drawn with.
+static void fill_sky_tiles_and_grass(int sky) {
     if (!vga_initialized) {
         init_vga_interface(); 
         if (!vga_initialized) return; 
@@ -230,7 +259,7 @@ void fill_sky_and_grass(void) {
     // Draw sky tiles to the back buffer.
     for (r = 0; r < GRASS_ROW_START; ++r) { 
         for (c = 0; c < TILE_COLS; ++c) {
-            write_tile_to_kernel(r, c, SKY_TILE_IDX); 
+            write_tile_to_kernel(r, c, sky_layout[r][c]); 
         }
     }
     // Draw grass tiles randomly to the back buffer, considering the scroll.
@@ -259,97 +288,18 @@ void fill_sky_and_grass(void) {
             write_tile_to_kernel(r, c, grass_tile_to_use); 
         }
     }
+    // a run of palette writes instead of rewriting the sky tiles
+    vga_hardware_set_sky(sky);
 }
 
+void fill_sky_and_grass(void) {
+    fill_sky_tiles_and_grass(SKY_DAY);
+}
 
 void fill_nightsky_and_grass(void) {
-    if (!vga_initialized) {
-        init_vga_interface(); 
-        if (!vga_initialized) return; 
-    }
-  
-    int r, c;
-    unsigned char sky_tile_to_use;
-    unsigned char grass_tile_to_use;
-
-    // Draw sky tiles to the back buffer.
-    for (r = 0; r < GRASS_ROW_START; ++r) { 
-        for (c = 0; c < TILE_COLS; ++c) {
-           int rand_choice = rand() % 6;
-            sky_tile_to_use = (rand_choice == 0) ? NIGHTSKY_TILE_IDX : STAR_TILE_IDX;
-            write_tile_to_kernel(r, c, sky_tile_to_use);
-        }
-    }
-
-    // Draw grass tiles randomly to the back buffer, considering the scroll.
-    for (r = GRASS_ROW_START; r < TILE_ROWS; ++r) { 
-        for (c = 0; c < TILE_COLS; ++c) {
-            // Calculate the effective column in the "world" grass pattern
-            int pattern_col = (c + grass_current_tile_shift) % TILE_COLS;
-            if (pattern_col < 0) pattern_col += TILE_COLS; // Ensure positive for modulo-based pattern
-
-            // Choose grass tile type based on the scrolled pattern column and row
-            // This creates a diagonal-like repeating pattern that scrolls.
-            int rand_choice = (pattern_col + r) % 3; // Deterministic based on scrolled position
-
-            switch (rand_choice) {
-                case 0:
-                    grass_tile_to_use = GRASS_TILE_1_IDX;
-                    break;
-                case 1:
-                    grass_tile_to_use = GRASS_TILE_2_IDX;
-                    break;
-                case 2:
-                default: 
-                    grass_tile_to_use = GRASS_TILE_3_IDX;
-                    break;
-            }
-            write_tile_to_kernel(r, c, grass_tile_to_use); 
-        }
-    }
+    fill_sky_tiles_and_grass(SKY_NIGHT);
 }
 
 void fill_evesky_and_grass(void) {
-    if (!vga_initialized) {
-        init_vga_interface(); 
-        if (!vga_initialized) return; 
-    }
-  
-    int r, c;
-    unsigned char sky_tile_to_use;
-    unsigned char grass_tile_to_use;
-
-    // Draw sky tiles to the back buffer.
-    for (r = 0; r < GRASS_ROW_START; ++r) { 
-        for (c = 0; c < TILE_COLS; ++c) {
-          // int rand_choice = rand() % 6;
-            sky_tile_to_use = EVE_TILE_IDX;
-            write_tile_to_kernel(r, c, sky_tile_to_use);
-        }
-    }
-
-    // Draw grass tiles randomly to the back buffer, considering the scroll.
-    for (r = GRASS_ROW_START; r < TILE_ROWS; ++r) { 
-        for (c = 0; c < TILE_COLS; ++c) {
-            // Calculate the effective column in the "world" grass pattern
-            int pattern_col = (c + grass_current_tile_shift) % TILE_COLS;
-            if (pattern_col < 0) pattern_col += TILE_COLS; // Ensure positive for modulo-based pattern
-
-            int rand_choice = (pattern_col + r) % 3; // Deterministic based on scrolled position
-
-            switch (rand_choice) {
-                case 0:
-                    grass_tile_to_use = GRASS_TILE_1_IDX;
-                    break;
-                case 1:
-                    grass_tile_to_use = GRASS_TILE_2_IDX;
-                    break;
-                case 2:
-                default: 
-                    grass_tile_to_use = GRASS_TILE_3_IDX;
-                    break;
-            }
-            write_tile_to_kernel(r, c, grass_tile_to_use); 
-        }
-    }
+    fill_sky_tiles_and_grass(SKY_EVENING);
 }
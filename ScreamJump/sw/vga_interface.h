@@ -51,6 +51,10 @@ void cleartiles();
 void clearSprites_buffered();
 
 
+// The sky is drawn with SKY_TILE_IDX and STAR_TILE_IDX only, in palette
+// entries that are rewritten for day, evening and night (sky_palette.h).
+// pack_art takes the evening and night colours from EVE_TILE_IDX and
+// NIGHTSKY_TILE_IDX.
 #define SKY_TILE_IDX 37  
 #define NIGHTSKY_TILE_IDX 0  
 #define STAR_TILE_IDX 44 
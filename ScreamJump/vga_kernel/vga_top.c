@@ -20,6 +20,7 @@
 /* Device registers */
 #define WRITE_TILE(x) (x)
 #define WRITE_SPRITE(x) (x+4) // it's byte addressed
+#define WRITE_PALETTE(x) (x+17*4)
 
 /*
  * Information about our device
@@ -53,6 +54,12 @@ static void write_sprite(unsigned char active, unsigned short r, unsigned short
 				((unsigned int) (n & n_mask)), WRITE_SPRITE(dev.virtbase + register_n*4)); // byte addressed
 }
 
+static void write_palette(unsigned char entry, unsigned short colour)
+{
+	// 8bit entry, 16bit colour
+	iowrite32(((unsigned int) entry << 16) + colour, WRITE_PALETTE(dev.virtbase));
+}
+
 /*
  * Handle ioctl() calls from userspace:
  * Read or write the segments on single digits.
@@ -62,6 +69,9 @@ static long vga_top_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
   vga_top_arg_t vlat;
   vga_top_arg_s vlas;
+  vga_top_arg_palette vlap;
+  unsigned short *colours;
+  unsigned int i;
 	switch (cmd) {
 	  case VGA_TOP_WRITE_TILE:
 		  if (copy_from_user(&vlat, (vga_top_arg_t *) arg, sizeof(vga_top_arg_t)))
@@ -74,6 +84,19 @@ static long vga_top_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 			  return -EACCES;
 		  write_sprite(vlas.active, vlas.r, vlas.c, vlas.n, vlas.register_n);
 		  break;
+	  case VGA_TOP_WRITE_PALETTE:
+		  if (copy_from_user(&vlap, (vga_top_arg_palette *) arg, sizeof(vga_top_arg_palette)))
+			  return -EACCES;
+		  if (vlap.count == 0 || vlap.first >= VGA_PALETTE_SIZE ||
+		      vlap.count > VGA_PALETTE_SIZE - vlap.first)
+			  return -EINVAL;
+		  colours = memdup_user(vlap.colours, vlap.count * sizeof(unsigned short));
+		  if (IS_ERR(colours))
+			  return PTR_ERR(colours);
+		  for (i = 0; i < vlap.count; i++)
+			  write_palette(vlap.first + i, colours[i]);
+		  kfree(colours);
+		  break;
 	  default:
 		  return -EINVAL;
 	}
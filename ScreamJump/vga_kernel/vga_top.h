@@ -19,11 +19,26 @@ typedef struct {
   unsigned short register_n; // the corresponding sprite register, start from 0
 } vga_top_arg_s;
 
+// tiles and sprites are drawn with 8-bit indices into a palette of
+// VGA_RGB colours; the hardware loads it from palette.mif at reset
+#define VGA_PALETTE_SIZE 256 // entry 0 is a transparent sprite pixel
+#define VGA_RGB(r, g, b) \
+  ((((unsigned short) (r) & 0x1f) << 11) | (((unsigned short) (g) & 0x1f) << 6) | \
+   (((unsigned short) (b) & 0x1f) << 1)) // 5 bits each
+
+// def of argument for a run of palette entries
+typedef struct {
+  unsigned short *colours; // user pointer to count VGA_RGB values
+  unsigned int first;      // entry colours[0] goes to
+  unsigned int count;      // first + count at most VGA_PALETTE_SIZE
+} vga_top_arg_palette;
+
 
 #define VGA_TOP_MAGIC 'q'
 
 /* ioctls and their arguments */
 #define VGA_TOP_WRITE_TILE _IOW(VGA_TOP_MAGIC, 1, vga_top_arg_t *)
 #define VGA_TOP_WRITE_SPRITE _IOW(VGA_TOP_MAGIC, 2, vga_top_arg_s *)
+#define VGA_TOP_WRITE_PALETTE _IOW(VGA_TOP_MAGIC, 3, vga_top_arg_palette *) // shows from the next pixel
 
 #endif